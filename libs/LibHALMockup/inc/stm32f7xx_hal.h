@@ -69,6 +69,28 @@
 
 #define __HAL_TIM_ENABLE(__HANDLE__)                 ((__HANDLE__)->Instance->CR1|=(1))
 
+#define TIM_IT_UPDATE                      0x00000001U                          /*!< Update interrupt            */
+#define TIM_EGR_UG                         0x00000001U                          /*!< Update generation           */
+#define TIM_SR_UIF                         0x00000001U                          /*!< Update interrupt flag       */
+#define TIM_CR1_ARPE                       0x00000080U                          /*!< Auto-reload preload enable  */
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __INTERRUPT__)    ((__HANDLE__)->Instance->DIER |= (__INTERRUPT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __INTERRUPT__)   ((__HANDLE__)->Instance->DIER &= ~(__INTERRUPT__))
+
+/**
+  * @brief  Set the TIM Capture Compare Register value on runtime without calling another time ConfigChannel function.
+  * @param  __HANDLE__ TIM handle.
+  * @param  __CHANNEL__ TIM Channels to be configured.
+  * @param  __COMPARE__ specifies the Capture Compare register new value.
+  * @retval None
+  */
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__) \
+  (((__CHANNEL__) == TIM_CHANNEL_1) ? ((__HANDLE__)->Instance->CCR1 = (__COMPARE__)) :\
+   ((__CHANNEL__) == TIM_CHANNEL_2) ? ((__HANDLE__)->Instance->CCR2 = (__COMPARE__)) :\
+   ((__CHANNEL__) == TIM_CHANNEL_3) ? ((__HANDLE__)->Instance->CCR3 = (__COMPARE__)) :\
+   ((__CHANNEL__) == TIM_CHANNEL_4) ? ((__HANDLE__)->Instance->CCR4 = (__COMPARE__)) :\
+   ((__CHANNEL__) == TIM_CHANNEL_5) ? ((__HANDLE__)->Instance->CCR5 = (__COMPARE__)) :\
+   ((__HANDLE__)->Instance->CCR6 = (__COMPARE__)))
+
 /**
   * @brief  HAL Status structures definition
   */
@@ -581,6 +603,12 @@ HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef* htim, uint32_t Channel);
 HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef* htim, const TIM_OC_InitTypeDef* sConfig, uint32_t Channel);
 HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef* htim);
 
+/* first order motor model of the spindle, which is driven by the enable pins and the PWM compare values of TIM2
+ * channel 3 (backward) and channel 4 (forward). The speed is updated on every call from the elapsed time. */
+float HAL_MOCKUP_GetSpindleRPM(void);
+/* load of the spindle between 0 (no load) and 1 (full load), which lowers the speed for a given duty cycle */
+void HAL_MOCKUP_SetSpindleLoad(float load);
+
 #endif /* STM32F7XX_HAL_H_ */
 
 
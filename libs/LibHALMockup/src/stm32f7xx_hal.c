@@ -1,6 +1,7 @@
 #include "stm32f7xx_hal.h"
 #include "main.h"
 #include "Windows.h"
+#include <math.h>
 
 // USE THIS DEFINE TO DISABLE THE GATING SIMULATION AND INSTEAD USE
 // THE PWM IRQS OF THE PWM GENERATOR DIRECTLY!!!
@@ -206,6 +207,23 @@ static uint8_t ExecDriverProcessorSPI(uint8_t input);
 static uint8_t directionForward = 1;
 static int32_t internalPosition = 0;
 
+// speed at full duty cycle without load, the mechanical time constant and the relative speed loss at full load
+#define SPINDLE_MODEL_NO_LOAD_RPM  9500.0f
+#define SPINDLE_MODEL_TAU_MS        250.0f
+#define SPINDLE_MODEL_LOAD_DROOP      0.3f
+// the spindle does not turn below the deadband duty cycle and the speed rises with an exponent above it,
+// like the real spindle, so the calibration of the LibSpindle has something to correct
+#define SPINDLE_MODEL_DEADBAND        0.12f
+#define SPINDLE_MODEL_CURVE           0.8f
+
+// --------------------------------------------------------------------------------------------------------------------
+static struct
+{
+	float     rpm;
+	float     load;
+	ULONGLONG lastUpdate;
+} spindleModel;
+
 
 // --------------------------------------------------------------------------------------------------------------------
 GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
@@ -619,6 +637,43 @@ HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef* htim)
 	return HAL_OK;
 }
 
+// --------------------------------------------------------------------------------------------------------------------
+float HAL_MOCKUP_GetSpindleRPM(void)
+// --------------------------------------------------------------------------------------------------------------------
+{
+	ULONGLONG now = GetTickCount64();
+	float dt = (spindleModel.lastUpdate == 0) ? 0.0f : (float)(now - spindleModel.lastUpdate);
+	spindleModel.lastUpdate = now;
+	if (dt > 1000.0f) dt = 1000.0f;
+
+	// both half bridges must be enabled, the forward channel counts positive and the backward channel negative
+	float duty = 0.0f;
+	if (myConfig.pins.spindle_ena_b && myConfig.pins.spindle_ena_f)
+	{
+		float period = (TIM2->ARR != 0) ? (float)(TIM2->ARR + 1) : 4500.0f;
+		duty = ((float)TIM2->CCR4 - (float)TIM2->CCR3) / period;
+		if (duty > 1.0f) duty = 1.0f;
+		if (duty < -1.0f) duty = -1.0f;
+	}
+
+	float drive = (fabsf(duty) - SPINDLE_MODEL_DEADBAND) / (1.0f - SPINDLE_MODEL_DEADBAND);
+	drive = (drive > 0.0f) ? powf(drive, SPINDLE_MODEL_CURVE) : 0.0f;
+	if (duty < 0.0f) drive = -drive;
+
+	float target = drive * SPINDLE_MODEL_NO_LOAD_RPM * (1.0f - SPINDLE_MODEL_LOAD_DROOP * spindleModel.load);
+	spindleModel.rpm += (target - spindleModel.rpm) * (1.0f - expf(-dt / SPINDLE_MODEL_TAU_MS));
+	return spindleModel.rpm;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+void HAL_MOCKUP_SetSpindleLoad(float load)
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if (load < 0.0f) load = 0.0f;
+	if (load > 1.0f) load = 1.0f;
+	spindleModel.load = load;
+}
+
 
 // --------------------------------------------------------------------------------------------------------------------
 static uint8_t ExecDriverProcessorSPI(uint8_t input)
@@ -543,8 +543,34 @@ typedef struct
  */
 L6474_Handle_t L6474_CreateInstance(L6474x_Platform_t* p, void* pIO, void* pGPO, void* pPWM);
 
+/*!
+ * number of pointer sized words which are reserved by L6474_StaticHandle_t. The library fails to compile when its
+ * handle does not fit into it
+ */
+#define LIBL6474_STATIC_HANDLE_WORDS 24
+
+/*!
+ * The L6474_StaticHandle_t structure is the caller provided storage of a handle which is created by L6474_CreateStatic.
+ * Its content is private to the library.
+ */
+typedef struct L6474_StaticHandle
+{
+	void* reserved[LIBL6474_STATIC_HANDLE_WORDS];
+} L6474_StaticHandle_t;
+
+/*!
+ * L6474_CreateStatic is used like L6474_CreateInstance, but the handle is placed in the given storage instead of being
+ * allocated by the malloc function of the platform. The malloc and free function pointers are not required therefore.
+ * The storage must stay valid until L6474_DestroyInstance has been called.
+ *
+ * In case it fails, a null pointer is returned. In case it was successful, a handle pointer is returned which points
+ * into the storage
+ */
+L6474_Handle_t L6474_CreateStatic(L6474x_Platform_t* p, void* pIO, void* pGPO, void* pPWM, L6474_StaticHandle_t* storage);
+
 /*!
  * L6474_DestroyInstance is used to destroy a library instance which has been previously created by a call to L6474_CreateInstance
+ * or L6474_CreateStatic. The storage of a static instance is not released.
  *
  * The function returns errcNONE in case no error happens or any other error code from L6474x_ErrorCode_t enum
  * in case of an error
@@ -151,6 +151,7 @@ struct L6474_Handle
 	void*             pIO;
 	void*             pGPO;
 	void*             pPWM;
+	int               isStatic;
 	L6474x_Platform_t platform;
 };
 
@@ -437,13 +438,17 @@ static int L6474_DisableCommand(L6474_Handle_t h)
 
 
 // --------------------------------------------------------------------------------------------------------------------
-L6474_Handle_t L6474_CreateInstance(L6474x_Platform_t* p, void* pIO, void* pGPO, void* pPWM)
+static int L6474_HelperCheckPlatform(L6474x_Platform_t* p, int needsHeap)
 // --------------------------------------------------------------------------------------------------------------------
 {
 	if ( p == 0 )
 		return 0;
 
-	if ( ( p->reset == 0 ) || ( p->malloc == 0 ) || (p->free == 0) || (p->sleep == 0) || ( p->transfer == 0 ) )
+	// a static instance never allocates or releases memory, so it does not need malloc and free
+	if ( needsHeap && ( ( p->malloc == 0 ) || (p->free == 0) ) )
+		return 0;
+
+	if ( ( p->reset == 0 ) || (p->sleep == 0) || ( p->transfer == 0 ) )
 		return 0;
 
 #if defined(LIBL6474_HAS_LOCKING) && LIBL6474_HAS_LOCKING == 1
@@ -464,10 +469,14 @@ L6474_Handle_t L6474_CreateInstance(L6474x_Platform_t* p, void* pIO, void* pGPO,
 		return 0;
 #endif
 
-	L6474_Handle_t h = p->malloc(sizeof(struct L6474_Handle));
-	if ( h == 0 )
-		return 0;
+	return 1;
+}
 
+
+// --------------------------------------------------------------------------------------------------------------------
+static L6474_Handle_t L6474_HelperInitInstance(L6474_Handle_t h, L6474x_Platform_t* p, void* pIO, void* pGPO, void* pPWM)
+// --------------------------------------------------------------------------------------------------------------------
+{
 	h->pGPO                = pGPO;
 	h->pIO                 = pIO;
 	h->pPWM                = pPWM;
@@ -492,6 +501,39 @@ L6474_Handle_t L6474_CreateInstance(L6474x_Platform_t* p, void* pIO, void* pGPO,
 }
 
 
+// --------------------------------------------------------------------------------------------------------------------
+L6474_Handle_t L6474_CreateInstance(L6474x_Platform_t* p, void* pIO, void* pGPO, void* pPWM)
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( !L6474_HelperCheckPlatform(p, 1) )
+		return 0;
+
+	L6474_Handle_t h = p->malloc(sizeof(struct L6474_Handle));
+	if ( h == 0 )
+		return 0;
+
+	h->isStatic = 0;
+	return L6474_HelperInitInstance(h, p, pIO, pGPO, pPWM);
+}
+
+
+// --------------------------------------------------------------------------------------------------------------------
+L6474_Handle_t L6474_CreateStatic(L6474x_Platform_t* p, void* pIO, void* pGPO, void* pPWM, L6474_StaticHandle_t* storage)
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// fails to compile when LIBL6474_STATIC_HANDLE_WORDS is too small for the handle of the current configuration
+	typedef char L6474_StaticHandleCheck_t[ ( sizeof(struct L6474_Handle) <= sizeof(L6474_StaticHandle_t) ) ? 1 : -1 ];
+	(void)sizeof(L6474_StaticHandleCheck_t);
+
+	if ( storage == 0 || !L6474_HelperCheckPlatform(p, 0) )
+		return 0;
+
+	L6474_Handle_t h = (L6474_Handle_t)storage;
+	h->isStatic = 1;
+	return L6474_HelperInitInstance(h, p, pIO, pGPO, pPWM);
+}
+
+
 // --------------------------------------------------------------------------------------------------------------------
 int L6474_DestroyInstance(L6474_Handle_t h)
 // --------------------------------------------------------------------------------------------------------------------
@@ -506,7 +548,8 @@ int L6474_DestroyInstance(L6474_Handle_t h)
 #if defined(LIBL6474_HAS_LOCKING) && LIBL6474_HAS_LOCKING == 1
 	void  (*pUnlock)(void) = h->platform->unlock;
 #endif
-	h->platform.free(h);
+	if ( !h->isStatic )
+		h->platform.free(h);
 
 #if defined(LIBL6474_HAS_LOCKING) && LIBL6474_HAS_LOCKING == 1
 	if ( pUnlock != 0 )
@@ -809,6 +809,33 @@ static void instance_creation_and_destruction(void** state)
     s->h = NULL;
 }
 
+// test case
+// --------------------------------------------------------------------------------------------------------------------
+static void null_test_static_instance_creation_storage(void** state)
+// --------------------------------------------------------------------------------------------------------------------
+{
+    struct myState* s = ((struct myState*)*state);
+    assert_null((s->h = L6474_CreateStatic(&s->p, s->pIoCtx, s->pGpoCtx, s->pPwmCtx, NULL)));
+    assert_null((s->h = L6474_CreateStatic(NULL, s->pIoCtx, s->pGpoCtx, s->pPwmCtx, NULL)));
+}
+
+// test case
+// --------------------------------------------------------------------------------------------------------------------
+static void static_instance_creation_and_destruction(void** state)
+// --------------------------------------------------------------------------------------------------------------------
+{
+    static L6474_StaticHandle_t storage;
+    struct myState* s = ((struct myState*)*state);
+
+    // a static instance must neither allocate nor release memory
+    s->p.malloc = NULL;
+    s->p.free = NULL;
+    assert_non_null((s->h = L6474_CreateStatic(&s->p, s->pIoCtx, s->pGpoCtx, s->pPwmCtx, &storage)));
+    assert_ptr_equal(s->h, &storage);
+    assert_int_equal(L6474_DestroyInstance(s->h), errcNONE);
+    s->h = NULL;
+}
+
 // test case
 // --------------------------------------------------------------------------------------------------------------------
 static void instance_status_state_test(void** t_state)
@@ -1291,6 +1318,8 @@ const struct CMUnitTest creation_an_destruction_tests[] = {
     cmocka_unit_test_setup_teardown(non_null_test_instance_creation_successful_3, myStartFixtureFunction1, myStopFixtureFunction1),
     cmocka_unit_test_setup_teardown(non_null_test_instance_creation_successful_4, myStartFixtureFunction1, myStopFixtureFunction1),
     cmocka_unit_test_setup_teardown(instance_creation_and_destruction,            myStartFixtureFunction1, myStopFixtureFunction1),
+    cmocka_unit_test_setup_teardown(null_test_static_instance_creation_storage,   myStartFixtureFunction1, myStopFixtureFunction1),
+    cmocka_unit_test_setup_teardown(static_instance_creation_and_destruction,     myStartFixtureFunction1, myStopFixtureFunction1),
 };
 
 // library tests with predefined instance
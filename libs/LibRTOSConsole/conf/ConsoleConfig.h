@@ -46,5 +46,45 @@
  */
 #define CONSOLE_HELP_MAX_LENGTH 512
 
+/*!
+ * Specifies the number of worker tasks which execute background jobs
+ */
+#define CONSOLE_JOB_WORKERS 2
+
+/*!
+ * Specifies the maximum number of queued, running or unreported background jobs
+ */
+#define CONSOLE_JOB_MAX 4
+
+/*!
+ * Specifies the stack depth of a job worker in words, 0 uses the stack depth of the console processor
+ */
+#define CONSOLE_JOB_STACK_DEPTH 0
+
+/*!
+ * Specifies how long an idle job worker waits for a job in milliseconds before it checks again whether the instance
+ * is destroyed. The default is 100, a larger value lets tickless idle sleep longer but delays the end of the workers
+ */
+#define CONSOLE_JOB_POLL_MS 100
+
+/*!
+ * Specifies the number of chars CONSOLE_Printf collects on the stack of the caller before it writes them to stdout
+ */
+#define CONSOLE_PRINTF_CHUNK 64
+
+/*!
+ * The handle, the command entries and the completion nodes are allocated and released with these, so the user
+ * project can route them to its own allocator. The default is malloc and free
+ */
+#define CONSOLE_MALLOC(size) malloc(size)
+#define CONSOLE_FREE(ptr) free(ptr)
+
+/*!
+ * Called before and after a command function runs, e.g. to feed an event trace of the user project. cmd is the name
+ * of the command and result its return value. The default is empty
+ */
+#define CONSOLE_TRACE_BEGIN(cmd)
+#define CONSOLE_TRACE_END(result)
+
 
 #endif /* INC_CONSOLE_CONSOLECONFIG_H_ */
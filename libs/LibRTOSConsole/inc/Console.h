@@ -10,6 +10,10 @@
 #ifndef INC_CONSOLE_CONSOLE_H_
 #define INC_CONSOLE_CONSOLE_H_
 
+#include <stdio.h>
+#include "FreeRTOS.h"
+#include "ConsoleFormat.h"
+
 /*!
  * The ConsoleHandle_t handle is an instance pointer of the console library which is generated whenever
  * the CONSOLE_CreateInstance function returns with success.
@@ -45,11 +49,27 @@ typedef int (*ConsoleReadStream_t)(void* pContext, char* pBuffer, int num);
  */
 typedef int (*ConsoleWriteStream_t)(void* pContext, const char* pBuffer, int num);
 
+/*!
+ * The CONSOLE_IsLongRunningFunc function pointer type is used by commands which are registered as job commands.
+ * It gets the same arguments as the command itself and returns a non zero value when this call has to be executed
+ * as background job on a worker task. When zero is returned, the command is executed by the console processor
+ * directly, like any other command.
+ */
+typedef int (*CONSOLE_IsLongRunningFunc)(int argc, char** argv, void* context);
+
+/*!
+ * The CONSOLE_CancelFunc function pointer type is used to cancel a running background job. It is called by the
+ * console processor when the user kills the job and must make sure that the running command function returns as
+ * soon as possible, e.g. by stopping a movement which is polled by the command function.
+ */
+typedef void (*CONSOLE_CancelFunc)(void* context);
+
 
 /*!
  * The CONSOLE_CreateInstance function is used to create the console processor. There is no singleton pattern implemented
- * for the console but as there is no stream abstraction for the console processor, it only makes sense to have one instance
- * at runtime!
+ * for the console. Every instance owns its own read and write stream, so several instances can serve different
+ * transports at the same time when the streams are redirected with CONSOLE_RedirectStreams. An instance without
+ * redirection uses stdin and stdout of the stdlib.
  *
  * The return value of a console function is a null pointer in case an error occured or a pointer of type ConsoleHandle_t.
  * 
@@ -60,6 +80,77 @@ typedef int (*ConsoleWriteStream_t)(void* pContext, const char* pBuffer, int num
  */
 ConsoleHandle_t CONSOLE_CreateInstance(  unsigned int uxStackDepth, int xPrio );
 
+#if defined(configSUPPORT_STATIC_ALLOCATION) && ( configSUPPORT_STATIC_ALLOCATION == 1 )
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "ConsoleConfig.h"
+
+/*!
+ * number of pointer sized words which are reserved for the private handle in ConsoleStaticBuffers_t. It is derived
+ * from the compile time parameters of ConsoleConfig.h, the library fails to compile when the handle does not fit
+ */
+#define CONSOLE_STATIC_HANDLE_WORDS ( ( ( CONSOLE_LINE_HISTORY + 4 ) * ( CONSOLE_LINE_SIZE + 8 ) + 64 ) / sizeof(void*) + \
+		CONSOLE_JOB_MAX * ( ( CONSOLE_LINE_SIZE + CONSOLE_COMMAND_MAX_LENGTH ) / sizeof(void*) + CONSOLE_LINE_SIZE / 3 + 24 ) + \
+		CONSOLE_JOB_WORKERS + 32 )
+
+/*!
+ * The ConsoleStaticBuffers_t structure holds all objects of a console instance which is created by CONSOLE_CreateStatic.
+ * It must stay valid as long as the instance exists, so it is mostly a static variable of the user project.
+ */
+typedef struct ConsoleStaticBuffers
+{
+	/*!
+	 * TCB of the console processor
+	 */
+	StaticTask_t      task;
+
+	/*!
+	 * stack of the console processor, it must hold uxStackDepth words
+	 */
+	StackType_t*      stack;
+
+	/*!
+	 * TCBs of the job workers
+	 */
+	StaticTask_t      workerTasks[CONSOLE_JOB_WORKERS];
+
+	/*!
+	 * stacks of the job workers, each must hold CONSOLE_JOB_STACK_DEPTH words or uxStackDepth words when it is 0
+	 */
+	StackType_t*      workerStacks[CONSOLE_JOB_WORKERS];
+
+	/*!
+	 * queue and queue storage of the background jobs
+	 */
+	StaticQueue_t     jobQueue;
+	void*             jobQueueStorage[CONSOLE_JOB_MAX];
+
+	/*!
+	 * lock guard of the command list
+	 */
+	StaticSemaphore_t lockGuard;
+
+	/*!
+	 * private handle of the library, which includes the line buffers and the history
+	 */
+	void*             handle[CONSOLE_STATIC_HANDLE_WORDS];
+} ConsoleStaticBuffers_t;
+
+/*!
+ * The CONSOLE_CreateStatic function creates a console processor like CONSOLE_CreateInstance, but the handle, the tasks,
+ * the job queue and the lock guard are placed in the given buffers instead of the heap. It is only available when
+ * configSUPPORT_STATIC_ALLOCATION is set. The registered commands are still allocated on registration.
+ *
+ * The return value is a null pointer when a buffer or a stack is missing or a pointer of type ConsoleHandle_t.
+ *
+ * @param uxStackDepth is the stack depth of the console processor thread in words
+ * @param xPrio is the console processor priority, see CONSOLE_CreateInstance
+ * @param buffers is the storage of the instance, the stacks must be set by the caller
+ */
+ConsoleHandle_t CONSOLE_CreateStatic( unsigned int uxStackDepth, int xPrio, ConsoleStaticBuffers_t* buffers );
+#endif
+
 /*!
  * The CONSOLE_DestroyInstance function is used to cleanup all used ressources which then stops the console processor.
  * This leads to the case that no console functionallity is provided in the design anymore
@@ -79,6 +170,43 @@ void CONSOLE_DestroyInstance( ConsoleHandle_t h );
  */
 int CONSOLE_RegisterCommand( ConsoleHandle_t h, char* cmd, char* help, CONSOLE_CommandFunc func, void* context );
 
+/*!
+ * The CONSOLE_RegisterJobCommand function is used to register custom commands which may run for a long time, like
+ * synchronous movements. When such a call is long running, it is passed to a pool of worker tasks and the console
+ * prints the job ID and is ready for the next command immediately. The jobs can be listed, awaited or cancelled with
+ * the built-in commands <<jobs>>, <<wait>> and <<kill>>. Output of a job is printed while the console processor
+ * keeps running, finished jobs are reported before the next prompt.
+ *
+ * @param h is of type ConsoleHandle_t which is created by a call of CONSOLE_CreateInstance
+ * @param cmd is of type char* which is the case sensitive name of the command
+ * @param help is of type char* which is the help text or description of the command when the user types help
+ * @param func is of type CONSOLE_CommandFunc which is the function pointer to the command
+ * @param isLongRunning is of type CONSOLE_IsLongRunningFunc which decides per call if a job is started. When NULL
+ * is passed, every call of the command is executed as job
+ * @param cancel is of type CONSOLE_CancelFunc which is called when a running job is killed, it may be NULL
+ * @param context is of type void* which is an optional data pointer which is passed to all functions when called
+ */
+int CONSOLE_RegisterJobCommand( ConsoleHandle_t h, char* cmd, char* help, CONSOLE_CommandFunc func,
+		CONSOLE_IsLongRunningFunc isLongRunning, CONSOLE_CancelFunc cancel, void* context );
+
+/*!
+ * The CONSOLE_IsJobCancelled function can be polled by a command function which runs as background job. It returns
+ * a non zero value when the user has killed the job. Called from any other task, it always returns 0.
+ *
+ * @param h is of type ConsoleHandle_t which is created by a call of CONSOLE_CreateInstance
+ */
+int CONSOLE_IsJobCancelled( ConsoleHandle_t h );
+
+/*!
+ * The CONSOLE_IsWorkerJobCancelled function is the same as CONSOLE_IsJobCancelled for the job which runs on the
+ * given worker task. A cancel function can use it to find out if the killed job is the one which owns a resource,
+ * because it is called by the console task and not by the worker of the job.
+ *
+ * @param h is of type ConsoleHandle_t which is created by a call of CONSOLE_CreateInstance
+ * @param worker is of type void* which is the TaskHandle_t of the worker task, NULL always returns 0
+ */
+int CONSOLE_IsWorkerJobCancelled( ConsoleHandle_t h, void* worker );
+
 /*!
  * The CONSOLE_RegisterAlias function is used to register custom commands which can be mapped to other commands
  * when the user enters the given alias command string. Arguments will not be passed from an alias command to
@@ -90,6 +218,18 @@ int CONSOLE_RegisterCommand( ConsoleHandle_t h, char* cmd, char* help, CONSOLE_C
  */
 int CONSOLE_RegisterAlias( ConsoleHandle_t h, char* cmd, char* aliasCmd );
 
+/*!
+ * The CONSOLE_RegisterSubcommand function is used to register a keyword which can follow a command as its first
+ * argument, like "move" in "stepper move". Keywords are only used for the TAB completion of the console processor,
+ * they are passed to the command as usual. The command must be registered before and when it is removed, its
+ * keywords are removed as well. In case of an error -1 is returned, otherwise 0
+ *
+ * @param h is of type ConsoleHandle_t which is created by a call of CONSOLE_CreateInstance
+ * @param cmd is of type char* which is the case sensitive name of the registered command or alias
+ * @param keyword is of type char* which is the case sensitive keyword without any spaces
+ */
+int CONSOLE_RegisterSubcommand( ConsoleHandle_t h, char* cmd, char* keyword );
+
 /*!
  * The CONSOLE_RemoveAliasOrCommand function is used to remove custom commands or alias entries which are mapped
  * in the console processor.
@@ -105,15 +245,34 @@ int CONSOLE_RemoveAliasOrCommand( ConsoleHandle_t h, char* cmd);
  * NULL, it will be set back to stdin respectively stdout. In case of an error, the
  * last stream configuration is kept and -1 is returned, otherwise 0
  *
+ * The redirection only affects the given instance: its console processor and its job workers read and
+ * write through the stream objects of the instance, all other tasks keep their own stdin and stdout.
+ * The function can be called from any task, the tasks of the instance pick up the change before they
+ * read the next char or start the next job.
+ *
  * @param h is of type ConsoleHandle_t which is created by a call of CONSOLE_CreateInstance
  * @param rdFunc is of type ConsoleReadStream_t which is the new stream read function for the command processor
  * @param wrFunc is of type ConsoleWriteStream_t which is the new stream write function for the command processor
+ * @param rdContext is of type void* which is passed to every call of rdFunc
+ * @param wrContext is of type void* which is passed to every call of wrFunc
  *
  * NOTE it might be that not on all platforms it is possible to use this function, it then returns -2 if it is
  * not implemented properly. So far only newlib stdlib is supported!
  */
 int CONSOLE_RedirectStreams( ConsoleHandle_t h, ConsoleReadStream_t rdFunc, ConsoleWriteStream_t wrFunc,
 		void* rdContext, void* wrContext );
+
+/*!
+ * The CONSOLE_OpenWriteStream function opens an own write stream object of the instance for a task which is not
+ * part of it, e.g. a task which streams data to the user who has started it by a command. The output follows
+ * CONSOLE_RedirectStreams like the output of a job. Every task needs its own stream object, it has to be closed
+ * with fclose before the instance is destroyed. It returns NULL when no stream object could be created
+ *
+ * @param h is of type ConsoleHandle_t which is created by a call of CONSOLE_CreateInstance
+ *
+ * NOTE as CONSOLE_RedirectStreams, this is only supported with the newlib stdlib so far, otherwise NULL is returned
+ */
+FILE* CONSOLE_OpenWriteStream( ConsoleHandle_t h );
 /*!
  * \mainpage FreeRTOS Console Library
  * \section intro_sec Introduction
@@ -132,6 +291,11 @@ int CONSOLE_RedirectStreams( ConsoleHandle_t h, ConsoleReadStream_t rdFunc, Cons
  * this line<br>
  * CONSOLE_COMMAND_MAX_LENGTH: Specifies the maximum number of chars per command<br>
  * CONSOLE_HELP_MAX_LENGTH: Specifies the maximum number of chars per command help text<br>
+ * CONSOLE_JOB_WORKERS: Specifies the number of worker tasks which execute background jobs<br>
+ * CONSOLE_JOB_MAX: Specifies the maximum number of queued, running or unreported background jobs<br>
+ * CONSOLE_JOB_STACK_DEPTH: Stack depth of a job worker in words, 0 uses the stack depth of the console processor<br>
+ * CONSOLE_JOB_POLL_MS: Longest time an idle job worker waits for a job before it checks for shutdown and redirected streams<br>
+ * CONSOLE_PRINTF_CHUNK: Number of chars CONSOLE_Printf collects on the stack of the caller before it writes them to stdout<br>
  * 
  * \section state_example Examples
  * The following example shows how to create a instance of the console library
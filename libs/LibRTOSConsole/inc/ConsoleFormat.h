@@ -0,0 +1,62 @@
+/*
+ * ConsoleFormat.h
+ *
+ *  Created on: Jan 30, 2026
+ *      Author: Basti
+ */
+
+ /*! \file */
+
+#ifndef INC_CONSOLE_CONSOLEFORMAT_H_
+#define INC_CONSOLE_CONSOLEFORMAT_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/*!
+ * The CONSOLE_Printf function is a small replacement of printf for command functions. It formats without any
+ * allocation and without the double based conversion of the stdlib, all state lives on the stack of the caller,
+ * so it can be called from any task at the same time. The output is collected in chunks of CONSOLE_PRINTF_CHUNK
+ * chars and each chunk is written to stdout of the calling task, so a redirection by CONSOLE_RedirectStreams
+ * applies as with printf. It returns the number of printed chars or -1 when stdout failed.
+ *
+ * Supported are the flags '-', '+', ' ', '#' and '0', width and precision (also as '*'), the length modifiers
+ * hh, h, l, ll, z, j and t and the conversions d, i, u, x, X, o, c, s, p, f and %. Numbers which fit into 32 bits
+ * are converted with 32 bit divisions only. f is printed as fixed point with at most 9 decimals, a value which is
+ * exact as float (every promoted float argument) is converted with integer arithmetic only. Values of 2^64 and
+ * above print as "ovf". e, E, g and G take their argument but print the conversion itself, e.g. "%.3e"
+ *
+ * @param format is of type const char* which is the format string as for printf
+ */
+int CONSOLE_Printf( const char* format, ... );
+
+/*!
+ * The CONSOLE_VPrintf function is the same as CONSOLE_Printf with an argument list
+ *
+ * @param format is of type const char* which is the format string as for printf
+ * @param args is of type va_list which holds the arguments of the format string
+ */
+int CONSOLE_VPrintf( const char* format, va_list args );
+
+/*!
+ * The CONSOLE_Snprintf function formats like CONSOLE_Printf into a buffer. As snprintf, the output is cut at
+ * size - 1 chars, always terminated when size is not zero and the number of chars of the whole output is
+ * returned
+ *
+ * @param buffer is of type char* which receives the output, it can be NULL when size is zero
+ * @param size is of type size_t which is the size of the buffer including the terminating zero
+ * @param format is of type const char* which is the format string as for printf
+ */
+int CONSOLE_Snprintf( char* buffer, size_t size, const char* format, ... );
+
+/*!
+ * The CONSOLE_VSnprintf function is the same as CONSOLE_Snprintf with an argument list
+ *
+ * @param buffer is of type char* which receives the output, it can be NULL when size is zero
+ * @param size is of type size_t which is the size of the buffer including the terminating zero
+ * @param format is of type const char* which is the format string as for printf
+ * @param args is of type va_list which holds the arguments of the format string
+ */
+int CONSOLE_VSnprintf( char* buffer, size_t size, const char* format, va_list args );
+
+#endif /* INC_CONSOLE_CONSOLEFORMAT_H_ */
@@ -0,0 +1,109 @@
+/*
+ * ConsoleLine.h
+ *
+ *  Created on: Feb 2, 2026
+ *      Author: Basti
+ */
+
+ /*! \file */
+
+#ifndef INC_CONSOLE_CONSOLELINE_H_
+#define INC_CONSOLE_CONSOLELINE_H_
+
+#include <stdio.h>
+#include "ConsoleConfig.h"
+
+/*
+ * The line editor and the tokenizer of the console processor. They do not depend on FreeRTOS, so they are built
+ * and measured by the host unit tests in test/UnitTests as well. The functions are internal to the library and not part of its API.
+ */
+
+#ifndef CONSOLE_LINE_SIZE
+#  define CONSOLE_LINE_SIZE 120
+#endif
+
+// one screen update holds the moved tail, the erase and the cursor movement of a single keystroke
+#define CONSOLE_REDRAW_SIZE ((2 * CONSOLE_LINE_SIZE) + 32)
+
+// every screen update goes through these, so the unit tests can count the bytes and the write calls
+#ifndef CONSOLE_REDRAW_WRITE
+#  define CONSOLE_REDRAW_WRITE(data, len) fwrite((data), 1, (len), stdout)
+#endif
+
+#ifndef CONSOLE_REDRAW_FLUSH
+#  define CONSOLE_REDRAW_FLUSH() fflush(stdout)
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+typedef struct
+// --------------------------------------------------------------------------------------------------------------------
+{
+	int           length;
+	char          buff[CONSOLE_REDRAW_SIZE];
+} redrawBuffer_t;
+
+/*!
+ * Appends data to the screen update, a full buffer is written in parts
+ */
+void ConsoleRedrawPut( redrawBuffer_t* r, const char* data, int len );
+
+/*!
+ * Moves the cursor by the given number of columns to the left ('D') or to the right ('C')
+ */
+void ConsoleRedrawCursor( redrawBuffer_t* r, int columns, char direction );
+
+/*!
+ * Passes the complete screen update of one keystroke to the stream with a single write
+ */
+void ConsoleRedrawFlush( redrawBuffer_t* r );
+
+/*!
+ * Inserts num chars at the cursor position lbPtr and moves the cursor behind them. The caller makes sure that the
+ * line has space for the new chars
+ */
+void ConsoleLineInsert( redrawBuffer_t* r, char* lineBuff, unsigned int* lbPtr, const char* chars, int num );
+
+/*!
+ * Removes the char below the cursor, which must be at the given position
+ */
+void ConsoleLineDelete( redrawBuffer_t* r, char* lineBuff, unsigned int pos );
+
+/*!
+ * Replaces the whole input by newLine, e.g. from the history, the cursor is placed at its end
+ */
+void ConsoleLineReplace( redrawBuffer_t* r, char* lineBuff, unsigned int* lbPtr, const char* newLine );
+
+/*!
+ * Starts a new console line with the decoded result of the last command
+ */
+void ConsolePrompt( redrawBuffer_t* r, const char* username, int result );
+
+// --------------------------------------------------------------------------------------------------------------------
+typedef struct cmdSlice
+// --------------------------------------------------------------------------------------------------------------------
+{
+	char* ptr;
+	int   len;
+} cmdSlice_t;
+
+/*!
+ * Splits the line in one pass into at most maxSlices slices, a quoted token is returned without its quotes.
+ * The separators are overwritten with terminators. Returns the number of slices or -1 if there are more
+ */
+int ConsoleTokenize( char* line, int lineSize, cmdSlice_t* slices, int maxSlices );
+
+/*!
+ * Joins the arguments of an alias into buff and quotes the ones with spaces, so ConsoleTokenize gives back the same
+ * arguments. Returns the length or -1 if buff of the given size is too small
+ */
+int ConsoleAliasQuote( char* buff, int size, int argc, char** argv );
+
+/*!
+ * Places the tokens of an alias, which start at the offsets into tokens, in front of the numArgs args. The result
+ * goes to expanded, which may be the array of args and must hold maxArgs + 1 pointers. Returns the number of
+ * arguments behind the command or -1 if there are more than maxArgs
+ */
+int ConsoleAliasSplice( char** expanded, int maxArgs, char* tokens, const unsigned char* offset, int aliasArgc,
+		char** args, int numArgs );
+
+#endif /* INC_CONSOLE_CONSOLELINE_H_ */
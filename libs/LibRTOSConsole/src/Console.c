@@ -10,6 +10,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "semphr.h"
+#include "queue.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,6 +25,7 @@
 #include "main.h"
 #include "Console.h"
 #include "ConsoleConfig.h"
+#include "ConsoleLine.h"
 
 
 #ifdef __arm__
@@ -55,6 +57,41 @@
 #  define CONSOLE_HELP_MAX_LENGTH 256
 #endif
 
+#ifndef CONSOLE_JOB_WORKERS
+#  define CONSOLE_JOB_WORKERS 2
+#endif
+
+#ifndef CONSOLE_JOB_MAX
+#  define CONSOLE_JOB_MAX 4
+#endif
+
+#ifndef CONSOLE_JOB_STACK_DEPTH
+#  define CONSOLE_JOB_STACK_DEPTH 0
+#endif
+
+#ifndef CONSOLE_JOB_POLL_MS
+#  define CONSOLE_JOB_POLL_MS 100
+#endif
+
+// the handle, the command entries and the completion nodes are allocated with these, so the user project can
+// route them to its own allocator
+#ifndef CONSOLE_MALLOC
+#  define CONSOLE_MALLOC(size) malloc(size)
+#endif
+
+#ifndef CONSOLE_FREE
+#  define CONSOLE_FREE(ptr) free(ptr)
+#endif
+
+// called before and after a command function runs, e.g. to feed an event trace of the user project
+#ifndef CONSOLE_TRACE_BEGIN
+#  define CONSOLE_TRACE_BEGIN(cmd)
+#endif
+
+#ifndef CONSOLE_TRACE_END
+#  define CONSOLE_TRACE_END(result)
+#endif
+
 #if CONSOLE_HELP_MAX_LENGTH < CONSOLE_LINE_SIZE
 #pragma error "the line size must not be larger than the help size, otherwise alias wont work anymore!"
 #endif
@@ -62,6 +99,12 @@
 #define CONSOLE_SAFETY_SPACE 4
 // always min of 4 commands plus line size/3 because argument '-x ' and space at least!
 #define CONSOLE_MAX_NUM_ARGS ((CONSOLE_LINE_SIZE / 3) + 4)
+// an alias mapping is limited to the command length, so there can be at most one token per two characters
+#define CONSOLE_ALIAS_MAX_ARGS ((CONSOLE_COMMAND_MAX_LENGTH / 2) + 1)
+// limits the number of nested alias expansions, so an alias which is mapped onto itself can not loop forever
+#define CONSOLE_ALIAS_MAX_DEPTH 8
+// the completion index holds command names and "<command> <keyword>" for the subcommand keywords
+#define CONSOLE_TRIE_MAX_KEY ((2 * CONSOLE_COMMAND_MAX_LENGTH) + 1)
 
 // --------------------------------------------------------------------------------------------------------------------
 typedef struct cmdEntry
@@ -76,19 +119,74 @@ typedef struct cmdEntry
 		char                help[CONSOLE_HELP_MAX_LENGTH + 2];
 		int                 helpLen;
 		int                 isAlias;
+		int                 isJob;
+		CONSOLE_IsLongRunningFunc isLongRunning;
+		CONSOLE_CancelFunc  cancel;
+		struct
+		{
+			char            tokens[CONSOLE_COMMAND_MAX_LENGTH + 2];
+			unsigned char   offset[CONSOLE_ALIAS_MAX_ARGS];
+			int             argc;
+		} alias;
 	} content;
 
     LIST_ENTRY(cmdEntry) navigate;
 } cmdEntry_t;
 
+// --------------------------------------------------------------------------------------------------------------------
+typedef struct cmdTrieNode
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// one node per char of a key, the keys are the command and alias names and "<command> <keyword>"
+	// for the registered subcommand keywords. The siblings are sorted by their char.
+	struct cmdTrieNode* child;
+	struct cmdTrieNode* sibling;
+	cmdEntry_t*         entry;
+	char                c;
+	unsigned char       keyword;
+} cmdTrieNode_t;
+
 // --------------------------------------------------------------------------------------------------------------------
 typedef struct cmdState
 // --------------------------------------------------------------------------------------------------------------------
 {
 	SemaphoreHandle_t             lockGuard;
 	LIST_HEAD(cmd_list, cmdEntry) commands;
+	cmdTrieNode_t*                trie;
 } cmdState_t;
 
+// --------------------------------------------------------------------------------------------------------------------
+typedef enum
+// --------------------------------------------------------------------------------------------------------------------
+{
+	jobFREE = 0,
+	jobQUEUED,
+	jobRUNNING,
+	jobDONE,
+	jobCANCELLED
+} jobState_t;
+
+// --------------------------------------------------------------------------------------------------------------------
+typedef struct consoleJob
+// --------------------------------------------------------------------------------------------------------------------
+{
+	int                 id;
+	volatile jobState_t state;
+	volatile int        cancel;
+	int                 result;
+	int                 reported;
+	CONSOLE_CommandFunc func;
+	CONSOLE_CancelFunc  cancelFunc;
+	void*               ctx;
+	TaskHandle_t        worker;
+	TaskHandle_t        waiter;
+	char*               cmd;
+	int                 argc;
+	char*               argv[CONSOLE_MAX_NUM_ARGS + 1];
+	// the command and its arguments are copied, because the line buffer is reused by the console processor
+	char                line[CONSOLE_LINE_SIZE + CONSOLE_COMMAND_MAX_LENGTH + CONSOLE_SAFETY_SPACE];
+} consoleJob_t;
+
 // --------------------------------------------------------------------------------------------------------------------
 typedef enum
 // --------------------------------------------------------------------------------------------------------------------
@@ -177,6 +275,13 @@ struct ConsoleHandle
 	cspState_t        pState;
 	TaskHandle_t      tHandle;
 	int               cancel;
+	int               isStatic;
+	struct
+	{
+		// make sure we have a little space behind
+		char          ctrl[CONSOLE_LINE_SIZE + CONSOLE_SAFETY_SPACE];
+		char          line[CONSOLE_LINE_SIZE + CONSOLE_SAFETY_SPACE];
+	} buffers;
 	struct
 	{
 		char          lines[CONSOLE_LINE_HISTORY][CONSOLE_LINE_SIZE+CONSOLE_SAFETY_SPACE];
@@ -184,11 +289,28 @@ struct ConsoleHandle
 		int           linePtr;
 	} history;
 
-	int                  pendingRedirect;
-	ConsoleReadStream_t  pendingRdStream;
-	ConsoleWriteStream_t pendingWrStream;
-	void*                pendingRdCtx;
-	void*                pendingWrCtx;
+	redrawBuffer_t    redraw;
+
+	struct
+	{
+		consoleJob_t  slots[CONSOLE_JOB_MAX];
+		QueueHandle_t queue;
+		TaskHandle_t  workers[CONSOLE_JOB_WORKERS];
+		int           alive;
+		int           nextId;
+	} jobs;
+
+	struct
+	{
+		ConsoleReadStream_t  rdFunc;
+		ConsoleWriteStream_t wrFunc;
+		void*                rdCtx;
+		void*                wrCtx;
+		FILE*                in;
+		FILE*                out;
+		FILE*                fallback;
+		volatile int         generation;
+	} streams;
 };
 
 #ifdef WIN32
@@ -336,199 +458,260 @@ cspTYPE ControlSequenceParserConsume( char input, cspState_t* s )
 }
 
 // --------------------------------------------------------------------------------------------------------------------
-static int ProcessCommand(char* command, int cmdLen, char** args, int numArgs, cmdState_t* c, int* isAlias, char* inputBuffer, int inbuffsz)
+static cmdTrieNode_t* ConsoleTrieFind( cmdTrieNode_t* root, const char* key, int keyLen )
 // --------------------------------------------------------------------------------------------------------------------
 {
-	// here we have to look for a matching entry and therefore we have to search linearly through
-	// our linked list of command entries
-	xSemaphoreTakeRecursive( c->lockGuard, -1 );
-	cmdEntry_t* pElement = c->commands.lh_first;
-	int found = 0;
-	int result = 0;
-	while ( pElement != NULL )
+	// one step down per char of the key, on each level only the (sorted) siblings are compared
+	cmdTrieNode_t* node = NULL;
+	cmdTrieNode_t* level = root;
+	for ( int i = 0; i < keyLen; i++ )
 	{
-		// if string compare result and determined length match, then this must be the function
-		if ( strncmp(command, pElement->content.cmd, cmdLen) == 0 && cmdLen == pElement->content.cmdLen )
-		{
-			found = 1;
-			if ( pElement->content.isAlias )
-			{
-				*isAlias = 1;
-				// first we have to copy the arguments behind the command (as long as we have enough space)
-				int currentArg = 0;
-				int stillCopiedLength = 0;
-				char tempInBuff[CONSOLE_LINE_SIZE + 1];
-				char* tempArgs[CONSOLE_MAX_NUM_ARGS];
-				memset(tempArgs, 0, sizeof(tempArgs));
-				for (int i = 0; i < numArgs; i++)
-				{
-					tempArgs[i] = args[i] - inputBuffer + tempInBuff;
-				}
-				memcpy(tempInBuff, inputBuffer, inbuffsz);
-				while (numArgs > 0)
-				{
-					// all args are NULL-terminated so we can safely use strlen
-					int argCopyLen = strlen(tempArgs[currentArg]);
-					int additionalTermination = 0;
-					if (*(tempArgs[currentArg] - 1) == '"' || tempArgs[currentArg] == NULL)
-					{
-						additionalTermination = 1;
-					}
-					if ((argCopyLen + pElement->content.helpLen + stillCopiedLength + 1) > inbuffsz)
-					{
-						printf("\033[31mAlias Argument Substitution Overflow\033[0m");
-						result = -1;
-						*isAlias = 0;
-						return result;
-					}
-					if (additionalTermination)
-					{
-						inputBuffer[pElement->content.helpLen + stillCopiedLength + 1] = '"';
-						stillCopiedLength += 1;
-					}
-					memcpy(&inputBuffer[pElement->content.helpLen + stillCopiedLength + 1], tempArgs[currentArg], argCopyLen);
-					stillCopiedLength += argCopyLen;
-					if (additionalTermination)
-					{
-						inputBuffer[pElement->content.helpLen + stillCopiedLength + 1] = '"';
-						stillCopiedLength += 1;
-					}
-					inputBuffer[pElement->content.helpLen + stillCopiedLength + 1] = ' ';
-					stillCopiedLength += 1;
-					numArgs -= 1;
-					currentArg += 1;
-				}
+		while ( level != NULL && level->c < key[i] ) level = level->sibling;
+		if ( level == NULL || level->c != key[i] ) return NULL;
+		node = level;
+		level = node->child;
+	}
+	return node;
+}
 
-				memcpy(inputBuffer, pElement->content.help, pElement->content.helpLen);
-				memset(&inputBuffer[pElement->content.helpLen+ stillCopiedLength], 0, inbuffsz-(pElement->content.helpLen+stillCopiedLength));
-				if (currentArg != 0) inputBuffer[pElement->content.helpLen] = ' ';
-				result = 0;
-			}
-			else
-			{
-				result = pElement->content.func(numArgs, args, pElement->content.ctx);
-			}
-			break;
+// --------------------------------------------------------------------------------------------------------------------
+static void ConsoleTrieFree( cmdTrieNode_t* node )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// releases the node with all of its siblings and children. The children are moved in front of
+	// the remaining siblings while walking, so there is no recursion and no stack required.
+	while ( node != NULL )
+	{
+		if ( node->child != NULL )
+		{
+			cmdTrieNode_t* last = node->child;
+			while ( last->sibling != NULL ) last = last->sibling;
+			last->sibling = node->sibling;
+			node->sibling = node->child;
+			node->child = NULL;
 		}
+		cmdTrieNode_t* next = node->sibling;
+		CONSOLE_FREE(node);
+		node = next;
+	}
+}
 
-		pElement = pElement->navigate.le_next;
+// --------------------------------------------------------------------------------------------------------------------
+static void ConsoleTriePrune( cmdTrieNode_t** root, const char* key, int keyLen )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// removes the nodes of the key from the end towards the root as long as they are not used anymore
+	cmdTrieNode_t** links[CONSOLE_TRIE_MAX_KEY];
+	cmdTrieNode_t** link = root;
+	int depth = 0;
+	for ( ; depth < keyLen && depth < CONSOLE_TRIE_MAX_KEY; depth++ )
+	{
+		while ( *link != NULL && (*link)->c < key[depth] ) link = &(*link)->sibling;
+		if ( *link == NULL || (*link)->c != key[depth] ) break;
+		links[depth] = link;
+		link = &(*link)->child;
 	}
 
-	xSemaphoreGiveRecursive( c->lockGuard );
-	if ( found == 0 )
+	while ( depth > 0 )
 	{
-		printf("\033[31mInvalid command\033[0m");
-		fflush(stdout);
-		result = -1;
+		cmdTrieNode_t* node = *links[--depth];
+		if ( node->child != NULL || node->entry != NULL || node->keyword != 0 ) break;
+		*links[depth] = node->sibling;
+		CONSOLE_FREE(node);
 	}
-	return result;
 }
 
 // --------------------------------------------------------------------------------------------------------------------
-static int TransformAndProcessTheCommand(char* lineBuff, int line_size, cmdState_t* cState)
+static cmdTrieNode_t* ConsoleTrieInsert( cmdTrieNode_t** root, const char* key, int keyLen )
 // --------------------------------------------------------------------------------------------------------------------
 {
-	int startIdx;
-	int endIdx;
-	int numArgs;
-	int isAlias;
-
-	char* args[CONSOLE_MAX_NUM_ARGS];
-	char* command;
-	char* strtokNewIndex = NULL;
-
-restart:
-	startIdx = 0;
-	endIdx = CONSOLE_LINE_SIZE - 1;
-	numArgs = 0;
-	isAlias = 0;
-	command = NULL;
+	cmdTrieNode_t** link = root;
+	cmdTrieNode_t* node = NULL;
+	for ( int i = 0; i < keyLen; i++ )
+	{
+		while ( *link != NULL && (*link)->c < key[i] ) link = &(*link)->sibling;
+		if ( *link == NULL || (*link)->c != key[i] )
+		{
+			cmdTrieNode_t* item = CONSOLE_MALLOC(sizeof(cmdTrieNode_t));
+			if ( item == NULL )
+			{
+				// nodes which were added up to here are not used by anyone
+				ConsoleTriePrune(root, key, i);
+				return NULL;
+			}
+			memset(item, 0, sizeof(cmdTrieNode_t));
+			item->c = key[i];
+			item->sibling = *link;
+			*link = item;
+		}
+		node = *link;
+		link = &node->child;
+	}
+	return node;
+}
 
-	memset(args, 0, sizeof(args));
+// --------------------------------------------------------------------------------------------------------------------
+static cmdEntry_t* ConsoleFindEntry( cmdState_t* c, const char* cmd, int cmdLen )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the lookup costs one trie level per char of the command, independent of the number of entries
+	cmdTrieNode_t* node = ConsoleTrieFind(c->trie, cmd, cmdLen);
+	return ( node != NULL ) ? node->entry : NULL;
+}
 
-	if ( lineBuff[startIdx] == '\0' ) return 0;
+// --------------------------------------------------------------------------------------------------------------------
+static int ConsoleSubmitJob( ConsoleHandle_t h, cmdEntry_t* e, char* command, int numArgs, char** args )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	consoleJob_t* job = NULL;
 
-	while(startIdx < line_size)
+	taskENTER_CRITICAL();
+	for ( int i = 0; i < CONSOLE_JOB_MAX; i++ )
 	{
-		if ( lineBuff[startIdx] != ' ' ) break;
-		startIdx += 1;
+		// finished jobs are only reused after the user has seen the result
+		consoleJob_t* j = &h->jobs.slots[i];
+		if ( j->state == jobFREE || ( ( j->state == jobDONE || j->state == jobCANCELLED ) && j->reported ) )
+		{
+			job = j;
+			job->state = jobQUEUED;
+			break;
+		}
 	}
+	taskEXIT_CRITICAL();
 
-	while(endIdx > 0)
+	if ( job == NULL )
 	{
-		if ( lineBuff[endIdx] != '\0' && lineBuff[endIdx] != ' ' ) break;
-		endIdx -= 1;
+		printf("\033[31mToo many jobs, wait until a job has finished\033[0m");
+		return -1;
 	}
 
-	if ( startIdx <= endIdx )
+	// pack the command and all arguments into the line of the job, every string keeps its terminator
+	int ptr = 0;
+	int cmdLen = (int)strlen(command);
+	if ( cmdLen + 1 > (int)sizeof(job->line) ) goto overflow;
+	memcpy(&job->line[ptr], command, cmdLen + 1);
+	job->cmd = &job->line[ptr];
+	ptr += cmdLen + 1;
+	for ( int i = 0; i < numArgs; i++ )
+	{
+		int argLen = (int)strlen(args[i]);
+		if ( ptr + argLen + 1 > (int)sizeof(job->line) ) goto overflow;
+		memcpy(&job->line[ptr], args[i], argLen + 1);
+		job->argv[i] = &job->line[ptr];
+		ptr += argLen + 1;
+	}
+	job->argv[numArgs] = NULL;
+	job->argc       = numArgs;
+	job->func       = e->content.func;
+	job->cancelFunc = e->content.cancel;
+	job->ctx        = e->content.ctx;
+	job->cancel     = 0;
+	job->result     = 0;
+	job->reported   = 0;
+	job->worker     = NULL;
+	job->waiter     = NULL;
+	job->id         = h->jobs.nextId++;
+
+	if ( xQueueSend(h->jobs.queue, &job, 0) != pdPASS )
 	{
-		// strtok is safe because we have a nulled safety margin behind the string
-		command = strtok(&lineBuff[startIdx], " ");
+		job->state = jobFREE;
+		printf("\033[31mJob queue is full\033[0m");
+		return -1;
+	}
 
-		// some sanity checks before tokenizing
-		if ( command == NULL ) return 0;
-		if ((int)strnlen(command, line_size) == 0 ) return 0;
+	printf("[%d] %s", job->id, job->cmd);
+	return 0;
 
-		int cmdLength = (int)strnlen(command, line_size);
+overflow:
+	job->state = jobFREE;
+	printf("\033[31mJob arguments are too long\033[0m");
+	return -1;
+}
 
-		// now get the arguments
-		while((args[numArgs] = strtok(strtokNewIndex, " ")) != NULL && numArgs < CONSOLE_MAX_NUM_ARGS)
+// --------------------------------------------------------------------------------------------------------------------
+static int ProcessCommand(ConsoleHandle_t h, char* command, int cmdLen, char** args, int numArgs)
+// --------------------------------------------------------------------------------------------------------------------
+{
+	cmdState_t* c = &h->cState;
+	char* expandedArgs[CONSOLE_MAX_NUM_ARGS + 1];
+	int depth = 0;
+	int result = -1;
+
+	xSemaphoreTakeRecursive( c->lockGuard, -1 );
+	cmdEntry_t* pElement = ConsoleFindEntry(c, command, cmdLen);
+
+	// an alias is stored pre-tokenized, so the expansion is only a splice of the alias slices in front of
+	// the arguments the user has passed. The first alias slice is the command which has to be looked up next
+	while ( pElement != NULL && pElement->content.isAlias )
+	{
+		depth += 1;
+		int expanded = ( depth > CONSOLE_ALIAS_MAX_DEPTH ) ? -1 : ConsoleAliasSplice(expandedArgs, CONSOLE_MAX_NUM_ARGS,
+				pElement->content.alias.tokens, pElement->content.alias.offset, pElement->content.alias.argc, args, numArgs);
+		if ( expanded < 0 )
 		{
-			strtokNewIndex = NULL;
-			if (args[numArgs][0] == '"')
-			{
-				// move the argument to remove the quotes
-				args[numArgs] += 1;
-				if (args[numArgs][0] == '"') {
-					args[numArgs][0] = '\0';
-					// we have to add a plus 2 because there is the '"' char and '\0' from strtok as second
-					// char. So we need to add 2 chars to get to the next valid char or the end of the string
-					strtokNewIndex = &args[numArgs][2];
-				}
-				else
-				{
-					// now look for the end of the argument and set new strtok index to this
-					// string part
-					int firstLen = strlen(args[numArgs]);
-					args[numArgs][firstLen] = ' ';
-					char* endChar = &args[numArgs][firstLen-1];
-					// while loop is safe because we have a nulled safety margin behind the string
-					while (*endChar != '\0' && *endChar != '"') endChar += 1;
-					if (*endChar == '"') {
-						*endChar = '\0'; endChar += 1;
-					}
-					strtokNewIndex = endChar;
-				}
-			}
-			numArgs+=1;
+			xSemaphoreGiveRecursive( c->lockGuard );
+			printf("\033[31mAlias Argument Substitution Overflow\033[0m");
+			return -1;
 		}
+		numArgs = expanded;
+		args = expandedArgs;
 
-		// now call the command
-		int retVal = ProcessCommand(command, cmdLength, args, numArgs, cState, &isAlias, lineBuff, line_size);
-		if ( isAlias )
+		command = &pElement->content.alias.tokens[pElement->content.alias.offset[0]];
+		cmdLen = (int)strlen(command);
+		pElement = ConsoleFindEntry(c, command, cmdLen);
+	}
+
+	if ( pElement != NULL )
+	{
+		// long running calls are passed to the worker pool, so the console stays responsive
+		if ( pElement->content.isJob && ( pElement->content.isLongRunning == NULL ||
+				pElement->content.isLongRunning(numArgs, args, pElement->content.ctx) ) )
 		{
-			// in case it is an alias, the line buffer has been overwritten with the alias and so we have to do
-			// this round again
-			goto restart;
+			result = ConsoleSubmitJob(h, pElement, command, numArgs, args);
+		}
+		else
+		{
+			CONSOLE_TRACE_BEGIN(pElement->content.cmd);
+			result = pElement->content.func(numArgs, args, pElement->content.ctx);
+			CONSOLE_TRACE_END(result);
 		}
-		return retVal;
 	}
 
-	return 0;
+	xSemaphoreGiveRecursive( c->lockGuard );
+	if ( pElement == NULL )
+	{
+		printf("\033[31mInvalid command\033[0m");
+		fflush(stdout);
+		result = -1;
+	}
+	return result;
 }
 
 // --------------------------------------------------------------------------------------------------------------------
-static void PrintConsoleControl( cspState_t* s )
+static int TransformAndProcessTheCommand(char* lineBuff, int line_size, ConsoleHandle_t h)
 // --------------------------------------------------------------------------------------------------------------------
 {
-	if ( s->length >= 3 && s->type == ctrlC1_CSI )
+	cmdSlice_t slices[CONSOLE_MAX_NUM_ARGS + 1];
+	char* args[CONSOLE_MAX_NUM_ARGS + 1];
+
+	int numSlices = ConsoleTokenize(lineBuff, line_size, slices, CONSOLE_MAX_NUM_ARGS + 1);
+	if ( numSlices < 0 )
 	{
-		for ( unsigned int i = 0; i < s->length; i ++ )
-		{
-			putchar(s->buff[i]);
-		}
-		fflush(stdout);
+		printf("\033[31mToo many arguments\033[0m");
+		return -1;
 	}
+
+	// some sanity checks before calling the command
+	if ( numSlices == 0 || slices[0].len == 0 ) return 0;
+
+	// the slices are terminated in place, so they can be passed without copying
+	for ( int i = 1; i < numSlices; i++ )
+	{
+		args[i - 1] = slices[i].ptr;
+	}
+	args[numSlices - 1] = NULL;
+
+	return ProcessCommand(h, slices[0].ptr, slices[0].len, args, numSlices - 1);
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -567,13 +750,164 @@ static int ConsoleIsEntf( cspState_t* s )
 }
 
 // --------------------------------------------------------------------------------------------------------------------
-static void PrintConsoleArrowLeft( void )
+static void ConsoleListCandidates( redrawBuffer_t* r, cmdTrieNode_t* node, char* key, int keyLen, int skip )
 // --------------------------------------------------------------------------------------------------------------------
 {
-	putchar('\033');
-	putchar('[');
-	putchar(68);
+	// walks through all keys below the node in sorted order and prints them without the leading skip chars,
+	// the path is kept in an array instead of a recursion, the key buffer holds the chars of the path
+	cmdTrieNode_t* path[CONSOLE_TRIE_MAX_KEY];
+	int depth = 0;
+	if ( node->entry != NULL || node->keyword != 0 )
+	{
+		ConsoleRedrawPut(r, &key[skip], keyLen - skip);
+		ConsoleRedrawPut(r, "  ", 2);
+	}
+
+	node = node->child;
+	while ( node != NULL )
+	{
+		key[keyLen + depth] = node->c;
+		if ( node->entry != NULL || node->keyword != 0 )
+		{
+			ConsoleRedrawPut(r, &key[skip], keyLen + depth + 1 - skip);
+			ConsoleRedrawPut(r, "  ", 2);
+		}
+
+		// the keywords behind a separator belong to the next word and are not candidates for this one
+		if ( node->child != NULL && node->c != ' ' && keyLen + depth + 1 < CONSOLE_TRIE_MAX_KEY )
+		{
+			path[depth++] = node;
+			node = node->child;
+			continue;
+		}
+
+		while ( node->sibling == NULL && depth > 0 ) node = path[--depth];
+		node = node->sibling;
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void ConsoleComplete( ConsoleHandle_t h, char* lineBuff, unsigned int* lbPtr, const char* username, int result )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the input in front of the cursor is the key which has to be completed, leading spaces are ignored
+	char key[CONSOLE_TRIE_MAX_KEY + 2];
+	int begin = 0;
+	while ( begin < (int)*lbPtr && lineBuff[begin] == ' ' ) begin++;
+	int keyLen = (int)*lbPtr - begin;
+	if ( keyLen > CONSOLE_TRIE_MAX_KEY )
+	{
+		ConsoleRedrawPut(&h->redraw, "\a", 1);
+		return;
+	}
+	memcpy(key, &lineBuff[begin], keyLen);
+
+	xSemaphoreTakeRecursive( h->cState.lockGuard, -1 );
+
+	// an empty input matches all commands, so the root level is used like the children of a node
+	cmdTrieNode_t root = { h->cState.trie, NULL, NULL, '\0', 0 };
+	cmdTrieNode_t* node = ( keyLen > 0 ) ? ConsoleTrieFind(h->cState.trie, key, keyLen) : &root;
+	if ( node == NULL )
+	{
+		ConsoleRedrawPut(&h->redraw, "\a", 1);
+		goto exit;
+	}
+
+	// extend the input as long as there is only a single way to go on
+	int extLen = keyLen;
+	while ( node->entry == NULL && node->keyword == 0 && node->child != NULL && node->child->sibling == NULL &&
+			extLen < CONSOLE_TRIE_MAX_KEY )
+	{
+		node = node->child;
+		key[extLen++] = node->c;
+	}
+
+	// a complete word without any longer candidate gets the separator to the next argument
+	int complete = ( node->entry != NULL || node->keyword != 0 ) &&
+			( node->child == NULL || (node->child->c == ' ' && node->child->sibling == NULL) );
+	if ( complete && lineBuff[*lbPtr] != ' ' ) key[extLen++] = ' ';
+
+	if ( extLen > keyLen )
+	{
+		if ( strnlen(lineBuff, CONSOLE_LINE_SIZE) + (extLen - keyLen) <= CONSOLE_LINE_SIZE )
+		{
+			ConsoleLineInsert(&h->redraw, lineBuff, lbPtr, &key[keyLen], extLen - keyLen);
+		}
+		else
+		{
+			ConsoleRedrawPut(&h->redraw, "\a", 1);
+		}
+	}
+	else if ( !complete )
+	{
+		// ambiguous, so all candidates are listed with the last word only and the input is printed again
+		int skip = keyLen;
+		while ( skip > 0 && key[skip - 1] != ' ' ) skip--;
+		int lineLen = (int)strnlen(lineBuff, CONSOLE_LINE_SIZE);
+		ConsoleRedrawPut(&h->redraw, "\r\n", 2);
+		ConsoleListCandidates(&h->redraw, node, key, keyLen, skip);
+		ConsolePrompt(&h->redraw, username, result);
+		ConsoleRedrawPut(&h->redraw, lineBuff, lineLen);
+		ConsoleRedrawCursor(&h->redraw, lineLen - (int)*lbPtr, 'D');
+	}
+
+exit:
+	xSemaphoreGiveRecursive( h->cState.lockGuard );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int ConsoleStreamRead( void* cookie, char* pBuffer, int num )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	ConsoleHandle_t h = (ConsoleHandle_t)cookie;
+
+	taskENTER_CRITICAL();
+	ConsoleReadStream_t rdFunc = h->streams.rdFunc;
+	void* rdCtx = h->streams.rdCtx;
+	taskEXIT_CRITICAL();
+
+	return ( rdFunc != NULL ) ? rdFunc(rdCtx, pBuffer, num) : -1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int ConsoleStreamWrite( void* cookie, const char* pBuffer, int num )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	ConsoleHandle_t h = (ConsoleHandle_t)cookie;
+
+	taskENTER_CRITICAL();
+	ConsoleWriteStream_t wrFunc = h->streams.wrFunc;
+	void* wrCtx = h->streams.wrCtx;
+	taskEXIT_CRITICAL();
+
+	if ( wrFunc != NULL ) return wrFunc(wrCtx, pBuffer, num);
+
+	// output which was buffered or started before the stream was switched back to stdout goes to the default
+	// stdout of the console processor, so e.g. the OK or FAIL of a job is not lost
+	FILE* fallback = h->streams.fallback;
+	if ( fallback == NULL ) return num;
+	int written = (int)fwrite(pBuffer, 1, (size_t)num, fallback);
+	fflush(fallback);
+	return written;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void ConsoleApplyStreams( ConsoleHandle_t h, FILE* out, FILE* defaultIn, FILE* defaultOut )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the streams are only exchanged in the reentrancy structure of the calling task, which is either the
+	// console processor or one of its job workers. Other instances and all other tasks keep their streams. The
+	// write stream object out is the one of the calling task, see ConsoleJobWorker
+#ifdef __NEWLIB__
 	fflush(stdout);
+	_REENT->_stdin  = ( h->streams.rdFunc != NULL && h->streams.in != NULL ) ? h->streams.in : defaultIn;
+	_REENT->_stdout = ( h->streams.wrFunc != NULL && out != NULL ) ? out : defaultOut;
+#else
+	(void)h;
+	(void)out;
+	(void)defaultIn;
+	(void)defaultOut;
+#endif
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -581,64 +915,135 @@ int CONSOLE_RedirectStreams( ConsoleHandle_t h, ConsoleReadStream_t rdFunc, Cons
 		void* rdContext, void* wrContext )
 // --------------------------------------------------------------------------------------------------------------------
 {
+#ifndef __NEWLIB__ // so far only newlib is supported
 	(void)h;
 	(void)rdFunc;
 	(void)wrFunc;
 	(void)rdContext;
 	(void)wrContext;
-#ifndef __NEWLIB__ // so far only newlib is supported
 	return -2;
 #else
-	// we can only exec the real stream redirection when we are the console thread itself and the scheduler is running,
-	// otherwise we have to set the request to pending state
-	if ( ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) && ( xTaskGetCurrentTaskHandle() == h->tHandle ) )
+	if ( h == NULL ) return -1;
+
+	// every instance owns one read stream object and one write stream object for the console processor and for each
+	// job worker, they live as long as the instance. A redirection only exchanges the functions behind these objects, so a job which is
+	// still writing can never use a closed stream. The tasks of the instance pick up the change by the generation
+	if ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) taskENTER_CRITICAL();
+	h->streams.rdFunc = rdFunc;
+	h->streams.wrFunc = wrFunc;
+	h->streams.rdCtx  = rdContext;
+	h->streams.wrCtx  = wrContext;
+	h->streams.generation += 1;
+	if ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) taskEXIT_CRITICAL();
+	return 0;
+#endif
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+FILE* CONSOLE_OpenWriteStream( ConsoleHandle_t h )
+// --------------------------------------------------------------------------------------------------------------------
+{
+#ifdef __NEWLIB__
+	if ( h == NULL ) return NULL;
+
+	FILE* out = fwopen(h, ConsoleStreamWrite);
+	if ( out != NULL ) setvbuf(out, NULL, _IOLBF, CONSOLE_LINE_SIZE);
+	return out;
+#else
+	(void)h;
+	return NULL;
+#endif
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void ConsoleJobWorker( void * arg )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	ConsoleHandle_t h = (ConsoleHandle_t)arg;
+	int generation = -1;
+	FILE* defaultIn = stdin;
+	FILE* defaultOut = stdout;
+	FILE* out = NULL;
+#ifdef __NEWLIB__
+	// every worker writes through its own stream object into the write function of the instance. The FILE locks
+	// of newlib are empty without the retarget locks, so a stream object shared with the console processor and the
+	// other workers would mix their output in one line buffer
+	out = CONSOLE_OpenWriteStream(h);
+#endif
+
+	while ( h->cancel == 0 )
 	{
-		FILE* rdToClean = NULL;
-		if ( _impure_ptr->_stdin != &__sf[0])
+		// a job prints to the streams of the console instance which has started it
+		if ( generation != h->streams.generation )
 		{
-			rdToClean = _impure_ptr->_stdin;
+			generation = h->streams.generation;
+			ConsoleApplyStreams(h, out, defaultIn, defaultOut);
 		}
 
-		FILE* wrToClean = NULL;
-		if ( _impure_ptr->_stdout != &__sf[1])
-		{
-			wrToClean = _impure_ptr->_stdout;
-		}
+		consoleJob_t* job = NULL;
+		if ( xQueueReceive(h->jobs.queue, &job, pdMS_TO_TICKS(CONSOLE_JOB_POLL_MS)) != pdPASS ) continue;
 
-		FILE* myStdOut = &__sf[1];
-		if ( wrFunc != NULL )
+		// the streams can have been redirected while this worker was waiting for the job
+		if ( generation != h->streams.generation )
 		{
-			myStdOut = fwopen(wrContext, wrFunc);
-			if ( myStdOut == NULL ) return -1;
+			generation = h->streams.generation;
+			ConsoleApplyStreams(h, out, defaultIn, defaultOut);
 		}
 
-		FILE* myStdIn = &__sf[0];
-		if ( rdFunc != NULL )
+		// a job which was killed before it has been started is just dropped
+		taskENTER_CRITICAL();
+		int run = ( job->state == jobQUEUED );
+		if ( run )
 		{
-			myStdIn = fropen(rdContext, rdFunc);
-			if ( myStdIn == NULL )
-			{
-				if ( myStdOut != NULL && myStdOut != &__sf[1]) fclose(myStdOut);
-				return -1;
-			}
+			job->state  = jobRUNNING;
+			job->worker = xTaskGetCurrentTaskHandle();
 		}
+		taskEXIT_CRITICAL();
+		if ( !run ) continue;
+
+		CONSOLE_TRACE_BEGIN(job->cmd);
+		int result = job->func(job->argc, job->argv, job->ctx);
+		CONSOLE_TRACE_END(result);
+		fflush(stdout);
 
-		_impure_ptr->_stdin  = myStdIn;
-		_impure_ptr->_stdout = myStdOut;
+		taskENTER_CRITICAL();
+		job->result = result;
+		job->state  = ( job->cancel != 0 ) ? jobCANCELLED : jobDONE;
+		job->worker = NULL;
+		TaskHandle_t waiter = job->waiter;
+		job->waiter = NULL;
+		taskEXIT_CRITICAL();
 
-		if (wrToClean != NULL) fclose(wrToClean);
-		if (rdToClean != NULL) fclose(rdToClean);
+		if ( waiter != NULL ) xTaskNotifyGive(waiter);
 	}
-	else
+
+	fflush(stdout);
+#ifdef __NEWLIB__
+	_REENT->_stdin  = defaultIn;
+	_REENT->_stdout = defaultOut;
+	if ( out != NULL ) fclose(out);
+#endif
+	taskENTER_CRITICAL();
+	h->jobs.alive -= 1;
+	taskEXIT_CRITICAL();
+	vTaskDelete(NULL);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void ConsoleReportJobs( ConsoleHandle_t h )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// finished jobs are reported once before the next prompt, like a shell does
+	for ( int i = 0; i < CONSOLE_JOB_MAX; i++ )
 	{
-		h->pendingRedirect = 1;
-		h->pendingRdStream = rdFunc;
-		h->pendingWrStream = wrFunc;
-		h->pendingRdCtx    = rdContext;
-		h->pendingWrCtx    = wrContext;
+		consoleJob_t* job = &h->jobs.slots[i];
+		if ( ( job->state == jobDONE || job->state == jobCANCELLED ) && !job->reported )
+		{
+			job->reported = 1;
+			printf("\r\n[%d] %s %s (%d)", job->id, ( job->state == jobDONE ) ? "Done" : "Cancelled",
+					job->cmd, job->result);
+		}
 	}
-#endif
-	return 0;
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -648,14 +1053,24 @@ static void ConsoleFunction( void * arg )
 	ConsoleHandle_t h = (ConsoleHandle_t)arg;
 	if (h == NULL) goto destroy;
 
-	if( h->pendingRedirect != 0 )
+	FILE* defaultIn = stdin;
+	FILE* defaultOut = stdout;
+#ifdef __NEWLIB__
+	// the stream objects of this instance are owned by the console processor and are kept until it terminates
+	h->streams.fallback = defaultOut;
+	h->streams.in  = fropen(h, ConsoleStreamRead);
+	h->streams.out = fwopen(h, ConsoleStreamWrite);
+	if ( h->streams.out != NULL ) setvbuf(h->streams.out, NULL, _IOLBF, CONSOLE_LINE_SIZE);
+	taskENTER_CRITICAL();
+	h->streams.generation += 1;
+	taskEXIT_CRITICAL();
+	if ( h->streams.in == NULL || h->streams.out == NULL )
 	{
-		h->pendingRedirect = 0;
-		if ( CONSOLE_RedirectStreams(h, h->pendingRdStream, h->pendingWrStream, h->pendingRdCtx, h->pendingWrCtx) )
-		{
-			printf("was not able to redirect console streams, requested by user!");
-		}
+		printf("was not able to create the console streams, redirection is not possible!");
 	}
+#endif
+	int generation = h->streams.generation;
+	ConsoleApplyStreams(h, h->streams.out, defaultIn, defaultOut);
 
 #define xstr(a) str(a)
 #define str(a) #a
@@ -691,98 +1106,56 @@ static void ConsoleFunction( void * arg )
 	char* usernamePtr = CONSOLE_USERNAME;
 #endif
 
-	char* lineBuff = NULL;
-	char* ctrlBuff = malloc(CONSOLE_LINE_SIZE + CONSOLE_SAFETY_SPACE); // make sure we have a little space behind
-	if (ctrlBuff == NULL) goto exit;
-
-	lineBuff = malloc(CONSOLE_LINE_SIZE + CONSOLE_SAFETY_SPACE); // make sure we have a little space behind
-	if (lineBuff == NULL) goto exit;
-
+	// the line buffers are part of the handle, so a statically created console does not need the heap
+	char* ctrlBuff = h->buffers.ctrl;
+	char* lineBuff = h->buffers.line;
 	memset(ctrlBuff, ctrlC0_NUL, CONSOLE_LINE_SIZE + CONSOLE_SAFETY_SPACE);
 	memset(lineBuff, ctrlC0_NUL, CONSOLE_LINE_SIZE + CONSOLE_SAFETY_SPACE);
 	unsigned int lbPtr = 0;
+	int lastResult = 0;
 
 	printf("\r\nFreeRTOS Console Up and Running\r\n");
 	printf("\r\n\r\n-------------------------------------------------------------------\r\n");
 
 	h->pState.buff = ctrlBuff;
 
-	printf("\r\n%s(\033[32m\xE2\x9C\x93\033[0m) $>", usernamePtr);
-	int consoleStartIndex = (int)strlen(usernamePtr)+6;
-	fflush(stdout);
+	ConsolePrompt(&h->redraw, usernamePtr, lastResult);
+	ConsoleRedrawFlush(&h->redraw);
 
 	while(h->cancel == 0)
 	{
-		if( h->pendingRedirect != 0 )
-		{
-			h->pendingRedirect = 0;
-			if ( CONSOLE_RedirectStreams(h, h->pendingRdStream, h->pendingWrStream, h->pendingRdCtx, h->pendingWrCtx) )
-			{
-				printf("was not able to redirect console streams, requested by user!");
-			}
-		}
-
 		int res = EOF;
 		while((res = getchar()) == EOF)
 		{
+			// a stream function signals no data as error or end of file, both must not stick to the stream
+			clearerr(stdin);
 			if ( h->cancel == 1 ) goto exit;
+			if ( generation != h->streams.generation )
+			{
+				generation = h->streams.generation;
+				ConsoleApplyStreams(h, h->streams.out, defaultIn, defaultOut);
+			}
 		}
 		char myChar = res;
 		cspTYPE result = ControlSequenceParserConsume(myChar, &h->pState);
 		if ( result == csptCHARACTER )
 		{
-			putchar(myChar);
-			fflush(stdout);
-
-			if ( lineBuff[lbPtr + 1] != '\0' )
-			{
-				putchar(lineBuff[lbPtr]);
-				fflush(stdout);
-
-				int tmpPtr = lbPtr + 1;
-				char parking = myChar;
-				char parking2 = lineBuff[lbPtr];
-				while(tmpPtr < CONSOLE_LINE_SIZE)
-				{
-					putchar(lineBuff[tmpPtr]);
-					fflush(stdout);
-
-
-					lineBuff[tmpPtr - 1] = parking;
-					parking = parking2;
-					parking2 = lineBuff[tmpPtr];
-
-					if ( lineBuff[tmpPtr] == '\0' && parking == '\0')
-						break;
-
-					tmpPtr += 1;
-				}
-
-				printf("\033[%dD", CONSOLE_LINE_SIZE + consoleStartIndex);
-				printf("\033[%dC", consoleStartIndex + lbPtr + 1);
-				lbPtr += 1;
-				fflush(stdout);
-			}
-			else
-			{
-				lineBuff[lbPtr] = myChar;
-				lbPtr++;
-			}
-
-			if ( lbPtr > CONSOLE_LINE_SIZE )
+			if ( strnlen(lineBuff, CONSOLE_LINE_SIZE) >= CONSOLE_LINE_SIZE )
 			{
 				printf("\r\n Buffer Overrun! Clearing input...\r\n");
 				// print new console line and decode the result
-				printf("\r\n%s(\033[31m\xE2\x98\x93\033[0m) $>", usernamePtr);
-				fflush(stdout);
+				lastResult = -1;
+				ConsolePrompt(&h->redraw, usernamePtr, lastResult);
+				ConsoleRedrawFlush(&h->redraw);
 
 				// clear the buffer and restore the pointer
-				do
-				{
-					lineBuff[lbPtr] = ctrlC0_NUL;
-				    if ( lbPtr == 0 ) break;
-				    else lbPtr -= 1;
-				} while (1);
+				memset(lineBuff, ctrlC0_NUL, CONSOLE_LINE_SIZE + CONSOLE_SAFETY_SPACE);
+				lbPtr = 0;
+			}
+			else
+			{
+				ConsoleLineInsert(&h->redraw, lineBuff, &lbPtr, &myChar, 1);
+				ConsoleRedrawFlush(&h->redraw);
 			}
 		}
 		else if ( result == csptCONTROL )
@@ -793,22 +1166,21 @@ static void ConsoleFunction( void * arg )
 			case ctrlC0_LF:
 			case ctrlC0_CR:
 			{
-				putchar(h->pState.type);
-				fflush(stdout);
+				char newLine = h->pState.type;
+				ConsoleRedrawPut(&h->redraw, &newLine, 1);
 
 				// implicit CR on every LF?
 				if (0 && h->pState.type == ctrlC0_LF)
 				{
-					putchar(ctrlC0_CR);
-					fflush(stdout);
+					ConsoleRedrawPut(&h->redraw, "\r", 1);
 				}
 
 				// implicit LF on every CR?
 				if (1 && h->pState.type == ctrlC0_CR)
 				{
-					putchar(ctrlC0_LF);
-					fflush(stdout);
+					ConsoleRedrawPut(&h->redraw, "\n", 1);
 				}
+				ConsoleRedrawFlush(&h->redraw);
 
 				// now adapt the line history accordingly
 				memcpy(h->history.lines[h->history.lineHead], lineBuff, CONSOLE_LINE_SIZE);
@@ -817,7 +1189,7 @@ static void ConsoleFunction( void * arg )
 
 				// parse and execute the command and make sure the output streams
 				// are flushed before doing anything else with the result
-				int result = TransformAndProcessTheCommand(lineBuff, CONSOLE_LINE_SIZE, &h->cState);
+				int result = TransformAndProcessTheCommand(lineBuff, CONSOLE_LINE_SIZE, h);
 				fflush(stdout);
 				fflush(stderr);
 
@@ -825,73 +1197,38 @@ static void ConsoleFunction( void * arg )
 				// now check if there is a new user name (which is only possible by setenv command
 				// which is executed after process command call above...
 				usernamePtr = getenv("USERNAME");
-				if ( usernamePtr == 0 ) usernamePtr = CONSOLE_USERNAME;
-				consoleStartIndex = (int)strlen(usernamePtr)+6;
-#endif
-				// print new console line and decode the result
-				printf("\r\n%s(", usernamePtr);
-				if (result == 0)
-				{
-					printf("\033[32m\xE2\x9C\x93\033[0m");
-				}
-				else
-				{
-					printf("\033[31m\xE2\x98\x93\033[0m");
-				}
-				printf(") $>");
-				fflush(stdout);
-
-				// clear the buffer completely because an alias could change
-				// the buffer content way more than the user has entered and so
-				// we can not only clear lbPtr--!! as we have a safety space we
-				// can set CONSOLE_LINE_SIZE as matching pointer value;
-				lbPtr = CONSOLE_LINE_SIZE;
-				do
-				{
-					lineBuff[lbPtr] = ctrlC0_NUL;
-					if (lbPtr == 0) break;
-					else lbPtr -= 1;
-				} while (1);
+				if ( usernamePtr == 0 ) usernamePtr = CONSOLE_USERNAME;
+#endif
+				ConsoleReportJobs(h);
 
+				// print new console line and decode the result
+				lastResult = result;
+				ConsolePrompt(&h->redraw, usernamePtr, result);
+				ConsoleRedrawFlush(&h->redraw);
+
+				// clear the buffer completely because the tokenizer has terminated
+				// all arguments in place, so there could be content behind the first
+				// terminator. As we have a safety space we can clear all of it
+				memset(lineBuff, ctrlC0_NUL, CONSOLE_LINE_SIZE + CONSOLE_SAFETY_SPACE);
+				lbPtr = 0;
 				break;
 			}
 			case ctrlC0_DEL:
 			{
 				if (lbPtr > 0)
 				{
-					int tmpPtr = lbPtr;
+					// one step back and then remove the char below the cursor
 					lbPtr -= 1;
-					lineBuff[lbPtr] = ctrlC0_NUL;
-					putchar(ctrlC0_DEL);
-					fflush(stdout);
-					while (lineBuff[tmpPtr] != ctrlC0_NUL)
-					{
-						lineBuff[tmpPtr - 1] = lineBuff[tmpPtr];
-						putchar(lineBuff[tmpPtr - 1]);
-						fflush(stdout);
-						tmpPtr += 1;
-						if (tmpPtr >= CONSOLE_LINE_SIZE) break;
-					}
-					lineBuff[tmpPtr - 1] = ctrlC0_NUL;
-					putchar(' ');
-					fflush(stdout);
-
-					int moveBack = tmpPtr - lbPtr;
-					for (; moveBack > 0; moveBack--)
-						PrintConsoleArrowLeft();
+					ConsoleRedrawPut(&h->redraw, "\b", 1);
+					ConsoleLineDelete(&h->redraw, lineBuff, lbPtr);
+					ConsoleRedrawFlush(&h->redraw);
 				}
 				break;
 			}
 			case ctrlC0_TAB:
 			{
-				int nums = 4 - (lbPtr % 4);
-				for (; nums > 0; nums--)
-				{
-					lineBuff[lbPtr] = ' ';
-					lbPtr += 1;
-					putchar(' ');
-					fflush(stdout);
-				}
+				ConsoleComplete(h, lineBuff, &lbPtr, usernamePtr, lastResult);
+				ConsoleRedrawFlush(&h->redraw);
 				break;
 			}
 
@@ -902,7 +1239,8 @@ static void ConsoleFunction( void * arg )
 					if (lbPtr > 0)
 					{
 						lbPtr -= 1;
-						PrintConsoleControl(&h->pState);
+						ConsoleRedrawCursor(&h->redraw, 1, 'D');
+						ConsoleRedrawFlush(&h->redraw);
 					}
 				}
 				else if (ConsoleIsArrowRight(&h->pState))
@@ -912,39 +1250,20 @@ static void ConsoleFunction( void * arg )
 						if (lineBuff[lbPtr] == ctrlC0_NUL)
 						{
 							lineBuff[lbPtr] = ' ';
-							putchar(' ');
-							fflush(stdout);
+							ConsoleRedrawPut(&h->redraw, " ", 1);
 						}
 						else
 						{
-							PrintConsoleControl(&h->pState);
+							ConsoleRedrawCursor(&h->redraw, 1, 'C');
 						}
+						ConsoleRedrawFlush(&h->redraw);
 						lbPtr += 1;
 					}
 				}
 				else if (ConsoleIsEntf(&h->pState))
 				{
-					if (lbPtr < (CONSOLE_LINE_SIZE - 1))
-					{
-						int tmpPtr = lbPtr + 1;
-						lineBuff[lbPtr] = ' ';
-						PrintConsoleControl(&h->pState);
-						while (lineBuff[tmpPtr] != ctrlC0_NUL)
-						{
-							lineBuff[tmpPtr - 1] = lineBuff[tmpPtr];
-							putchar(lineBuff[tmpPtr - 1]);
-							fflush(stdout);
-							tmpPtr += 1;
-							if (tmpPtr >= CONSOLE_LINE_SIZE) break;
-						}
-						lineBuff[tmpPtr - 1] = ctrlC0_NUL;
-						putchar(' ');
-						fflush(stdout);
-
-						int moveBack = tmpPtr - lbPtr;
-						for (; moveBack > 0; moveBack--)
-							PrintConsoleArrowLeft();
-					}
+					ConsoleLineDelete(&h->redraw, lineBuff, lbPtr);
+					ConsoleRedrawFlush(&h->redraw);
 				}
 				else if (ConsoleIsArrowUp(&h->pState) || ConsoleIsArrowDown(&h->pState))
 				{
@@ -960,46 +1279,10 @@ static void ConsoleFunction( void * arg )
 						if (h->history.linePtr >= CONSOLE_LINE_HISTORY) h->history.linePtr = 0;
 					}
 
-					// in case there is no "full" history, stop it
-					if (h->history.linePtr == h->history.lineHead)
-					{
-						int inputLength = (int)strnlen(lineBuff, CONSOLE_LINE_SIZE);
-						printf("\033[%dD", CONSOLE_LINE_SIZE + consoleStartIndex);
-						printf("\033[%dC", consoleStartIndex);
-						for (int i = 0; i < inputLength; i++)
-							putchar(' ');
-						memset(lineBuff, 0, CONSOLE_LINE_SIZE);
-						lbPtr = 0;
-
-						printf("\033[%dD", CONSOLE_LINE_SIZE + consoleStartIndex);
-						printf("\033[%dC", consoleStartIndex);
-						fflush(stdout);
-					}
-					else
-					{
-						int inputLength = (int)strnlen(lineBuff, CONSOLE_LINE_SIZE);
-						printf("\033[%dD", CONSOLE_LINE_SIZE + consoleStartIndex);
-						printf("\033[%dC", consoleStartIndex);
-						int i = 0;
-						for (; i < inputLength; i++)
-							putchar(' ');
-
-						printf("\033[%dD", CONSOLE_LINE_SIZE + consoleStartIndex);
-						printf("\033[%dC", consoleStartIndex);
-						fflush(stdout);
-
-						i = 0;
-						memset(lineBuff, 0, CONSOLE_LINE_SIZE);
-						lbPtr = 0;
-						while (h->history.lines[h->history.linePtr][i] != '\0')
-						{
-							putchar(h->history.lines[h->history.linePtr][i]);
-							lineBuff[lbPtr] = h->history.lines[h->history.linePtr][i];
-							lbPtr++;
-							i++;
-						}
-						fflush(stdout);
-					}
+					// in case there is no "full" history, the input is cleared
+					ConsoleLineReplace(&h->redraw, lineBuff, &lbPtr,
+							( h->history.linePtr == h->history.lineHead ) ? "" : h->history.lines[h->history.linePtr]);
+					ConsoleRedrawFlush(&h->redraw);
 				}
 				else goto unimp;
 				break;
@@ -1028,6 +1311,28 @@ exit:
 	printf("Console terminated, cleaning up...");
 	fflush(stdout);
 
+	// running jobs are cancelled and the workers must have left before the handle is released
+	for ( int i = 0; i < CONSOLE_JOB_MAX; i++ )
+	{
+		consoleJob_t* job = &h->jobs.slots[i];
+		if ( job->state == jobRUNNING )
+		{
+			job->cancel = 1;
+			if ( job->cancelFunc != NULL ) job->cancelFunc(job->ctx);
+		}
+	}
+	while ( h->jobs.alive > 0 ) vTaskDelay(pdMS_TO_TICKS(10));
+	vQueueDelete(h->jobs.queue);
+
+	// go back to the default streams before the stream objects of this instance are released
+	fflush(stdout);
+#ifdef __NEWLIB__
+	_REENT->_stdin  = defaultIn;
+	_REENT->_stdout = defaultOut;
+	if ( h->streams.in != NULL ) fclose(h->streams.in);
+	if ( h->streams.out != NULL ) fclose(h->streams.out);
+#endif
+
 	xSemaphoreTakeRecursive(h->cState.lockGuard, -1);
 	while (!LIST_EMPTY(&h->cState.commands))
 	{
@@ -1035,17 +1340,16 @@ exit:
 		if (pElement != NULL)
 		{
 			LIST_REMOVE(pElement, navigate);
-			free(pElement);
+			CONSOLE_FREE(pElement);
 		}
 		else break;
 	}
+	ConsoleTrieFree(h->cState.trie);
+	h->cState.trie = NULL;
 
 	xSemaphoreGiveRecursive(h->cState.lockGuard);
 	vSemaphoreDelete(h->cState.lockGuard);
-	free(h);
-	
-	if (lineBuff != NULL) free(lineBuff);
-	if (ctrlBuff != NULL) free(ctrlBuff);
+	if ( !h->isStatic ) CONSOLE_FREE(h);
 	printf("done\r\n");
 destroy:
 	vTaskDelete(NULL);
@@ -1143,7 +1447,7 @@ static int ConsolePrintTaskStats(int argc, char** argv, void* context)
 	if (numFeedback > 0)
 	{
 		printf("|----|----------|----------|----------|---------|------------|-------|\r\n");
-		printf("| ID | NAME     | Prio     | BasePrio | State   | Ticks      | Rel.  |\r\n");
+		printf("| ID | NAME     | Prio     | BasePrio | State   | Counter    | Rel.  |\r\n");
 		printf("|----|----------|----------|----------|---------|------------|-------|\r\n");
 	}
 	for (unsigned int i = 0; i < numFeedback; i++ )
@@ -1316,39 +1620,10 @@ static int ConsoleAliasConfig(int argc, char** argv, void* context)
 	else
 	{
 		char aliasBuffer[CONSOLE_LINE_SIZE];
-		unsigned int cmdPtr = 1;
-		unsigned int buffPtr = 0;
-		memset(aliasBuffer, 0, sizeof(aliasBuffer));
-		for( unsigned int i = 0; i < sizeof(aliasBuffer)/sizeof(*aliasBuffer); i++)
+		if ( ConsoleAliasQuote(aliasBuffer, sizeof(aliasBuffer), argc - 1, &argv[1]) < 0 )
 		{
-			if ( cmdPtr < (unsigned int)argc )
-			{
-				int argLen = strnlen(argv[cmdPtr], CONSOLE_LINE_SIZE);
-				if ( argLen > 0 )
-				{
-					if ( (buffPtr+1) + argLen >= CONSOLE_LINE_SIZE )
-					{
-						printf("the sum of the alias parameters is longer than the max line buffer size!");
-						return -1;
-					}
-					else
-					{
-						memcpy(&aliasBuffer[buffPtr], argv[cmdPtr], argLen);
-						buffPtr += argLen;
-						if ( ( cmdPtr + 1) != (unsigned int)argc )
-						{
-							aliasBuffer[buffPtr] = ' ';
-							buffPtr += 1;
-						}
-					}
-				}
-				else
-				{
-					printf("at least one of the alias parameters is too long for mapping");
-					return -1;
-				}
-			}
-			cmdPtr++;
+			printf("the sum of the alias parameters is longer than the max line buffer size!");
+			return -1;
 		}
 		if ( CONSOLE_RegisterAlias(h, argv[0], aliasBuffer) == 0 )
 		{
@@ -1363,6 +1638,141 @@ static int ConsoleAliasConfig(int argc, char** argv, void* context)
 	}
 }
 
+// --------------------------------------------------------------------------------------------------------------------
+static consoleJob_t* ConsoleFindJob( ConsoleHandle_t h, char* arg )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	int id = atoi(arg);
+	for ( int i = 0; i < CONSOLE_JOB_MAX; i++ )
+	{
+		if ( h->jobs.slots[i].state != jobFREE && h->jobs.slots[i].id == id ) return &h->jobs.slots[i];
+	}
+
+	printf("job %s not found", arg);
+	return NULL;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int ConsoleJobsList(int argc, char** argv, void* context)
+// --------------------------------------------------------------------------------------------------------------------
+{
+	(void)argc;
+	(void)argv;
+	ConsoleHandle_t h = (ConsoleHandle_t)context;
+	static const char* const stateNames[] = { "free", "queued", "running", "done", "cancelled" };
+
+	for ( int i = 0; i < CONSOLE_JOB_MAX; i++ )
+	{
+		consoleJob_t* job = &h->jobs.slots[i];
+		jobState_t state = job->state;
+		if ( state == jobFREE ) continue;
+
+		printf("[%d] %-10s", job->id, stateNames[state]);
+		if ( state == jobDONE || state == jobCANCELLED )
+		{
+			job->reported = 1;
+			printf("(%d) ", job->result);
+		}
+		printf("%s", job->cmd);
+		for ( int a = 0; a < job->argc; a++ )
+		{
+			printf(" %s", job->argv[a]);
+		}
+		printf("\r\n");
+	}
+	return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int ConsoleJobWait(int argc, char** argv, void* context)
+// --------------------------------------------------------------------------------------------------------------------
+{
+	ConsoleHandle_t h = (ConsoleHandle_t)context;
+	if ( argc < 1 || argc > 2 )
+	{
+		printf("invalid number of arguments");
+		return -1;
+	}
+
+	consoleJob_t* job = ConsoleFindJob(h, argv[0]);
+	if ( job == NULL ) return -1;
+	TickType_t timeout = ( argc == 2 ) ? pdMS_TO_TICKS(atoi(argv[1])) : portMAX_DELAY;
+
+	// drop a notification of an earlier wait which has timed out
+	ulTaskNotifyTake(pdTRUE, 0);
+
+	taskENTER_CRITICAL();
+	int finished = ( job->state == jobDONE || job->state == jobCANCELLED );
+	if ( !finished ) job->waiter = xTaskGetCurrentTaskHandle();
+	taskEXIT_CRITICAL();
+
+	if ( !finished && ulTaskNotifyTake(pdTRUE, timeout) == 0 )
+	{
+		taskENTER_CRITICAL();
+		job->waiter = NULL;
+		taskEXIT_CRITICAL();
+		printf("timeout while waiting for job %d", job->id);
+		return -1;
+	}
+
+	job->reported = 1;
+	printf("[%d] %s (%d)", job->id, ( job->state == jobDONE ) ? "Done" : "Cancelled", job->result);
+	return ( job->state == jobDONE ) ? job->result : -1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int ConsoleJobKill(int argc, char** argv, void* context)
+// --------------------------------------------------------------------------------------------------------------------
+{
+	ConsoleHandle_t h = (ConsoleHandle_t)context;
+	if ( argc != 1 )
+	{
+		printf("invalid number of arguments");
+		return -1;
+	}
+
+	consoleJob_t* job = ConsoleFindJob(h, argv[0]);
+	if ( job == NULL ) return -1;
+
+	TaskHandle_t waiter = NULL;
+	int running = 0;
+	taskENTER_CRITICAL();
+	if ( job->state == jobQUEUED )
+	{
+		job->state  = jobCANCELLED;
+		job->result = -1;
+		waiter = job->waiter;
+		job->waiter = NULL;
+	}
+	else if ( job->state == jobRUNNING )
+	{
+		job->cancel = 1;
+		running = 1;
+	}
+	taskEXIT_CRITICAL();
+
+	if ( waiter != NULL ) xTaskNotifyGive(waiter);
+
+	if ( running )
+	{
+		// the job is finished by the worker as soon as the command function returns
+		if ( job->cancelFunc == NULL )
+		{
+			printf("job %d has no cancel function, it is only marked as cancelled", job->id);
+			return 0;
+		}
+		job->cancelFunc(job->ctx);
+	}
+	else if ( waiter == NULL && job->state != jobCANCELLED )
+	{
+		printf("job %d is not running anymore", job->id);
+		return -1;
+	}
+
+	printf("job %d cancelled", job->id);
+	return 0;
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 static void ConsoleRegisterBasicCommands( ConsoleHandle_t h )
 // --------------------------------------------------------------------------------------------------------------------
@@ -1387,6 +1797,12 @@ static void ConsoleRegisterBasicCommands( ConsoleHandle_t h )
 			ConsolePrintKernelTicks, h);
 	CONSOLE_RegisterCommand(h, "alias",     "<<alias>>",
 			ConsoleAliasConfig, h);
+	CONSOLE_RegisterCommand(h, "jobs",      "<<jobs>> lists all background jobs with their state.\r\nFinished jobs are listed with their result.",
+			ConsoleJobsList, h);
+	CONSOLE_RegisterCommand(h, "wait",      "<<wait>> <id> [timeout in ms] blocks until the background job with\r\nthe given <id> has finished and returns its result.",
+			ConsoleJobWait, h);
+	CONSOLE_RegisterCommand(h, "kill",      "<<kill>> <id> cancels a queued or running background job.\r\nThe cancel function of the command is called for running jobs.",
+			ConsoleJobKill, h);
 #if defined(configGENERATE_RUN_TIME_STATS) && (configGENERATE_RUN_TIME_STATS != 0)
 	CONSOLE_RegisterCommand(h, "tasks",     "<<tasks>> prints information about the active tasks\r\nand prints also runtime information.",
 		ConsolePrintTaskStats, h);
@@ -1394,24 +1810,22 @@ static void ConsoleRegisterBasicCommands( ConsoleHandle_t h )
 }
 
 // --------------------------------------------------------------------------------------------------------------------
-ConsoleHandle_t CONSOLE_CreateInstance( unsigned int uxStackDepth, int xPrio )
+static void ConsoleInitHandle( ConsoleHandle_t h )
 // --------------------------------------------------------------------------------------------------------------------
 {
-#define ON_NULL_GOTO_ERROR(x) do { if ((x) == NULL) goto error; } while(0);
-	struct ConsoleHandle* h = calloc(sizeof(struct ConsoleHandle), 1);
-	ON_NULL_GOTO_ERROR(h);
-
-	h->cState.lockGuard = xSemaphoreCreateRecursiveMutex();
-	ON_NULL_GOTO_ERROR(h->cState.lockGuard);
+	// the handle is zeroed and its lock guard is created already
 	h->pState.state = ctrlpsIDLE_DETECT;
 	h->pState.length = 0;
 	h->pState.maxLength = CONSOLE_LINE_SIZE;
 	h->pState.type = ctrlUNKNOWN;
 	h->pState.buff = NULL;
 	h->cancel = 0;
-	h->pendingRedirect = 0;
-	h->pendingRdStream = NULL;
-	h->pendingWrStream = NULL;
+	h->streams.rdFunc = NULL;
+	h->streams.wrFunc = NULL;
+	h->streams.in = NULL;
+	h->streams.out = NULL;
+	h->streams.fallback = NULL;
+	h->streams.generation = 0;
 
 	LIST_INIT(&h->cState.commands);
 	ConsoleRegisterBasicCommands(h);
@@ -1419,6 +1833,34 @@ ConsoleHandle_t CONSOLE_CreateInstance( unsigned int uxStackDepth, int xPrio )
 	memset(h->history.lines, 0, sizeof(h->history.lines));
 	h->history.linePtr = h->history.lineHead = 0;
 
+	h->jobs.nextId = 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+ConsoleHandle_t CONSOLE_CreateInstance( unsigned int uxStackDepth, int xPrio )
+// --------------------------------------------------------------------------------------------------------------------
+{
+#define ON_NULL_GOTO_ERROR(x) do { if ((x) == NULL) goto error; } while(0);
+	struct ConsoleHandle* h = CONSOLE_MALLOC(sizeof(struct ConsoleHandle));
+	ON_NULL_GOTO_ERROR(h);
+	memset(h, 0, sizeof(struct ConsoleHandle));
+
+	h->cState.lockGuard = xSemaphoreCreateRecursiveMutex();
+	ON_NULL_GOTO_ERROR(h->cState.lockGuard);
+	ConsoleInitHandle(h);
+
+	h->jobs.queue = xQueueCreate(CONSOLE_JOB_MAX, sizeof(consoleJob_t*));
+	ON_NULL_GOTO_ERROR(h->jobs.queue);
+
+	// the workers run on the same priority as the console processor, so a busy polling console does not starve them
+	for ( int i = 0; i < CONSOLE_JOB_WORKERS; i++ )
+	{
+		xTaskCreate(ConsoleJobWorker, "job", ( CONSOLE_JOB_STACK_DEPTH > 0 ) ? CONSOLE_JOB_STACK_DEPTH : uxStackDepth,
+				h, xPrio, &h->jobs.workers[i]);
+		ON_NULL_GOTO_ERROR(h->jobs.workers[i]);
+		h->jobs.alive += 1;
+	}
+
 	xTaskCreate(ConsoleFunction, "console", uxStackDepth, h, xPrio, &h->tHandle);
 	ON_NULL_GOTO_ERROR(h->tHandle);
 	return h;
@@ -1426,20 +1868,70 @@ ConsoleHandle_t CONSOLE_CreateInstance( unsigned int uxStackDepth, int xPrio )
 error:
 	if ( h != NULL )
 	{
+		for ( int i = 0; i < CONSOLE_JOB_WORKERS; i++ )
+		{
+			if ( h->jobs.workers[i] != NULL ) vTaskDelete(h->jobs.workers[i]);
+		}
+
+		if ( h->jobs.queue != NULL )
+		{
+			vQueueDelete(h->jobs.queue);
+			h->jobs.queue = NULL;
+		}
+
 		if ( h->cState.lockGuard != NULL )
 		{
 			vSemaphoreDelete(h->cState.lockGuard);
 			h->cState.lockGuard = NULL;
 		}
 
-		free(h);
+		ConsoleTrieFree(h->cState.trie);
+		CONSOLE_FREE(h);
 	}
 
 	return NULL;
 }
 
+#if defined(configSUPPORT_STATIC_ALLOCATION) && ( configSUPPORT_STATIC_ALLOCATION == 1 )
 // --------------------------------------------------------------------------------------------------------------------
-int CONSOLE_RegisterCommand( ConsoleHandle_t h, char* cmd, char* help, CONSOLE_CommandFunc func, void* context )
+ConsoleHandle_t CONSOLE_CreateStatic( unsigned int uxStackDepth, int xPrio, ConsoleStaticBuffers_t* buffers )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// fails to compile when CONSOLE_STATIC_HANDLE_WORDS is too small for the handle of the current configuration
+	typedef char ConsoleStaticHandleCheck_t[ ( sizeof(struct ConsoleHandle) <= sizeof(buffers->handle) ) ? 1 : -1 ];
+	(void)sizeof(ConsoleStaticHandleCheck_t);
+
+	if ( buffers == NULL || buffers->stack == NULL ) return NULL;
+	for ( int i = 0; i < CONSOLE_JOB_WORKERS; i++ )
+	{
+		if ( buffers->workerStacks[i] == NULL ) return NULL;
+	}
+
+	// none of the static objects can fail when their storage is given, the commands are still allocated
+	struct ConsoleHandle* h = (struct ConsoleHandle*)buffers->handle;
+	memset(h, 0, sizeof(struct ConsoleHandle));
+	h->isStatic = 1;
+	h->cState.lockGuard = xSemaphoreCreateRecursiveMutexStatic(&buffers->lockGuard);
+	ConsoleInitHandle(h);
+
+	h->jobs.queue = xQueueCreateStatic(CONSOLE_JOB_MAX, sizeof(consoleJob_t*), (uint8_t*)buffers->jobQueueStorage,
+			&buffers->jobQueue);
+	for ( int i = 0; i < CONSOLE_JOB_WORKERS; i++ )
+	{
+		h->jobs.workers[i] = xTaskCreateStatic(ConsoleJobWorker, "job",
+				( CONSOLE_JOB_STACK_DEPTH > 0 ) ? CONSOLE_JOB_STACK_DEPTH : uxStackDepth, h, xPrio,
+				buffers->workerStacks[i], &buffers->workerTasks[i]);
+		h->jobs.alive += 1;
+	}
+
+	h->tHandle = xTaskCreateStatic(ConsoleFunction, "console", uxStackDepth, h, xPrio, buffers->stack, &buffers->task);
+	return h;
+}
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+static int ConsoleRegisterEntry( ConsoleHandle_t h, char* cmd, char* help, CONSOLE_CommandFunc func, int isJob,
+		CONSOLE_IsLongRunningFunc isLongRunning, CONSOLE_CancelFunc cancel, void* context )
 // --------------------------------------------------------------------------------------------------------------------
 {
 	int result = -1;
@@ -1454,28 +1946,20 @@ int CONSOLE_RegisterCommand( ConsoleHandle_t h, char* cmd, char* help, CONSOLE_C
 	if ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) xSemaphoreTakeRecursive( h->cState.lockGuard, -1 );
 
 	cmdState_t* c = &h->cState;
-	int found = 0;
-	cmdEntry_t* pElement = c->commands.lh_first;
-	while ( pElement != NULL )
-	{
-		// if string compare result and determined length match, then this must be the function
-		if ( strncmp(cmd, pElement->content.cmd, cmdLen) == 0 && cmdLen == pElement->content.cmdLen )
-		{
-			found = 1;
-			break;
-		}
-		pElement = pElement->navigate.le_next;
-	}
+	cmdEntry_t* pElement = ConsoleFindEntry(c, cmd, cmdLen);
 
-	if ( found == 1 )
+	if ( pElement != NULL )
 	{
 		result = -1;
 	}
 	else
 	{
-		struct cmdEntry *item = malloc(sizeof(struct cmdEntry));
-		if (item == NULL) return result;
+		struct cmdEntry *item = CONSOLE_MALLOC(sizeof(struct cmdEntry));
+		if (item == NULL) goto exit;
 		item->content.isAlias = 0;
+		item->content.isJob   = isJob;
+		item->content.isLongRunning = isLongRunning;
+		item->content.cancel  = cancel;
 		item->content.cmdLen  = cmdLen;
 		item->content.helpLen = helpLen;
 		item->content.func    = func;
@@ -1484,15 +1968,66 @@ int CONSOLE_RegisterCommand( ConsoleHandle_t h, char* cmd, char* help, CONSOLE_C
 		item->content.cmd[cmdLen] = '\0';
 		memcpy(item->content.help, help, helpLen);
 		item->content.help[helpLen] = '\0';
+
+		cmdTrieNode_t* node = ConsoleTrieInsert(&c->trie, cmd, cmdLen);
+		if ( node == NULL )
+		{
+			CONSOLE_FREE(item);
+			goto exit;
+		}
+		node->entry = item;
 		LIST_INSERT_HEAD(&h->cState.commands, item, navigate);
 		result = 0;
 	}
 
+exit:
 	// could be called while the scheduler is not running or suspended, so we must not use to use the lock guard
 	if ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) xSemaphoreGiveRecursive( h->cState.lockGuard );
 	return result;
 }
 
+// --------------------------------------------------------------------------------------------------------------------
+int CONSOLE_RegisterCommand( ConsoleHandle_t h, char* cmd, char* help, CONSOLE_CommandFunc func, void* context )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	return ConsoleRegisterEntry(h, cmd, help, func, 0, NULL, NULL, context);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int CONSOLE_RegisterJobCommand( ConsoleHandle_t h, char* cmd, char* help, CONSOLE_CommandFunc func,
+		CONSOLE_IsLongRunningFunc isLongRunning, CONSOLE_CancelFunc cancel, void* context )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	return ConsoleRegisterEntry(h, cmd, help, func, 1, isLongRunning, cancel, context);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int CONSOLE_IsJobCancelled( ConsoleHandle_t h )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	return CONSOLE_IsWorkerJobCancelled( h, xTaskGetCurrentTaskHandle() );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int CONSOLE_IsWorkerJobCancelled( ConsoleHandle_t h, void* worker )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	int cancelled = 0;
+
+	if ( worker == NULL ) return cancelled;
+
+	taskENTER_CRITICAL();
+	for ( int i = 0; i < CONSOLE_JOB_MAX; i++ )
+	{
+		if ( h->jobs.slots[i].state == jobRUNNING && h->jobs.slots[i].worker == (TaskHandle_t)worker )
+		{
+			cancelled = h->jobs.slots[i].cancel;
+			break;
+		}
+	}
+	taskEXIT_CRITICAL();
+	return cancelled;
+}
 
 // --------------------------------------------------------------------------------------------------------------------
 int CONSOLE_RegisterAlias( ConsoleHandle_t h, char* cmd, char* aliasCmd )
@@ -1510,28 +2045,20 @@ int CONSOLE_RegisterAlias( ConsoleHandle_t h, char* cmd, char* aliasCmd )
 	if ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) xSemaphoreTakeRecursive( h->cState.lockGuard, -1 );
 
 	cmdState_t* c = &h->cState;
-	int found = 0;
-	cmdEntry_t* pElement = c->commands.lh_first;
-	while ( pElement != NULL )
-	{
-		// if string compare result and determined length match, then this must be the function
-		if ( strncmp(cmd, pElement->content.cmd, cmdLen) == 0 && cmdLen == pElement->content.cmdLen )
-		{
-			found = 1;
-			break;
-		}
-		pElement = pElement->navigate.le_next;
-	}
+	cmdEntry_t* pElement = ConsoleFindEntry(c, cmd, cmdLen);
 
-	if ( found == 1 )
+	if ( pElement != NULL )
 	{
 		result = -1;
 	}
 	else
 	{
-		struct cmdEntry *item = malloc(sizeof(struct cmdEntry));
-		if (item == NULL) return result;
+		struct cmdEntry *item = CONSOLE_MALLOC(sizeof(struct cmdEntry));
+		if (item == NULL) goto exit;
 		item->content.isAlias = 1;
+		item->content.isJob   = 0;
+		item->content.isLongRunning = NULL;
+		item->content.cancel  = NULL;
 		item->content.cmdLen  = cmdLen;
 		item->content.helpLen = aliasCmdLen;
 		item->content.func    = NULL;
@@ -1540,10 +2067,75 @@ int CONSOLE_RegisterAlias( ConsoleHandle_t h, char* cmd, char* aliasCmd )
 		item->content.cmd[cmdLen] = '\0';
 		memcpy(item->content.help, aliasCmd, aliasCmdLen);
 		item->content.help[aliasCmdLen] = '\0';
+
+		// the alias is tokenized once while it is registered, so the expansion while executing
+		// the alias is only a splice of the stored token offsets into the argument vector
+		cmdSlice_t slices[CONSOLE_ALIAS_MAX_ARGS];
+		memcpy(item->content.alias.tokens, aliasCmd, aliasCmdLen);
+		memset(&item->content.alias.tokens[aliasCmdLen], 0, sizeof(item->content.alias.tokens) - aliasCmdLen);
+		int numSlices = ConsoleTokenize(item->content.alias.tokens, aliasCmdLen, slices, CONSOLE_ALIAS_MAX_ARGS);
+		if ( numSlices <= 0 || slices[0].len == 0 )
+		{
+			CONSOLE_FREE(item);
+			goto exit;
+		}
+		for ( int i = 0; i < numSlices; i++ )
+		{
+			item->content.alias.offset[i] = (unsigned char)(slices[i].ptr - item->content.alias.tokens);
+		}
+		item->content.alias.argc = numSlices;
+
+		cmdTrieNode_t* node = ConsoleTrieInsert(&c->trie, cmd, cmdLen);
+		if ( node == NULL )
+		{
+			CONSOLE_FREE(item);
+			goto exit;
+		}
+		node->entry = item;
 		LIST_INSERT_HEAD(&h->cState.commands, item, navigate);
 		result = 0;
 	}
 
+exit:
+
+	// could be called while the scheduler is not running or suspended, so we must not use to use the lock guard
+	if ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) xSemaphoreGiveRecursive( h->cState.lockGuard );
+	return result;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int CONSOLE_RegisterSubcommand( ConsoleHandle_t h, char* cmd, char* keyword )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	int result = -1;
+	if ( cmd == NULL || keyword == NULL ) return result;
+	if ( *cmd == '\0' || *keyword == '\0' ) return result;
+	int cmdLen  = 0;
+	int keywordLen = 0;
+	if ( (cmdLen     = (int)strnlen(cmd, CONSOLE_COMMAND_MAX_LENGTH+1) )     > CONSOLE_COMMAND_MAX_LENGTH ) return result;
+	if ( (keywordLen = (int)strnlen(keyword, CONSOLE_COMMAND_MAX_LENGTH+1) ) > CONSOLE_COMMAND_MAX_LENGTH ) return result;
+	if ( strchr(keyword, ' ') != NULL ) return result;
+
+	char key[CONSOLE_TRIE_MAX_KEY + 1];
+	memcpy(key, cmd, cmdLen);
+	key[cmdLen] = ' ';
+	memcpy(&key[cmdLen + 1], keyword, keywordLen);
+
+	// could be called while the scheduler is not running or suspended, so we must not use to use the lock guard
+	if ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) xSemaphoreTakeRecursive( h->cState.lockGuard, -1 );
+
+	// a keyword is only a completion candidate, so it needs the command it belongs to
+	cmdState_t* c = &h->cState;
+	if ( ConsoleFindEntry(c, cmd, cmdLen) != NULL )
+	{
+		cmdTrieNode_t* node = ConsoleTrieInsert(&c->trie, key, cmdLen + 1 + keywordLen);
+		if ( node != NULL && node->keyword == 0 )
+		{
+			node->keyword = 1;
+			result = 0;
+		}
+	}
+
 	// could be called while the scheduler is not running or suspended, so we must not use to use the lock guard
 	if ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) xSemaphoreGiveRecursive( h->cState.lockGuard );
 	return result;
@@ -1563,23 +2155,26 @@ int CONSOLE_RemoveAliasOrCommand( ConsoleHandle_t h, char* cmd)
 	if ( taskSCHEDULER_RUNNING == xTaskGetSchedulerState() ) xSemaphoreTakeRecursive( h->cState.lockGuard, -1 );
 
 	cmdState_t* c = &h->cState;
-	int found = 0;
-	cmdEntry_t* pElement = c->commands.lh_first;
-	while ( pElement != NULL )
+	cmdEntry_t* pElement = ConsoleFindEntry(c, cmd, cmdLen);
+
+	if ( pElement != NULL )
 	{
-		// if string compare result and determined length match, then this must be the function
-		if ( strncmp(cmd, pElement->content.cmd, cmdLen) == 0 && cmdLen == pElement->content.cmdLen )
+		cmdTrieNode_t* node = ConsoleTrieFind(c->trie, cmd, cmdLen);
+		node->entry = NULL;
+
+		// the subcommand keywords are removed together with their command, the separator
+		// is the smallest char which is allowed in a key, so it is always the first child
+		cmdTrieNode_t* separator = node->child;
+		if ( separator != NULL && separator->c == ' ' )
 		{
-			found = 1;
-			break;
+			node->child = separator->sibling;
+			separator->sibling = NULL;
+			ConsoleTrieFree(separator);
 		}
-		pElement = pElement->navigate.le_next;
-	}
+		ConsoleTriePrune(&c->trie, cmd, cmdLen);
 
-	if ( found == 1 )
-	{
 		LIST_REMOVE(pElement, navigate);
-		free(pElement);
+		CONSOLE_FREE(pElement);
 		result = 0;
 	}
 
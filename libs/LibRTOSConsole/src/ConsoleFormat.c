@@ -0,0 +1,536 @@
+/*
+ * ConsoleFormat.c
+ *
+ *  Created on: Jan 30, 2026
+ *      Author: Basti
+ */
+
+ /*! \file */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "ConsoleFormat.h"
+#include "ConsoleConfig.h"
+
+
+#ifndef CONSOLE_PRINTF_CHUNK
+#  define CONSOLE_PRINTF_CHUNK 64
+#endif
+
+#define FORMAT_MAX_PRECISION 9
+// 64 bit value in octal plus sign, point and the decimals of the fixed point conversion
+#define FORMAT_DIGITS_SIZE 48
+
+#define FORMAT_LEFT  0x01
+#define FORMAT_ZERO  0x02
+#define FORMAT_PLUS  0x04
+#define FORMAT_SPACE 0x08
+#define FORMAT_ALT   0x10
+
+// --------------------------------------------------------------------------------------------------------------------
+typedef struct fmtSink
+// --------------------------------------------------------------------------------------------------------------------
+{
+	char*  buff;
+	size_t size;    // usable chars of buff, without the terminating zero of a string output
+	size_t pos;
+	int    total;   // chars of the whole output, also the ones which did not fit
+	FILE*  stream;  // NULL cuts the output at size, otherwise a full buff is written to the stream
+	int    error;
+} fmtSink_t;
+
+// --------------------------------------------------------------------------------------------------------------------
+typedef struct fmtSpec
+// --------------------------------------------------------------------------------------------------------------------
+{
+	int flags;
+	int width;
+	int precision; // -1 if not given
+} fmtSpec_t;
+
+static const uint32_t formatPow10[FORMAT_MAX_PRECISION + 1] =
+{
+	1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+static void FormatFlush( fmtSink_t* s )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( s->stream != NULL && s->pos > 0 )
+	{
+		if ( fwrite(s->buff, 1, s->pos, s->stream) != s->pos ) s->error = 1;
+	}
+	s->pos = 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void FormatPut( fmtSink_t* s, const char* str, size_t len )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	s->total += (int)len;
+	while ( len > 0 )
+	{
+		if ( s->pos == s->size )
+		{
+			if ( s->stream == NULL ) return;
+			FormatFlush(s);
+		}
+		size_t n = s->size - s->pos;
+		if ( n > len ) n = len;
+		memcpy(&s->buff[s->pos], str, n);
+		s->pos += n;
+		str    += n;
+		len    -= n;
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void FormatPad( fmtSink_t* s, char c, int count )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// every field calls this for both sides, most of the time without padding
+	if ( count <= 0 ) return;
+	char pad[8];
+	memset(pad, c, sizeof(pad));
+	while ( count > 0 )
+	{
+		int n = ( count < (int)sizeof(pad) ) ? count : (int)sizeof(pad);
+		FormatPut(s, pad, (size_t)n);
+		count -= n;
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void FormatField( fmtSink_t* s, const fmtSpec_t* spec, const char* prefix, int prefixLen,
+		const char* body, int bodyLen, int zeros )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the zero padding goes between the sign or 0x and the digits, the space padding around all of them
+	int len = prefixLen + zeros + bodyLen;
+	int pad = ( spec->width > len ) ? spec->width - len : 0;
+
+	if ( ( spec->flags & FORMAT_LEFT ) == 0 )
+	{
+		if ( spec->flags & FORMAT_ZERO ) zeros += pad;
+		else FormatPad(s, ' ', pad);
+	}
+	FormatPut(s, prefix, (size_t)prefixLen);
+	FormatPad(s, '0', zeros);
+	FormatPut(s, body, (size_t)bodyLen);
+	if ( spec->flags & FORMAT_LEFT ) FormatPad(s, ' ', pad);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static char* FormatDigits( char* end, unsigned long long value, unsigned int base, int upper )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// written backwards from the end of the buffer. Only the part above 32 bits needs the 64 bit division, which is
+	// a library call on the Cortex-M7, the rest uses the hardware divider
+	const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	char* p = end;
+	while ( value > 0xFFFFFFFFull )
+	{
+		*--p = digits[value % base];
+		value /= base;
+	}
+	// the constant divisors become a multiplication or a shift, a division by the variable base would not
+	uint32_t v = (uint32_t)value;
+	if ( base == 10u )
+	{
+		do { *--p = (char)( '0' + v % 10u ); v /= 10u; } while ( v != 0 );
+	}
+	else if ( base == 16u )
+	{
+		do { *--p = digits[v & 15u]; v >>= 4; } while ( v != 0 );
+	}
+	else
+	{
+		do { *--p = digits[v & 7u]; v >>= 3; } while ( v != 0 );
+	}
+	return p;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int FormatSign( char* prefix, int negative, int flags )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( negative ) *prefix = '-';
+	else if ( flags & FORMAT_PLUS ) *prefix = '+';
+	else if ( flags & FORMAT_SPACE ) *prefix = ' ';
+	else return 0;
+	return 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void FormatInteger( fmtSink_t* s, fmtSpec_t* spec, unsigned long long value, int negative, char conversion )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	char buff[FORMAT_DIGITS_SIZE];
+	char* end = &buff[sizeof(buff)];
+	char prefix[2];
+	int prefixLen = 0;
+	unsigned int base = 10;
+
+	if ( conversion == 'x' || conversion == 'X' || conversion == 'p' ) base = 16;
+	else if ( conversion == 'o' ) base = 8;
+
+	// as in the stdlib, a precision disables the zero flag and a zero with precision 0 has no digits
+	char* p = end;
+	if ( spec->precision >= 0 ) spec->flags &= ~FORMAT_ZERO;
+	if ( value != 0 || spec->precision != 0 ) p = FormatDigits(end, value, base, conversion == 'X');
+	int len = (int)(end - p);
+	int zeros = ( spec->precision > len ) ? spec->precision - len : 0;
+
+	if ( conversion == 'd' || conversion == 'i' )
+	{
+		prefixLen = FormatSign(prefix, negative, spec->flags);
+	}
+	else if ( base == 16 && ( conversion == 'p' || ( ( spec->flags & FORMAT_ALT ) && value != 0 ) ) )
+	{
+		prefix[0] = '0';
+		prefix[1] = ( conversion == 'X' ) ? 'X' : 'x';
+		prefixLen = 2;
+	}
+	else if ( base == 8 && ( spec->flags & FORMAT_ALT ) && zeros == 0 && ( len == 0 || *p != '0' ) )
+	{
+		zeros = 1;
+	}
+	FormatField(s, spec, prefix, prefixLen, p, len, zeros);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int FormatFixedSingle( uint64_t bits, int precision, uint32_t* integer, uint32_t* decimals )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// almost every value comes from a float variable which has been promoted to double for the argument list. Such a
+	// value is the 24 bit mantissa m times 2^-k, so the integer part and the decimals are exact with 32 bit integers
+	// and one 32x32->64 multiplication, there is no double arithmetic which the single precision FPU of the
+	// Cortex-M7 would have to emulate. Values which are not exact as float or need more bits return -1
+	int exponent = (int)( ( bits >> 52 ) & 0x7FFu );
+	uint64_t fraction = bits & 0xFFFFFFFFFFFFFull;
+	if ( exponent == 0 && fraction == 0 )
+	{
+		*integer = 0;
+		*decimals = 0;
+		return 0;
+	}
+	if ( ( fraction & 0x1FFFFFFFu ) != 0 || exponent < 1023 - 126 || exponent > 1023 + 31 ) return -1;
+
+	uint32_t m = (uint32_t)( fraction >> 29 ) | 0x800000u;
+	int k = 23 - ( exponent - 1023 );
+	if ( k <= 0 )
+	{
+		*integer = m << -k;
+		*decimals = 0;
+		return 0;
+	}
+	if ( k > 32 ) return -1;
+
+	uint32_t part = ( k >= 24 ) ? m : ( m & ( ( 1u << k ) - 1u ) );
+	*integer = ( k >= 24 ) ? 0u : ( m >> k );
+
+	// the rest below the last decimal is exact, so the ties are real and rounded half to even like the stdlib does
+	uint64_t scaled = (uint64_t)part * formatPow10[precision];
+	uint64_t rest = scaled & ( ( 1ull << k ) - 1u );
+	uint64_t half = 1ull << ( k - 1 );
+	*decimals = (uint32_t)( scaled >> k );
+	uint32_t odd = ( precision == 0 ) ? ( *integer & 1u ) : ( *decimals & 1u );
+	if ( rest > half || ( rest == half && odd ) )
+	{
+		*decimals += 1u;
+		if ( *decimals >= formatPow10[precision] )
+		{
+			*decimals = 0;
+			*integer += 1u;
+		}
+	}
+	return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void FormatFixedDouble( double value, int precision, unsigned long long* integer, uint32_t* decimals )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// other values in double: integer part and the decimals scaled by 10^precision, each as integer. The
+	// subtraction is exact, only the scaling rounds. A result of exactly .5 can therefore hide a value slightly
+	// above or below, fma gives the exact error of the scaling in that rare case. Real ties are rounded half to
+	// even like the stdlib does (e.g. 0.125 -> 0.12)
+	*integer = (unsigned long long)value;
+	double fraction = value - (double)*integer;
+	double scaled = fraction * (double)formatPow10[precision];
+	*decimals = (uint32_t)scaled;
+	double rest = scaled - (double)*decimals;
+	if ( rest == 0.5 )
+	{
+		double error = fma(fraction, (double)formatPow10[precision], -scaled);
+		if ( error != 0.0 ) rest += ( error > 0.0 ) ? 0.25 : -0.25;
+	}
+	uint32_t odd = ( precision == 0 ) ? (uint32_t)( *integer & 1u ) : ( *decimals & 1u );
+	if ( rest > 0.5 || ( rest == 0.5 && odd ) )
+	{
+		*decimals += 1u;
+		if ( *decimals >= formatPow10[precision] )
+		{
+			*decimals = 0;
+			*integer += 1u;
+		}
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void FormatFixed( fmtSink_t* s, const fmtSpec_t* spec, double value )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	char buff[FORMAT_DIGITS_SIZE];
+	char* end = &buff[sizeof(buff)];
+	char prefix[1];
+	uint64_t bits;
+
+	// the sign bit also catches -0.0 and negative values which round to zero, as printf does
+	memcpy(&bits, &value, sizeof(bits));
+	int negative = ( bits >> 63 ) != 0;
+	int prefixLen = FormatSign(prefix, negative, spec->flags);
+	int precision = ( spec->precision < 0 ) ? 6 : spec->precision;
+	if ( precision > FORMAT_MAX_PRECISION ) precision = FORMAT_MAX_PRECISION;
+
+	unsigned long long integer;
+	uint32_t decimals;
+	uint32_t single;
+	if ( FormatFixedSingle(bits, precision, &single, &decimals) == 0 )
+	{
+		// a carry of the rounding can not overflow, the exponent limits the integer part to 2^32 - 2^8
+		integer = single;
+	}
+	else
+	{
+		if ( negative ) value = -value;
+		if ( value != value || value >= 18446744073709551616.0 )
+		{
+			fmtSpec_t text = *spec;
+			text.flags &= ~FORMAT_ZERO;
+			const char* body = ( value != value ) ? "nan" : ( value == value * 2.0 ) ? "inf" : "ovf";
+			FormatField(s, &text, prefix, prefixLen, body, 3, 0);
+			return;
+		}
+		FormatFixedDouble(value, precision, &integer, &decimals);
+	}
+
+	char* p = end;
+	for ( int i = 0; i < precision; i++ )
+	{
+		*--p = (char)( '0' + decimals % 10u );
+		decimals /= 10u;
+	}
+	if ( precision > 0 || ( spec->flags & FORMAT_ALT ) ) *--p = '.';
+	p = FormatDigits(p, integer, 10, 0);
+	FormatField(s, spec, prefix, prefixLen, p, (int)(end - p), 0);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void FormatRun( fmtSink_t* s, const char* format, va_list args )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	const char* f = format;
+	while ( *f != '\0' )
+	{
+		// the literal text up to the next conversion in one piece
+		const char* literal = f;
+		while ( *f != '\0' && *f != '%' ) f++;
+		if ( f != literal ) FormatPut(s, literal, (size_t)( f - literal ));
+		if ( *f == '\0' ) break;
+		const char* start = f++;
+
+		fmtSpec_t spec = { 0, 0, -1 };
+		for ( ;; f++ )
+		{
+			if      ( *f == '-' ) spec.flags |= FORMAT_LEFT;
+			else if ( *f == '0' ) spec.flags |= FORMAT_ZERO;
+			else if ( *f == '+' ) spec.flags |= FORMAT_PLUS;
+			else if ( *f == ' ' ) spec.flags |= FORMAT_SPACE;
+			else if ( *f == '#' ) spec.flags |= FORMAT_ALT;
+			else break;
+		}
+		if ( *f == '*' )
+		{
+			spec.width = va_arg(args, int);
+			if ( spec.width < 0 )
+			{
+				spec.flags |= FORMAT_LEFT;
+				spec.width = -spec.width;
+			}
+			f++;
+		}
+		else
+		{
+			while ( *f >= '0' && *f <= '9' ) spec.width = spec.width * 10 + ( *f++ - '0' );
+		}
+		if ( *f == '.' )
+		{
+			f++;
+			spec.precision = 0;
+			if ( *f == '*' )
+			{
+				spec.precision = va_arg(args, int);
+				if ( spec.precision < 0 ) spec.precision = -1;
+				f++;
+			}
+			else
+			{
+				while ( *f >= '0' && *f <= '9' ) spec.precision = spec.precision * 10 + ( *f++ - '0' );
+			}
+		}
+		if ( spec.flags & FORMAT_LEFT ) spec.flags &= ~FORMAT_ZERO;
+
+		// length modifier: 'H' and 'L' stand for hh and ll
+		char length = '\0';
+		if ( *f == 'h' || *f == 'l' || *f == 'z' || *f == 'j' || *f == 't' )
+		{
+			length = *f++;
+			if ( length == 'h' && *f == 'h' ) { length = 'H'; f++; }
+			else if ( length == 'l' && *f == 'l' ) { length = 'L'; f++; }
+		}
+
+		char conversion = *f;
+		if ( conversion == '\0' )
+		{
+			FormatPut(s, start, (size_t)( f - start ));
+			break;
+		}
+		f++;
+
+		switch ( conversion )
+		{
+			case 'd':
+			case 'i':
+			{
+				long long v;
+				if      ( length == 'L' || length == 'j' ) v = va_arg(args, long long);
+				else if ( length == 'l' ) v = va_arg(args, long);
+				else if ( length == 'z' || length == 't' ) v = (long long)va_arg(args, ptrdiff_t);
+				else if ( length == 'h' ) v = (short)va_arg(args, int);
+				else if ( length == 'H' ) v = (signed char)va_arg(args, int);
+				else v = va_arg(args, int);
+				unsigned long long magnitude = ( v < 0 ) ? 0ull - (unsigned long long)v : (unsigned long long)v;
+				FormatInteger(s, &spec, magnitude, v < 0, conversion);
+				break;
+			}
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o':
+			{
+				unsigned long long v;
+				if      ( length == 'L' || length == 'j' ) v = va_arg(args, unsigned long long);
+				else if ( length == 'l' ) v = va_arg(args, unsigned long);
+				else if ( length == 'z' || length == 't' ) v = va_arg(args, size_t);
+				else if ( length == 'h' ) v = (unsigned short)va_arg(args, unsigned int);
+				else if ( length == 'H' ) v = (unsigned char)va_arg(args, unsigned int);
+				else v = va_arg(args, unsigned int);
+				FormatInteger(s, &spec, v, 0, conversion);
+				break;
+			}
+			case 'p':
+			{
+				spec.flags &= ~FORMAT_ZERO;
+				FormatInteger(s, &spec, (uintptr_t)va_arg(args, void*), 0, 'p');
+				break;
+			}
+			case 'f':
+			case 'F':
+			{
+				FormatFixed(s, &spec, va_arg(args, double));
+				break;
+			}
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			{
+				// there is no exponent notation, the conversion is printed as it is so the missing value is visible.
+				// Unlike an unknown conversion the argument is known and taken, the following ones stay in place
+				(void)va_arg(args, double);
+				FormatPut(s, start, (size_t)( f - start ));
+				break;
+			}
+			case 'c':
+			{
+				char c = (char)va_arg(args, int);
+				spec.flags &= ~FORMAT_ZERO;
+				FormatField(s, &spec, NULL, 0, &c, 1, 0);
+				break;
+			}
+			case 's':
+			{
+				const char* str = va_arg(args, const char*);
+				if ( str == NULL ) str = "(null)";
+				size_t len = ( spec.precision >= 0 ) ? strnlen(str, (size_t)spec.precision) : strlen(str);
+				spec.flags &= ~FORMAT_ZERO;
+				FormatField(s, &spec, NULL, 0, str, (int)len, 0);
+				break;
+			}
+			case '%':
+			{
+				FormatPut(s, "%", 1);
+				break;
+			}
+			default:
+			{
+				// unknown conversions are printed as they are, there is no argument which could be taken
+				FormatPut(s, start, (size_t)( f - start ));
+				break;
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int CONSOLE_VPrintf( const char* format, va_list args )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	char chunk[CONSOLE_PRINTF_CHUNK];
+	fmtSink_t s = { chunk, sizeof(chunk), 0, 0, stdout, 0 };
+
+	if ( format == NULL ) return -1;
+	FormatRun(&s, format, args);
+	FormatFlush(&s);
+	return s.error ? -1 : s.total;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int CONSOLE_Printf( const char* format, ... )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	va_list args;
+	va_start(args, format);
+	int result = CONSOLE_VPrintf(format, args);
+	va_end(args);
+	return result;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int CONSOLE_VSnprintf( char* buffer, size_t size, const char* format, va_list args )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	fmtSink_t s = { buffer, ( size > 0 ) ? size - 1 : 0, 0, 0, NULL, 0 };
+
+	if ( format == NULL ) return -1;
+	FormatRun(&s, format, args);
+	if ( size > 0 ) buffer[s.pos] = '\0';
+	return s.total;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int CONSOLE_Snprintf( char* buffer, size_t size, const char* format, ... )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	va_list args;
+	va_start(args, format);
+	int result = CONSOLE_VSnprintf(buffer, size, format, args);
+	va_end(args);
+	return result;
+}
@@ -0,0 +1,209 @@
+/*
+ * ConsoleLine.c
+ *
+ *  Created on: Feb 2, 2026
+ *      Author: Basti
+ */
+
+ /*! \file */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ConsoleLine.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+void ConsoleRedrawPut( redrawBuffer_t* r, const char* data, int len )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	while ( len > 0 )
+	{
+		// only a list of completion candidates can be larger than the buffer, then it is written in parts
+		if ( r->length == (int)sizeof(r->buff) )
+		{
+			CONSOLE_REDRAW_WRITE(r->buff, r->length);
+			r->length = 0;
+		}
+		int part = (int)sizeof(r->buff) - r->length;
+		if ( part > len ) part = len;
+		memcpy(&r->buff[r->length], data, part);
+		r->length += part;
+		data += part;
+		len -= part;
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+void ConsoleRedrawCursor( redrawBuffer_t* r, int columns, char direction )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// moves the cursor by the given number of columns to the left ('D') or to the right ('C')
+	if ( columns <= 0 ) return;
+	char seq[16];
+	int len = snprintf(seq, sizeof(seq), "\033[%d%c", columns, direction);
+	ConsoleRedrawPut(r, seq, len);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+void ConsoleRedrawFlush( redrawBuffer_t* r )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the complete screen update of one keystroke is passed to the stream with a single write
+	if ( r->length > 0 )
+	{
+		CONSOLE_REDRAW_WRITE(r->buff, r->length);
+		r->length = 0;
+	}
+	CONSOLE_REDRAW_FLUSH();
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+void ConsoleLineInsert( redrawBuffer_t* r, char* lineBuff, unsigned int* lbPtr, const char* chars, int num )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the caller makes sure that the line has space for the new chars
+	int lineLen = (int)strnlen(lineBuff, CONSOLE_LINE_SIZE);
+	memmove(&lineBuff[*lbPtr + num], &lineBuff[*lbPtr], lineLen - *lbPtr);
+	memcpy(&lineBuff[*lbPtr], chars, num);
+	lineLen += num;
+
+	// the new chars and the moved tail are printed, then the cursor goes back behind the new chars
+	ConsoleRedrawPut(r, &lineBuff[*lbPtr], lineLen - *lbPtr);
+	*lbPtr += num;
+	ConsoleRedrawCursor(r, lineLen - *lbPtr, 'D');
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+void ConsoleLineDelete( redrawBuffer_t* r, char* lineBuff, unsigned int pos )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// removes the char below the cursor, which must be at the given position
+	int lineLen = (int)strnlen(lineBuff, CONSOLE_LINE_SIZE);
+	if ( (int)pos >= lineLen ) return;
+	memmove(&lineBuff[pos], &lineBuff[pos + 1], lineLen - pos - 1);
+	lineBuff[lineLen - 1] = '\0';
+
+	// the moved tail is printed and the last char on the screen is erased
+	ConsoleRedrawPut(r, &lineBuff[pos], lineLen - pos - 1);
+	ConsoleRedrawPut(r, " ", 1);
+	ConsoleRedrawCursor(r, lineLen - pos, 'D');
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+void ConsoleLineReplace( redrawBuffer_t* r, char* lineBuff, unsigned int* lbPtr, const char* newLine )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// back to the begin of the input, print the new content and erase the rest of the old one
+	int newLen = (int)strnlen(newLine, CONSOLE_LINE_SIZE);
+	ConsoleRedrawCursor(r, *lbPtr, 'D');
+	memset(lineBuff, '\0', CONSOLE_LINE_SIZE);
+	memcpy(lineBuff, newLine, newLen);
+	ConsoleRedrawPut(r, lineBuff, newLen);
+	ConsoleRedrawPut(r, "\033[K", 3);
+	*lbPtr = newLen;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+void ConsolePrompt( redrawBuffer_t* r, const char* username, int result )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// new console line with the decoded result of the last command
+	ConsoleRedrawPut(r, "\r\n", 2);
+	ConsoleRedrawPut(r, username, (int)strlen(username));
+	if (result == 0)
+	{
+		ConsoleRedrawPut(r, "(\033[32m\xE2\x9C\x93\033[0m) $>", 17);
+	}
+	else
+	{
+		ConsoleRedrawPut(r, "(\033[31m\xE2\x98\x93\033[0m) $>", 17);
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int ConsoleTokenize( char* line, int lineSize, cmdSlice_t* slices, int maxSlices )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the line is tokenized in one single pass. Every token is described by a pointer into the line and its length.
+	// A token starting with a quote runs until the closing quote (or the end of the line) and is returned without
+	// the quotes. The separator behind a token is overwritten with a terminator, so every slice can be passed as
+	// argument string directly without copying anything
+	int numSlices = 0;
+	int i = 0;
+	while ( i < lineSize && line[i] != '\0' )
+	{
+		if ( line[i] == ' ' )
+		{
+			i += 1;
+			continue;
+		}
+
+		if ( numSlices >= maxSlices ) return -1;
+
+		int quoted = ( line[i] == '"' );
+		if ( quoted ) i += 1;
+
+		int start = i;
+		while ( i < lineSize && line[i] != '\0' && line[i] != ( quoted ? '"' : ' ' ) )
+		{
+			i += 1;
+		}
+
+		slices[numSlices].ptr = &line[start];
+		slices[numSlices].len = i - start;
+		numSlices += 1;
+
+		// terminate the slice, behind the last char there is always a nulled safety margin
+		if ( i < lineSize && line[i] != '\0' )
+		{
+			line[i] = '\0';
+			i += 1;
+		}
+	}
+
+	return numSlices;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int ConsoleAliasQuote( char* buff, int size, int argc, char** argv )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// joins the arguments separated by a space. Arguments which contain spaces (or are empty) must be quoted again,
+	// otherwise the tokenizer would split them while the alias is registered. There is no escape char, a quote
+	// inside an argument stays as it is
+	int len = 0;
+	memset(buff, 0, size);
+	for ( int i = 0; i < argc; i++ )
+	{
+		int argLen = (int)strnlen(argv[i], size);
+		int quote = ( argLen == 0 ) || ( memchr(argv[i], ' ', argLen) != NULL );
+		// one more char for the separator or, behind the last argument, the terminator
+		if ( ( len + 1 ) + argLen + ( quote ? 2 : 0 ) > size ) return -1;
+
+		if ( quote ) buff[len++] = '"';
+		memcpy(&buff[len], argv[i], argLen);
+		len += argLen;
+		if ( quote ) buff[len++] = '"';
+		if ( ( i + 1 ) != argc ) buff[len++] = ' ';
+	}
+	return len;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int ConsoleAliasSplice( char** expanded, int maxArgs, char* tokens, const unsigned char* offset, int aliasArgc,
+		char** args, int numArgs )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the first alias token is the command, the others go in front of the arguments the user has passed
+	int aliasArgs = aliasArgc - 1;
+	if ( aliasArgs + numArgs > maxArgs ) return -1;
+
+	// the args might already point to the expanded array, so the move must be overlap safe
+	memmove(&expanded[aliasArgs], args, numArgs * sizeof(char*));
+	for ( int i = 0; i < aliasArgs; i++ )
+	{
+		expanded[i] = &tokens[offset[i + 1]];
+	}
+	expanded[aliasArgs + numArgs] = NULL;
+	return aliasArgs + numArgs;
+}
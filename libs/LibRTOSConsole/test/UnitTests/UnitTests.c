@@ -0,0 +1,416 @@
+
+// standard includes for the unit test framework
+#include <stdio.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdint.h>
+#include <string.h>
+
+// includes for the library, only the line editor and the tokenizer which do not need FreeRTOS
+#include "ConsoleLine.h"
+
+
+// ====================================================================================================================
+// area of state helpers and mockup functions
+// ====================================================================================================================
+
+#define TEST_USERNAME   "STM32"
+
+struct myState
+{
+	redrawBuffer_t  redraw;
+	char            line[CONSOLE_LINE_SIZE + 4];
+	unsigned int    cursor;
+
+	// everything which has been passed to the stream since the last reset
+	unsigned int    writeCalls;
+	unsigned int    flushCalls;
+	unsigned int    bytes;
+	char            screen[4 * CONSOLE_REDRAW_SIZE];
+};
+
+static struct myState myState;
+
+// --------------------------------------------------------------------------------------------------------------------
+void TestRedrawWrite( const char* data, int len )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	myState.writeCalls += 1;
+	if ( myState.bytes + len < sizeof(myState.screen) ) memcpy(&myState.screen[myState.bytes], data, len);
+	myState.bytes += len;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+void TestRedrawFlush( void )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	myState.flushCalls += 1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void myResetCounters( void )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	myState.writeCalls = 0;
+	myState.flushCalls = 0;
+	myState.bytes = 0;
+	memset(myState.screen, 0, sizeof(myState.screen));
+}
+
+// types the string at the cursor, one keystroke and one flush per char as the console processor does it
+// --------------------------------------------------------------------------------------------------------------------
+static void myType( const char* text )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	for ( ; *text != '\0'; text++ )
+	{
+		ConsoleLineInsert(&myState.redraw, myState.line, &myState.cursor, text, 1);
+		ConsoleRedrawFlush(&myState.redraw);
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int myStartFixtureFunction( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	memset(&myState, 0, sizeof(myState));
+	*state = &myState;
+	return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int myStopFixtureFunction( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	(void)state;
+	return 0;
+}
+
+
+// ====================================================================================================================
+// area of test functions
+// ====================================================================================================================
+
+// a char at the end of the line is echoed with exactly one byte in one write
+// --------------------------------------------------------------------------------------------------------------------
+static void keystroke_append_at_end( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	for ( const char* c = "stepper move 10"; *c != '\0'; c++ )
+	{
+		char key[2] = { *c, '\0' };
+		myResetCounters();
+		myType(key);
+		assert_int_equal(s->writeCalls, 1);
+		assert_int_equal(s->flushCalls, 1);
+		assert_int_equal(s->bytes, 1);
+		assert_int_equal(s->screen[0], *c);
+	}
+	assert_string_equal(s->line, "stepper move 10");
+	assert_int_equal(s->cursor, 15);
+}
+
+// an insert in the middle reprints the tail and moves the cursor back, still with a single write
+// --------------------------------------------------------------------------------------------------------------------
+static void keystroke_insert_in_middle( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	myType("stepper move 10");
+	s->cursor = 8;
+
+	myResetCounters();
+	myType("x");
+	assert_string_equal(s->line, "stepper xmove 10");
+	assert_int_equal(s->cursor, 9);
+	assert_int_equal(s->writeCalls, 1);
+	assert_int_equal(s->flushCalls, 1);
+	// the new char, the 7 chars of the tail and ESC [ 7 D
+	assert_int_equal(s->bytes, 1 + 7 + 4);
+	assert_string_equal(s->screen, "xmove 10\033[7D");
+}
+
+// the bytes of an insert grow with the tail only, the write calls stay at one per keystroke
+// --------------------------------------------------------------------------------------------------------------------
+static void keystroke_insert_full_line( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	char text[CONSOLE_LINE_SIZE];
+	memset(text, 'a', sizeof(text) - 1);
+	text[sizeof(text) - 1] = '\0';
+	myType(text);
+	s->cursor = 0;
+
+	myResetCounters();
+	myType("b");
+	assert_int_equal(s->writeCalls, 1);
+	assert_int_equal(s->flushCalls, 1);
+	// the new char, the whole old line and ESC [ 119 D
+	assert_int_equal(s->bytes, 1 + (CONSOLE_LINE_SIZE - 1) + 6);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void keystroke_delete_in_middle( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	myType("stepper xmove 10");
+
+	myResetCounters();
+	ConsoleLineDelete(&s->redraw, s->line, 8);
+	ConsoleRedrawFlush(&s->redraw);
+	assert_string_equal(s->line, "stepper move 10");
+	assert_int_equal(s->writeCalls, 1);
+	// the moved tail, a blank over the last char and ESC [ 8 D
+	assert_int_equal(s->bytes, 7 + 1 + 4);
+	assert_string_equal(s->screen, "move 10 \033[8D");
+
+	// behind the end of the line nothing happens
+	myResetCounters();
+	ConsoleLineDelete(&s->redraw, s->line, 15);
+	ConsoleRedrawFlush(&s->redraw);
+	assert_int_equal(s->writeCalls, 0);
+	assert_int_equal(s->flushCalls, 1);
+	assert_int_equal(s->bytes, 0);
+}
+
+// a line from the history replaces the input with one write
+// --------------------------------------------------------------------------------------------------------------------
+static void keystroke_history_replace( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	myType("stepper status");
+
+	myResetCounters();
+	ConsoleLineReplace(&s->redraw, s->line, &s->cursor, "top");
+	ConsoleRedrawFlush(&s->redraw);
+	assert_string_equal(s->line, "top");
+	assert_int_equal(s->cursor, 3);
+	assert_int_equal(s->writeCalls, 1);
+	assert_string_equal(s->screen, "\033[14Dtop\033[K");
+}
+
+// the prompt and the echo of a finished line are collected, a flush without content does not write
+// --------------------------------------------------------------------------------------------------------------------
+static void prompt_single_write( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	myResetCounters();
+	ConsoleRedrawPut(&s->redraw, "\r\n", 2);
+	ConsolePrompt(&s->redraw, TEST_USERNAME, 0);
+	ConsoleRedrawFlush(&s->redraw);
+	assert_int_equal(s->writeCalls, 1);
+	assert_int_equal(s->bytes, 2 + 2 + strlen(TEST_USERNAME) + 17);
+
+	myResetCounters();
+	ConsoleRedrawFlush(&s->redraw);
+	assert_int_equal(s->writeCalls, 0);
+	assert_int_equal(s->flushCalls, 1);
+}
+
+// only output which is larger than the buffer, e.g. a long list of completion candidates, is written in parts
+// --------------------------------------------------------------------------------------------------------------------
+static void redraw_overflow_in_parts( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	char text[CONSOLE_REDRAW_SIZE + 10];
+	memset(text, 'c', sizeof(text));
+
+	myResetCounters();
+	ConsoleRedrawPut(&s->redraw, text, sizeof(text));
+	assert_int_equal(s->writeCalls, 1);
+	assert_int_equal(s->bytes, CONSOLE_REDRAW_SIZE);
+	ConsoleRedrawFlush(&s->redraw);
+	assert_int_equal(s->writeCalls, 2);
+	assert_int_equal(s->bytes, sizeof(text));
+}
+
+// tokenizes the text in a copy with the nulled safety margin behind the last char, as the console processor does
+// --------------------------------------------------------------------------------------------------------------------
+static int myTokenize( const char* text, cmdSlice_t* slices, int maxSlices )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	memset(myState.line, 0, sizeof(myState.line));
+	strcpy(myState.line, text);
+	return ConsoleTokenize(myState.line, (int)strlen(text), slices, maxSlices);
+}
+
+// the slices are terminated in place, so each of them is a string which points into the line
+// --------------------------------------------------------------------------------------------------------------------
+static void tokenize_plain( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	cmdSlice_t slices[8];
+
+	assert_int_equal(myTokenize("  stepper   move 10  ", slices, 8), 3);
+	assert_string_equal(slices[0].ptr, "stepper");
+	assert_int_equal(slices[0].len, 7);
+	assert_string_equal(slices[1].ptr, "move");
+	assert_string_equal(slices[2].ptr, "10");
+	assert_true(slices[0].ptr == &s->line[2]);
+
+	assert_int_equal(myTokenize("", slices, 8), 0);
+	assert_int_equal(myTokenize("   ", slices, 8), 0);
+
+	// one more token than slices is an error
+	assert_int_equal(myTokenize("a b c", slices, 3), 3);
+	assert_int_equal(myTokenize("a b c d", slices, 3), -1);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void tokenize_quoted( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	(void)state;
+	cmdSlice_t slices[8];
+
+	// the quotes are removed, the spaces inside are kept
+	assert_int_equal(myTokenize("echo \"hello  world\" end", slices, 8), 3);
+	assert_string_equal(slices[1].ptr, "hello  world");
+	assert_int_equal(slices[1].len, 12);
+	assert_string_equal(slices[2].ptr, "end");
+
+	// an empty quoted token is an argument of length 0
+	assert_int_equal(myTokenize("alias x \"\"", slices, 8), 3);
+	assert_int_equal(slices[2].len, 0);
+	assert_string_equal(slices[2].ptr, "");
+
+	// a missing closing quote runs until the end of the line
+	assert_int_equal(myTokenize("echo \"open end", slices, 8), 2);
+	assert_string_equal(slices[1].ptr, "open end");
+
+	// a closing quote directly followed by a char ends the token, the char starts the next one
+	assert_int_equal(myTokenize("\"ab\"cd", slices, 8), 2);
+	assert_string_equal(slices[0].ptr, "ab");
+	assert_string_equal(slices[1].ptr, "cd");
+}
+
+// there is no escape char, backslashes and quotes inside a token stay as they are
+// --------------------------------------------------------------------------------------------------------------------
+static void tokenize_escaped( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	(void)state;
+	cmdSlice_t slices[8];
+
+	assert_int_equal(myTokenize("echo a\\ b", slices, 8), 3);
+	assert_string_equal(slices[1].ptr, "a\\");
+	assert_string_equal(slices[2].ptr, "b");
+
+	assert_int_equal(myTokenize("echo say\"hi\" \"x\\\"", slices, 8), 3);
+	assert_string_equal(slices[1].ptr, "say\"hi\"");
+	assert_string_equal(slices[2].ptr, "x\\");
+
+	// the alias command quotes arguments with spaces and empty ones again, the tokenizer gives them back unchanged
+	char* argv[] = { "stepper", "move", "a b", "", "c\"d" };
+	char buff[CONSOLE_LINE_SIZE];
+	int len = ConsoleAliasQuote(buff, sizeof(buff), 5, argv);
+	assert_string_equal(buff, "stepper move \"a b\" \"\" c\"d");
+	assert_int_equal(len, (int)strlen(buff));
+	assert_int_equal(myTokenize(buff, slices, 8), 5);
+	for ( int i = 0; i < 5; i++ )
+	{
+		assert_string_equal(slices[i].ptr, argv[i]);
+	}
+
+	// the terminator must fit as well
+	assert_int_equal(ConsoleAliasQuote(buff, len + 1, 5, argv), len);
+	assert_int_equal(ConsoleAliasQuote(buff, len, 5, argv), -1);
+}
+
+// an alias is tokenized once, its tokens are spliced in front of the arguments of the user
+// --------------------------------------------------------------------------------------------------------------------
+static void alias_expansion( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	(void)state;
+	char tokens[2][32] = { "stepper move -a", "mv \"1 0\"" };
+	unsigned char offset[2][8];
+	int argc[2];
+	cmdSlice_t slices[8];
+
+	// registered as "mv" and "mv10", the offsets point to the terminated tokens
+	for ( int a = 0; a < 2; a++ )
+	{
+		argc[a] = ConsoleTokenize(tokens[a], (int)strlen(tokens[a]), slices, 8);
+		for ( int i = 0; i < argc[a]; i++ )
+		{
+			offset[a][i] = (unsigned char)( slices[i].ptr - tokens[a] );
+		}
+	}
+	assert_int_equal(argc[0], 3);
+	assert_int_equal(argc[1], 2);
+
+	// "mv10 -r" expands to "mv" "1 0" "-r" and further to "stepper" "move" "-a" "1 0" "-r"
+	char* user[] = { "-r" };
+	char* expanded[9];
+	int numArgs = ConsoleAliasSplice(expanded, 8, tokens[1], offset[1], argc[1], user, 1);
+	assert_int_equal(numArgs, 2);
+	assert_string_equal(&tokens[1][offset[1][0]], "mv");
+	assert_string_equal(expanded[0], "1 0");
+	assert_string_equal(expanded[1], "-r");
+	assert_null(expanded[2]);
+
+	// the nested expansion moves the args within the same array
+	numArgs = ConsoleAliasSplice(expanded, 8, tokens[0], offset[0], argc[0], expanded, numArgs);
+	assert_int_equal(numArgs, 4);
+	assert_string_equal(&tokens[0][offset[0][0]], "stepper");
+	assert_string_equal(expanded[0], "move");
+	assert_string_equal(expanded[1], "-a");
+	assert_string_equal(expanded[2], "1 0");
+	assert_string_equal(expanded[3], "-r");
+	assert_null(expanded[4]);
+
+	// more arguments than the array can hold
+	assert_int_equal(ConsoleAliasSplice(expanded, 5, tokens[0], offset[0], argc[0], expanded, numArgs), -1);
+	assert_int_equal(ConsoleAliasSplice(expanded, 6, tokens[0], offset[0], argc[0], expanded, numArgs), 6);
+}
+
+
+// ====================================================================================================================
+// area of main entry point and test execution as well as its corresponding variables
+// ====================================================================================================================
+
+// bytes and write calls per keystroke of the line editor
+// --------------------------------------------------------------------------------------------------------------------
+const struct CMUnitTest line_editor_tests[] = {
+	cmocka_unit_test_setup_teardown(keystroke_append_at_end,    myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(keystroke_insert_in_middle, myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(keystroke_insert_full_line, myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(keystroke_delete_in_middle, myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(keystroke_history_replace,  myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(prompt_single_write,        myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(redraw_overflow_in_parts,   myStartFixtureFunction, myStopFixtureFunction),
+};
+
+// slices of the tokenizer and the expansion of aliases
+// --------------------------------------------------------------------------------------------------------------------
+const struct CMUnitTest tokenizer_tests[] = {
+	cmocka_unit_test_setup_teardown(tokenize_plain,   myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(tokenize_quoted,  myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(tokenize_escaped, myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(alias_expansion,  myStartFixtureFunction, myStopFixtureFunction),
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+int main()
+// --------------------------------------------------------------------------------------------------------------------
+{
+	int result = 0;
+	cmocka_set_message_output(CM_OUTPUT_STDOUT);
+	result |= cmocka_run_group_tests(line_editor_tests, NULL, NULL);
+	result |= cmocka_run_group_tests(tokenizer_tests, NULL, NULL);
+	return result;
+}
@@ -0,0 +1,25 @@
+/*
+ * ConsoleConfig.h
+ *
+ *  Created on: Feb 2, 2026
+ *      Author: Basti
+ */
+
+ /*! \file */
+
+/*!
+ * configuration of the unit tests, the screen updates of the line editor are counted instead of written to stdout
+ */
+
+#ifndef INC_CONSOLE_CONSOLECONFIG_H_
+#define INC_CONSOLE_CONSOLECONFIG_H_
+
+#define CONSOLE_LINE_SIZE 120
+
+void TestRedrawWrite( const char* data, int len );
+void TestRedrawFlush( void );
+
+#define CONSOLE_REDRAW_WRITE(data, len) TestRedrawWrite((data), (len))
+#define CONSOLE_REDRAW_FLUSH() TestRedrawFlush()
+
+#endif /* INC_CONSOLE_CONSOLECONFIG_H_ */
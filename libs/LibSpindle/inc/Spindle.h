@@ -11,6 +11,7 @@
 #define INC_SPINDLE_CONTROLLER_H_
 
 #include "Console.h"
+#include "SpindleControl.h"
 
 /*!
  * The SpindleHandle_t handle is an instance pointer of the spindle library which is generated whenever
@@ -120,16 +121,169 @@ typedef struct SpindlePhysicalParams
 	float        minRPM;
 
 	/*!
-	 * optional context pointer for platform abstraction. can be null.
+	 * optional context pointer for platform abstraction. can be null. With more than one spindle it selects
+	 * the hardware of the instance, for example the timer and the enable pins.
 	 */
 	void*        context;
 
+	/*!
+	 * optional name of the console command of the instance, "spindle" when it is null. Every instance needs
+	 * its own name, for example "spindle" and "spindle2".
+	 */
+	const char*  name;
+
+	/*!
+	 * This optional function pointer returns the measured absolute speed of the spindle in RPM, for example from
+	 * the edge timing of a tacho input. When it is set, the library runs a PI controller with a fixed rate which
+	 * corrects the duty cycle until the measured speed matches the commanded RPM. When it is null, the spindle is
+	 * driven open loop with the duty cycle of the calibration table or |RPM| / maxRPM.
+	 *
+	 * The function is called from the spindle controller task and must not block.
+	 *
+     * @param[in,out] h         optional handle of the spindle library.
+     * @param[in,out] context   optional context pointer the user has passed by the SPINDLE_CreateInstance call.
+	 */
+	float (*getMeasuredRPM)(SpindleHandle_t h, void* context);
+
+	/*!
+	 * proportional gain of the speed controller in duty cycle per RPM of speed error. Only used with getMeasuredRPM.
+	 */
+	float        kp;
+
+	/*!
+	 * integral gain of the speed controller in duty cycle per RPM of speed error and second. Only used with
+	 * getMeasuredRPM.
+	 */
+	float        ki;
+
+	/*!
+	 * period of the ramp generator and the speed controller in milliseconds, 0 selects the default of 10 ms.
+	 */
+	unsigned int controlPeriodMs;
+
+	/*!
+	 * acceleration of the speed ramp in RPM per second, which is used for start, stop and speed changes.
+	 * A reversal passes through zero with the same acceleration. 0 disables the ramp and sets a new speed at once.
+	 */
+	float        acceleration;
+
+	/*!
+	 * optional jerk limit in RPM per second squared, which turns the linear ramp into an S-curve. 0 keeps the
+	 * linear ramp. Only used with an acceleration.
+	 */
+	float        jerk;
+
+	/*!
+	 * This optional function pointer loads a persisted calibration table. It is called once when the spindle
+	 * instance is initialized by the controller task and returns 0 when the table has been loaded. An invalid table is ignored.
+	 *
+     * @param[in,out] h         optional handle of the spindle library.
+     * @param[in,out] context   optional context pointer the user has passed by the SPINDLE_CreateInstance call.
+     * @param[out]    table     table which is filled by the function
+	 */
+	int (*loadCalibration)(SpindleHandle_t h, void* context, SpindleCalibration_t* table);
+
+	/*!
+	 * This optional function pointer persists the calibration table after SPINDLE_Calibrate or SPINDLE_SetCalibration.
+	 * It returns 0 on success. It is called from the spindle controller task while the spindle is stopped. It may
+	 * refuse to store, e.g. while a flash erase would stall other motion; the table is used anyway and the call
+	 * which has passed it returns -1.
+	 *
+     * @param[in,out] h         optional handle of the spindle library.
+     * @param[in,out] context   optional context pointer the user has passed by the SPINDLE_CreateInstance call.
+     * @param[in]     table     table to store
+	 */
+	int (*storeCalibration)(SpindleHandle_t h, void* context, const SpindleCalibration_t* table);
+
+	/*!
+	 * time in milliseconds the calibration waits for the spindle to settle at each duty cycle, 0 selects the
+	 * default of 1500 ms.
+	 */
+	unsigned int calibrationSettleMs;
+
 } SpindlePhysicalParams_t;
 
 /*!
- * The SPINDLE_CreateInstance function is used to create the spindle controller. There is a singleton pattern implemented
- * for the controller so there is only one instance possible for the design. In case it is called multiple times, it returns
- * the instance pointer of the first created spindle controller
+ * The SpindleStatus_t structure is filled by SPINDLE_GetStatus with the state of the spindle controller.
+ */
+typedef struct SpindleStatus
+{
+	/*!
+	 * 1 while the spindle output is enabled, 0 otherwise
+	 */
+	int          running;
+
+	/*!
+	 * commanded speed in RPM after limitation, negative for backward rotation
+	 */
+	float        speed;
+
+	/*!
+	 * measured speed in RPM when there is a getMeasuredRPM function, otherwise the speed of the ramp
+	 */
+	float        measured;
+} SpindleStatus_t;
+
+/*!
+ * fault flags of the SpindleSnapshot_t structure. SPINDLE_FAULT_NO_FEEDBACK is set when the measured speed stays 0
+ * for half a second while the spindle should turn, SPINDLE_FAULT_SATURATED while the controller output is limited
+ * to full duty. The no feedback flag is kept until the spindle is started again. While it is set the integral part
+ * of the controller is reset and the duty cycle is taken from the open loop calibration table instead.
+ */
+#define SPINDLE_FAULT_NO_FEEDBACK   0x01
+#define SPINDLE_FAULT_SATURATED     0x02
+
+/*!
+ * The SpindleSnapshot_t structure is published by the spindle controller task after every command and every
+ * control step and read with SPINDLE_GetSnapshot.
+ */
+typedef struct SpindleSnapshot
+{
+	/*!
+	 * incremented with every published snapshot
+	 */
+	unsigned int sequence;
+
+	/*!
+	 * commanded speed in RPM after limitation, negative for backward rotation
+	 */
+	float        setpoint;
+
+	/*!
+	 * measured speed in RPM when there is a getMeasuredRPM function, otherwise the speed of the ramp
+	 */
+	float        measured;
+
+	/*!
+	 * current speed of the ramp in RPM, equal to the setpoint when there is no acceleration
+	 */
+	float        ramp;
+
+	/*!
+	 * 1 while the output turns the spindle backward
+	 */
+	int          backward;
+
+	/*!
+	 * 1 while the spindle output is enabled, 0 otherwise
+	 */
+	int          running;
+
+	/*!
+	 * 1 when the ramp has arrived at the setpoint
+	 */
+	int          atSpeed;
+
+	/*!
+	 * combination of the SPINDLE_FAULT_* flags
+	 */
+	unsigned int faults;
+} SpindleSnapshot_t;
+
+/*!
+ * The SPINDLE_CreateInstance function is used to create a spindle controller. Every call creates a new instance with its
+ * own platform functions and console command. All instances are served by one controller task with one command queue,
+ * which is created by the first call, so uxStackDepth and xPrio of later calls are not used.
  *
  * The return value of SPINDLE_CreateInstance is a null pointer in case an error occured or a pointer of type SpindleHandle_t.
  *
@@ -140,11 +294,201 @@ typedef struct SpindlePhysicalParams
  * param p of type SpindlePhysicalParams_t* is a pointer to the platform abstraction functions
  * 
  * ATTENTION: This function is not locked or guarded and therefore its never thread safe when calling from two different threads
- * at the same or nearly the same time while no instance has been created before! One pointer and its ressources could be lost
- * which leads to a memory leak and/or to console command registration issues at runtime when using the spindle command!
+ * at the same or nearly the same time while no instance has been created before! Two controller tasks could be created
+ * which leads to a memory leak and to instances which are never served!
  */
 SpindleHandle_t SPINDLE_CreateInstance( unsigned int uxStackDepth, int xPrio, ConsoleHandle_t cH, SpindlePhysicalParams_t* p );
 
+/*!
+ * number of commands of the queue of the controller task
+ */
+#define SPINDLE_STATIC_QUEUE_LENGTH  16
+
+#if defined(configSUPPORT_STATIC_ALLOCATION) && ( configSUPPORT_STATIC_ALLOCATION == 1 )
+#include "task.h"
+#include "queue.h"
+#include "event_groups.h"
+
+/*!
+ * number of pointer sized words which are reserved for one command of the queue of the controller task
+ */
+#define SPINDLE_STATIC_COMMAND_WORDS 8
+
+/*!
+ * number of pointer sized words which are reserved for the private handle in SpindleStaticBuffers_t. The library
+ * fails to compile when the handle does not fit into it
+ */
+#define SPINDLE_STATIC_HANDLE_WORDS  ( ( 2 * sizeof(SpindleCalibration_t) + 2 * sizeof(SpindleSnapshot_t) + \
+		sizeof(SpindlePhysicalParams_t) ) / sizeof(void*) + 40 )
+
+/*!
+ * The SpindleWorkerBuffers_t structure holds the controller task and its command queue, which are shared by all
+ * instances. Only the first instance needs it.
+ */
+typedef struct SpindleWorkerBuffers
+{
+	/*!
+	 * TCB of the controller task
+	 */
+	StaticTask_t      task;
+
+	/*!
+	 * stack of the controller task, it must hold uxStackDepth words of the first SPINDLE_CreateStatic call
+	 */
+	StackType_t*      stack;
+
+	/*!
+	 * command queue and its storage
+	 */
+	StaticQueue_t     queue;
+	void*             queueStorage[SPINDLE_STATIC_QUEUE_LENGTH * SPINDLE_STATIC_COMMAND_WORDS];
+} SpindleWorkerBuffers_t;
+
+/*!
+ * The SpindleStaticBuffers_t structure holds all objects of an instance which is created by SPINDLE_CreateStatic.
+ * It must stay valid as long as the instance is used, so it is mostly a static variable of the user project.
+ */
+typedef struct SpindleStaticBuffers
+{
+	/*!
+	 * event group which signals that the spindle is at speed
+	 */
+	StaticEventGroup_t      events;
+
+	/*!
+	 * private handle of the library
+	 */
+	void*                   handle[SPINDLE_STATIC_HANDLE_WORDS];
+
+	/*!
+	 * controller task and command queue, only required when no instance has been created before, otherwise null
+	 */
+	SpindleWorkerBuffers_t* worker;
+} SpindleStaticBuffers_t;
+
+/*!
+ * The SPINDLE_CreateStatic function creates a spindle instance like SPINDLE_CreateInstance, but the handle, the event
+ * group and, for the first instance, the controller task and its queue are placed in the given buffers instead of the
+ * heap. It is only available when configSUPPORT_STATIC_ALLOCATION is set. Dynamic and static instances can be mixed.
+ *
+ * The return value of SPINDLE_CreateStatic is a null pointer in case an error occured or a pointer of type SpindleHandle_t.
+ *
+ * param uxStackDepth is the stack depth of the controller task in words, only used when it is created
+ * param xPrio is the spindle controller priority, only used when the controller task is created
+ * param cH of type ConsoleHandle_t is the handle pointer of a console processor instance
+ * param p of type SpindlePhysicalParams_t* is a pointer to the platform abstraction functions
+ * param buffers is the storage of the instance
+ */
+SpindleHandle_t SPINDLE_CreateStatic( unsigned int uxStackDepth, int xPrio, ConsoleHandle_t cH, SpindlePhysicalParams_t* p,
+		SpindleStaticBuffers_t* buffers );
+#endif
+
+/*!
+ * The SPINDLE_Start function starts the spindle or changes its speed. The RPM value is limited to the configured
+ * range, negative values turn the spindle backward. The call is passed to the spindle controller task and blocks
+ * until it has been processed. The function returns 0 on success and -1 on error or when the command could not be
+ * queued within the timeout.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ * param rpm is the new speed of the spindle in RPM
+ * param timeoutMs is the maximum time to wait for a free slot in the command queue, -1 waits forever
+ */
+int SPINDLE_Start( SpindleHandle_t h, float rpm, unsigned int timeoutMs );
+
+/*!
+ * The SPINDLE_Stop function stops the spindle, with an acceleration it is stopped along the ramp. The call blocks
+ * until it has been processed. The function returns 0 on success and -1 on error or timeout.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ * param timeoutMs is the maximum time to wait for a free slot in the command queue, -1 waits forever
+ */
+int SPINDLE_Stop( SpindleHandle_t h, unsigned int timeoutMs );
+
+/*!
+ * The SPINDLE_GetStatus function reads the state of the spindle controller from the last published snapshot. It
+ * does not block anymore. The function returns 0 on success and -1 on error.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ * param status is a pointer to the structure which is filled with the state
+ * param timeoutMs is not used anymore and only kept for compatibility
+ */
+int SPINDLE_GetStatus( SpindleHandle_t h, SpindleStatus_t* status, unsigned int timeoutMs );
+
+/*!
+ * The SPINDLE_GetSnapshot function copies the last snapshot published by the spindle controller task. It never
+ * blocks and does not take a lock, it just retries the copy in the rare case the controller published a new snapshot
+ * in between. Therefore it can be called from any task and from interrupt service routines. The function returns 0
+ * on success and -1 on error.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ * param snapshot is a pointer to the structure which is filled with the copy
+ */
+int SPINDLE_GetSnapshot( SpindleHandle_t h, SpindleSnapshot_t* snapshot );
+
+/*!
+ * The SPINDLE_Calibrate function sweeps the duty cycle from 0.0 to 1.0 in SPINDLE_CALIBRATION_POINTS steps, records
+ * the steady state speed of each step and uses the result as calibration table from then on. It requires a
+ * getMeasuredRPM function and a stopped spindle, the spindle runs forward during the sweep and is stopped again
+ * afterwards. The table is passed to storeCalibration when there is one. The call blocks the caller for the whole
+ * sweep, other instances keep running. During the sweep all commands except status and reading the table are
+ * rejected for the instance. It returns 0 on success and -1 on error, also when the table is used but could not
+ * be stored.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ * param table is an optional pointer to a structure which receives the recorded table, can be null
+ * param timeoutMs is the maximum time to wait for a free slot in the command queue, -1 waits forever
+ */
+int SPINDLE_Calibrate( SpindleHandle_t h, SpindleCalibration_t* table, unsigned int timeoutMs );
+
+/*!
+ * The SPINDLE_SetCalibration function replaces the calibration table of the spindle controller, a table with a
+ * count of 0 removes it. The table is passed to storeCalibration when there is one. The function returns -1 when
+ * the table is not valid, on error or timeout, otherwise 0.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ * param table is a pointer to the new table
+ * param timeoutMs is the maximum time to wait for a free slot in the command queue, -1 waits forever
+ */
+int SPINDLE_SetCalibration( SpindleHandle_t h, const SpindleCalibration_t* table, unsigned int timeoutMs );
+
+/*!
+ * The SPINDLE_GetCalibration function copies the calibration table of the spindle controller, the count is 0 when
+ * there is no table. The function returns 0 on success and -1 on error or timeout.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ * param table is a pointer to the structure which receives the table
+ * param timeoutMs is the maximum time to wait for a free slot in the command queue, -1 waits forever
+ */
+int SPINDLE_GetCalibration( SpindleHandle_t h, SpindleCalibration_t* table, unsigned int timeoutMs );
+
+/*!
+ * The SPINDLE_StartAsync function queues a start or speed change and returns at once without waiting for the
+ * spindle controller. It returns -1 when the command queue is full, otherwise 0. The result of the command is
+ * not reported, SPINDLE_WaitForSpeed can be used to wait until the speed is reached.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ * param rpm is the new speed of the spindle in RPM
+ */
+int SPINDLE_StartAsync( SpindleHandle_t h, float rpm );
+
+/*!
+ * The SPINDLE_StopAsync function queues a stop and returns at once without waiting for the spindle controller.
+ * It returns -1 when the command queue is full, otherwise 0.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ */
+int SPINDLE_StopAsync( SpindleHandle_t h );
+
+/*!
+ * The SPINDLE_WaitForSpeed function blocks the caller until the speed ramp has arrived at the commanded speed,
+ * or at zero after a stop. Without an acceleration the speed is reached as soon as the command is processed.
+ * The function returns 0 when the speed is reached and -1 when the timeout has elapsed before.
+ *
+ * param h is the handle of the spindle controller which is returned by SPINDLE_CreateInstance
+ * param timeoutMs is the maximum time to wait in milliseconds
+ */
+int SPINDLE_WaitForSpeed( SpindleHandle_t h, unsigned int timeoutMs );
+
 
 /*!
  * \mainpage FreeRTOS Spindle Library
@@ -158,9 +502,11 @@ SpindleHandle_t SPINDLE_CreateInstance( unsigned int uxStackDepth, int xPrio, Co
  * There are no additional static compile flags or DEFINES which the user can configure
  * 
  * \section instantiation library instantiation
- * The library is implemented as a singleton pattern. This means that only one instance
- * can be created at runtime. Calling the SPINDLE_CreateInstance multiple times will
- * succeed but always the pointer of the first instance will be returned.
+ * Every call of SPINDLE_CreateInstance creates a new spindle instance, for example for a second spindle on
+ * another timer. The instances share one controller task and one command queue, the task steps the ramp, the
+ * controller and the calibration sweep of every instance when they are due. A calibration sweep of one instance
+ * does not block the others. The hardware of an instance is selected by its context pointer and its console
+ * command by its name.
  * 
  * \section state_example Examples
  * The following example shows how to create a instance of the spindle controller library.
@@ -175,18 +521,34 @@ SpindleHandle_t SPINDLE_CreateInstance( unsigned int uxStackDepth, int xPrio, Co
  * s.setDirection       = SPINDLE_SetDirection;
  * s.setDutyCycle       = SPINDLE_SetDutyCycle;
  * s.enaPWM             = SPINDLE_EnaPWM;
- * s.context            = NULL;
- * SPINDLE_CreateInstance( 4*configMINIMAL_STACK_SIZE, configMAX_PRIORITIES - 3, c, &s);
+ * s.context            = NULL;    // or the hardware of the instance
+ * s.name               = "spindle";
+ * s.getMeasuredRPM     = NULL; // open loop, or a function which returns the tacho RPM
+ * s.kp                 = 0.0f;
+ * s.ki                 = 0.0f;
+ * s.controlPeriodMs    = 0;
+ * s.acceleration       = 3000.0f; // RPM per second, 0 to set a new speed at once
+ * s.jerk               = 0.0f;    // RPM per second squared for an S-curve, 0 for a linear ramp
+ * s.loadCalibration    = NULL;    // optional persistence of the calibration table
+ * s.storeCalibration   = NULL;
+ * s.calibrationSettleMs = 0;
+ * SpindleHandle_t h = SPINDLE_CreateInstance( 4*configMINIMAL_STACK_SIZE, configMAX_PRIORITIES - 3, c, &s);
  * 
  * ...
  *
+ * // the spindle can be controlled from C code as well as from the console
+ * SPINDLE_Start(h, 3000.0f, 100);
+ * SPINDLE_WaitForSpeed(h, 5000);
+ * ...
+ * SPINDLE_StopAsync(h);
+ *
  * \endcode
  *
  * The following example shows the usage of the spindle library via console. With the spindle command
  * the user can start or stop the spindle and it can also change the spindle speed with the start command
  * The command returns OK or FAIL in the given cases of failure or success. There is also a status command.
- * It returns the state of the spindle (turning) and the RPM which has been set. It also terminates with "OK"
- * or "FAIL"
+ * It returns the state of the spindle (turning), the RPM which has been set and the measured RPM (which is the
+ * set RPM in case there is no getMeasuredRPM function). It also terminates with "OK" or "FAIL"
  *
  * \code
  * // starts the spindle
@@ -197,12 +559,24 @@ SpindleHandle_t SPINDLE_CreateInstance( unsigned int uxStackDepth, int xPrio, Co
  * 
  * // stops the spindle
  * $> spindle stop
+ *
+ * // waits up to 5 s until the spindle ramp has arrived at the commanded speed
+ * $> spindle wait 5000
  * \endcode
  * 
  * \code
  * // get the status the spindle
  * $> spindle status
  * \endcode
+ *
+ * A spindle with a getMeasuredRPM function can be calibrated while it is stopped. The sweep takes about
+ * SPINDLE_CALIBRATION_POINTS times the settle time and prints the recorded table, which is printed again by the
+ * table subcommand.
+ *
+ * \code
+ * $> spindle calibrate
+ * $> spindle table
+ * \endcode
  */
 
  /*!
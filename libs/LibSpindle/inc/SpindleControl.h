@@ -0,0 +1,67 @@
+/*
+ * SpindleControl.h
+ *
+ *  Created on: Feb 4, 2026
+ *      Author: Basti
+ */
+
+ /*! \file */
+
+#ifndef INC_SPINDLE_SPINDLECONTROL_H_
+#define INC_SPINDLE_SPINDLECONTROL_H_
+
+/*
+ * The calibration table and the speed controller of the spindle library. They do not depend on FreeRTOS, so they
+ * are built and checked against a motor model by the host unit tests in test/UnitTests as well. Besides the
+ * SpindleCalibration_t structure the functions are internal to the library and not part of its API.
+ */
+
+/*!
+ * maximum number of points of a calibration table
+ */
+#define SPINDLE_CALIBRATION_POINTS  17
+
+/*!
+ * The SpindleCalibration_t structure maps the duty cycle to the steady state speed of the spindle. It is recorded by
+ * SPINDLE_Calibrate and used to compute the duty cycle for a speed by linear interpolation, which includes the
+ * deadband and the non-linearity of the spindle. A table is valid with at least two points, increasing duty cycles
+ * in the range of 0.0 to 1.0 and non-decreasing speeds.
+ */
+typedef struct SpindleCalibration
+{
+	/*!
+	 * number of valid points, 0 means that there is no table and the duty cycle is |RPM| / maxRPM
+	 */
+	unsigned int count;
+
+	/*!
+	 * duty cycle of the points in increasing order
+	 */
+	float        duty[SPINDLE_CALIBRATION_POINTS];
+
+	/*!
+	 * measured absolute speed in RPM of the points in non-decreasing order
+	 */
+	float        rpm[SPINDLE_CALIBRATION_POINTS];
+} SpindleCalibration_t;
+
+/*!
+ * Returns 1 if the table has at least two points, increasing duty cycles in the range of 0.0 to 1.0 and
+ * non-decreasing speeds, otherwise 0
+ */
+int SpindleCalibrationValid( const SpindleCalibration_t* t );
+
+/*!
+ * Returns the open loop duty cycle for the absolute value of rpm, interpolated from the table or |rpm| / maxRPM
+ * when the table is empty. The result of the table is limited to 1.0
+ */
+float SpindleCalibrationDuty( const SpindleCalibration_t* t, float maxRPM, float rpm );
+
+/*!
+ * One step of the PI controller with the open loop duty cycle as feed forward part. The integral is only taken over
+ * while the output is not limited (anti windup), saturated is set to 1 when the output is limited to full duty.
+ * Returns the duty cycle in the range of 0.0 to 1.0
+ */
+float SpindleControlOutput( float* integral, float kp, float ki, float feedForward, float error, float dt, int* saturated );
+
+#endif /* INC_SPINDLE_SPINDLECONTROL_H_ */
@@ -11,20 +11,36 @@
 
 #include "FreeRTOS.h"
 #include "task.h"
-#include "semphr.h"
 #include "queue.h"
 #include "timers.h"
+#include "event_groups.h"
 
 #include <malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/queue.h>
 #include <math.h>
 
-// singleton instance pointer
-// --------------------------------------------------------------------------------------------------------------------
-static SpindleHandle_t SpindleInstancePointer = NULL;
+// set while the ramp has arrived at the commanded speed (or at zero after a stop)
+#define SPINDLE_EVENT_AT_SPEED 0x01
+
+// default time to settle at each point of the calibration sweep and the time the speed is averaged afterwards
+#define SPINDLE_CALIBRATION_SETTLE_MS  1500
+#define SPINDLE_CALIBRATION_MEASURE_MS  250
+
+// duration of the low speed start boost in open loop mode without ramp and calibration table
+#define SPINDLE_BOOST_MS  100
+
+// the bench is timed with the cycle counter of the Cortex-M7, which the application enables for its runtime
+// statistics. Elsewhere, e.g. in the host simulation, the tick count is used
+#ifdef __arm__
+#  include "main.h"
+#  define SPINDLE_BENCH_NOW()   ( DWT->CYCCNT )
+#  define SPINDLE_BENCH_HZ      configCPU_CLOCK_HZ
+#else
+#  define SPINDLE_BENCH_NOW()   ( (uint32_t)xTaskGetTickCount() )
+#  define SPINDLE_BENCH_HZ      configTICK_RATE_HZ
+#endif
 
 // --------------------------------------------------------------------------------------------------------------------
 typedef enum
@@ -34,6 +50,9 @@ typedef enum
 	cctSTART     = 0x01,
 	cctSTOP      = 0x02,
 	cctSTATUS    = 0x04,
+	cctCALIBRATE = 0x08,
+	cctTABLE     = 0x10,
+	cctINIT      = 0x20,
 } CtrlCommandType_t;
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -42,12 +61,14 @@ typedef struct StepCommandResponse
 {
 	int code;
 	int requestID;
+	volatile int done;
 	union
 	{
 		struct
 		{
 			float speed;
 			int running;
+			float measured;
 		} asStatus;
 	} args;
 } StepCommandResponse_t;
@@ -60,6 +81,7 @@ typedef struct CtrlCommand
 	{
 		int requestID;
 		CtrlCommandType_t type;
+		SpindleHandle_t target;
 	} head;
 	struct
 	{
@@ -69,192 +91,790 @@ typedef struct CtrlCommand
 			{
 				float speed;
 			} asStart;
+			struct
+			{
+				const SpindleCalibration_t* set;
+				SpindleCalibration_t* get;
+			} asTable;
 		} args;
-		SemaphoreHandle_t syncEvent;
+		TaskHandle_t caller;
 	} request;
 	StepCommandResponse_t* response;
 } CtrlCommand_t;
 
-// --------------------------------------------------------------------------------------------------------------------
-typedef struct stepSyncEventElement
-// --------------------------------------------------------------------------------------------------------------------
-{
-    struct
-	{
-    	int               allocated;
-    	SemaphoreHandle_t event;
-	} content;
-
-    LIST_ENTRY(stepSyncEventElement) navigate;
-} stepSyncEventElement_t;
-
 // --------------------------------------------------------------------------------------------------------------------
 struct SpindleHandle
 // --------------------------------------------------------------------------------------------------------------------
 {
+	struct SpindleHandle* next;
 	int               nextRequestID;
 	ConsoleHandle_t   consoleH;
-	TaskHandle_t      tHandle;
-	QueueHandle_t     cmdQueue;
-	int               cancel;
 	SpindlePhysicalParams_t physical;
+	int               running;
+	int               stopping;
+	int               atSpeed;
+	int               startupBoost;
+	int               closedLoop;
+	int               ramped;
+	TickType_t        controlPeriod;
+	TickType_t        lastControl;
+	TickType_t        boostEnd;
 	float             currentSpeed;
+	float             measuredSpeed;
+	float             integral;
+	int               backward;
+	EventGroupHandle_t events;
+	struct
+	{
+		float         speed;
+		float         rate;
+	} ramp;
+	unsigned int      faults;
+	unsigned int      noFeedbackSteps;
+	SpindleCalibration_t calibration;
+	struct
+	{
+		// the calibration sweep is stepped by the worker like the controller, so the other instances keep
+		// running. The caller is released when the sweep has ended
+		int                    active;
+		unsigned int           point;
+		int                    measuring;
+		TickType_t             due;
+		SpindleCalibration_t   table;
+		SpindleCalibration_t*  get;
+		StepCommandResponse_t* response;
+		TaskHandle_t           caller;
+	} sweep;
 	struct
 	{
-		SemaphoreHandle_t lockGuard;
-		LIST_HEAD(pool_list, stepSyncEventElement) pool;
-	} syncEventPool;
+		// the spindle task is the only writer, it fills the copy which is not published and then
+		// publishes it with the next sequence number, so a reader is never blocked by the writer
+		volatile unsigned int sequence;
+		SpindleSnapshot_t     copy[2];
+	} snapshot;
 };
 
+// all instances are served by one worker task with one command queue, which are created with the first instance.
+// The list of instances is only used by the worker task
 // --------------------------------------------------------------------------------------------------------------------
-static void SpindleFunction( void * arg )
+static struct
 // --------------------------------------------------------------------------------------------------------------------
 {
-	CtrlCommand_t cmd;
-	StepCommandResponse_t asyncResponse;
-	SpindleHandle_t h = (SpindleHandle_t)arg;
-	unsigned int running = 0;
-	unsigned int startupBoost = 0;
+	TaskHandle_t      tHandle;
+	QueueHandle_t     cmdQueue;
+	SpindleHandle_t   instances;
+} SpindleWorker;
+
+// --------------------------------------------------------------------------------------------------------------------
+static int SpindleIsDue( TickType_t now, TickType_t due )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// wrap around safe comparison of tick counts
+	return (TickType_t)( now - due ) < ( portMAX_DELAY / 2 );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static float SpindleDutyForRPM( SpindleHandle_t h, float rpm )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	return SpindleCalibrationDuty(&h->calibration, h->physical.maxRPM, rpm);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindleSweepBegin( SpindleHandle_t h, CtrlCommand_t* cmd, TickType_t now )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	unsigned int settleMs = h->physical.calibrationSettleMs ? h->physical.calibrationSettleMs : SPINDLE_CALIBRATION_SETTLE_MS;
+	memset(&h->sweep.table, 0, sizeof(SpindleCalibration_t));
+	h->sweep.active = 1;
+	h->sweep.point = 0;
+	h->sweep.measuring = 0;
+	h->sweep.due = now + pdMS_TO_TICKS(settleMs);
+	h->sweep.get = cmd->request.args.asTable.get;
+	h->sweep.response = cmd->response;
+	h->sweep.caller = cmd->request.caller;
+
+	h->backward = 0;
+	h->physical.setDirection(h, h->physical.context, 0 );
+	h->physical.setDutyCycle(h, h->physical.context, 0.0f );
+	h->physical.enaPWM(h, h->physical.context, 1);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindleSweepStep( SpindleHandle_t h, TickType_t now )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	unsigned int settleMs = h->physical.calibrationSettleMs ? h->physical.calibrationSettleMs : SPINDLE_CALIBRATION_SETTLE_MS;
+	SpindleCalibration_t* t = &h->sweep.table;
+	if ( !SpindleIsDue(now, h->sweep.due) ) return;
+
+	if ( !h->sweep.measuring )
+	{
+		// the first call drops what has been measured while settling, the second one averages the measure time
+		h->physical.getMeasuredRPM(h, h->physical.context);
+		h->sweep.measuring = 1;
+		h->sweep.due = now + pdMS_TO_TICKS(SPINDLE_CALIBRATION_MEASURE_MS);
+		return;
+	}
+
+	unsigned int i = h->sweep.point;
+	float rpm = fabsf(h->physical.getMeasuredRPM(h, h->physical.context));
+
+	// the table must be monotone, a point which is slower than the one before is raised to it
+	if ( i > 0 && rpm < t->rpm[i - 1] ) rpm = t->rpm[i - 1];
+	t->duty[i] = (float)i / (float)( SPINDLE_CALIBRATION_POINTS - 1 );
+	t->rpm[i] = rpm;
+	t->count = i + 1;
+	h->measuredSpeed = rpm;
+
+	h->sweep.point += 1;
+	h->sweep.measuring = 0;
+	if ( h->sweep.point < SPINDLE_CALIBRATION_POINTS )
+	{
+		h->physical.setDutyCycle(h, h->physical.context, (float)h->sweep.point / (float)( SPINDLE_CALIBRATION_POINTS - 1 ) );
+		h->sweep.due = now + pdMS_TO_TICKS(settleMs);
+		return;
+	}
+
+	// the sweep has ended, the spindle is stopped again and the caller gets the result
+	h->sweep.active = 0;
+	h->measuredSpeed = 0;
+	h->physical.setDutyCycle(h, h->physical.context, 0.0f );
+	h->physical.enaPWM(h, h->physical.context, 0);
+
+	int code = SpindleCalibrationValid(t) ? 0 : -1;
+	if ( code == 0 )
+	{
+		// a table which could not be stored is used anyway, but the caller gets an error
+		h->calibration = *t;
+		if ( h->physical.storeCalibration != NULL && h->physical.storeCalibration(h, h->physical.context, t) != 0 ) code = -1;
+	}
+	if ( h->sweep.get != NULL ) *h->sweep.get = *t;
+	if ( h->sweep.caller != NULL )
+	{
+		h->sweep.response->code = code;
+		h->sweep.response->done = 1;
+		xTaskNotifyGive(h->sweep.caller);
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindleControlStep( SpindleHandle_t h, float dt )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// PI controller on the absolute speed of the ramp, the open loop duty cycle is used as feed forward part
+	float target = fabsf(h->ramp.speed);
+	if ( h->faults & SPINDLE_FAULT_NO_FEEDBACK )
+	{
+		// without a measurement the controller would only wind up to full duty, the spindle runs open loop
+		// until it is started again
+		h->integral = 0;
+		h->faults &= ~SPINDLE_FAULT_SATURATED;
+		h->physical.setDutyCycle(h, h->physical.context, SpindleDutyForRPM(h, target) );
+		return;
+	}
+
+	int saturated;
+	float error = target - fabsf(h->measuredSpeed);
+	float duty  = SpindleControlOutput(&h->integral, h->physical.kp, h->physical.ki, SpindleDutyForRPM(h, target), error, dt, &saturated);
+
+	h->faults &= ~SPINDLE_FAULT_SATURATED;
+	if ( saturated ) h->faults |= SPINDLE_FAULT_SATURATED;
+
+	h->physical.setDutyCycle(h, h->physical.context, duty );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindleRampStep( SpindleHandle_t h, float dt )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// moves the ramp speed towards the commanded speed, a reversal passes through zero
+	float diff = h->currentSpeed - h->ramp.speed;
+	float acceleration = h->physical.acceleration;
+	float jerk = h->physical.jerk;
+
+	if ( jerk <= 0.0f )
+	{
+		// linear ramp with constant acceleration
+		float step = acceleration * dt;
+		if ( fabsf(diff) <= step ) h->ramp.speed = h->currentSpeed;
+		else h->ramp.speed += ( diff > 0.0f ) ? step : -step;
+		h->ramp.rate = 0.0f;
+		return;
+	}
+
+	// S-curve, the acceleration changes with the jerk limit and is reduced early enough
+	// to arrive at the commanded speed with an acceleration of zero
+	float direction = ( diff > 0.0f ) ? 1.0f : -1.0f;
+	float rate = direction * fminf(acceleration, sqrtf(2.0f * jerk * fabsf(diff)));
+	float maxChange = jerk * dt;
+	if ( rate > h->ramp.rate + maxChange ) rate = h->ramp.rate + maxChange;
+	if ( rate < h->ramp.rate - maxChange ) rate = h->ramp.rate - maxChange;
+
+	float step = rate * dt;
+	if ( ( direction > 0.0f && step >= diff ) || ( direction < 0.0f && step <= diff ) )
+	{
+		h->ramp.speed = h->currentSpeed;
+		h->ramp.rate = 0.0f;
+	}
+	else
+	{
+		h->ramp.speed += step;
+		h->ramp.rate = rate;
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindleApplyOutput( SpindleHandle_t h, int closedLoop, float dt )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the direction follows the sign of the ramp, so it changes when the ramp passes through zero
+	int backward = ( h->ramp.speed < 0.0f ) || ( h->ramp.speed == 0.0f && h->currentSpeed < 0.0f );
+	if ( backward != h->backward )
+	{
+		h->backward = backward;
+		h->integral = 0;
+		h->physical.setDirection(h, h->physical.context, backward );
+	}
+
+	if ( closedLoop ) SpindleControlStep(h, dt);
+	else h->physical.setDutyCycle(h, h->physical.context, SpindleDutyForRPM(h, h->ramp.speed) );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindlePublish( SpindleHandle_t h )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	unsigned int next = h->snapshot.sequence + 1;
+	SpindleSnapshot_t* s = &h->snapshot.copy[next & 1];
+	s->sequence = next;
+	s->setpoint = h->currentSpeed;
+	s->measured = ( h->physical.getMeasuredRPM != NULL ) ? h->measuredSpeed : h->ramp.speed;
+	s->ramp     = h->ramp.speed;
+	s->backward = h->backward;
+	s->running  = h->running || h->sweep.active;
+	s->atSpeed  = h->atSpeed;
+	s->faults   = h->faults;
+
+	// the copy must be complete before the sequence number publishes it
+	portMEMORY_BARRIER();
+	h->snapshot.sequence = next;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindleInit( SpindleHandle_t h )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	SpindleCalibration_t table;
+	h->running = 0;
+	h->stopping = 0;
+	h->atSpeed = 1;
+	h->startupBoost = 0;
+	h->closedLoop = ( h->physical.getMeasuredRPM != NULL );
+	h->ramped = ( h->physical.acceleration > 0.0f );
+	h->controlPeriod = pdMS_TO_TICKS(h->physical.controlPeriodMs);
+	if ( h->controlPeriod == 0 ) h->controlPeriod = 1;
+	h->lastControl = xTaskGetTickCount();
 
 	h->physical.enaPWM(h, h->physical.context, 0);
 	h->physical.setDutyCycle(h, h->physical.context, 0.0f );
 	h->currentSpeed = 0;
+	h->measuredSpeed = 0;
+	h->integral = 0;
+	h->ramp.speed = 0;
+	h->ramp.rate = 0;
+	h->backward = 0;
+	h->faults = 0;
+	h->noFeedbackSteps = 0;
+	if ( h->physical.loadCalibration != NULL &&
+	     h->physical.loadCalibration(h, h->physical.context, &table) == 0 && SpindleCalibrationValid(&table) )
+	{
+		h->calibration = table;
+	}
+	xEventGroupSetBits(h->events, SPINDLE_EVENT_AT_SPEED);
 
-	// now here comes the command processor part
-	while( !h->cancel )
+	// from now on the worker serves the instance
+	h->next = SpindleWorker.instances;
+	SpindleWorker.instances = h;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int SpindleCommand( SpindleHandle_t h, CtrlCommand_t* cmd )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// returns 1 when the response is given later, like at the end of the calibration sweep
+	if ( h->sweep.active && cmd->head.type != cctSTATUS && cmd->head.type != cctNONE &&
+	     !( cmd->head.type == cctTABLE && cmd->request.args.asTable.set == NULL ) )
 	{
-		// wait for next command
-		if ( xQueueReceive( h->cmdQueue, &cmd, 100) == pdPASS )
+		// the spindle belongs to the calibration until the sweep has ended, only reading is possible
+		return 0;
+	}
+
+	switch ( cmd->head.type )
+	{
+	case cctNONE:
+		cmd->response->code = 0;
+		break;
+	case cctINIT:
+		SpindleInit(h);
+		cmd->response->code = 0;
+		break;
+	case cctSTART:
+		cmd->response->code = 0;
+		if ( cmd->request.args.asStart.speed < h->physical.minRPM ) cmd->request.args.asStart.speed = h->physical.minRPM;
+		if ( cmd->request.args.asStart.speed > h->physical.maxRPM ) cmd->request.args.asStart.speed = h->physical.maxRPM;
+
+		if (  cmd->request.args.asStart.speed > 0.0f && cmd->request.args.asStart.speed <  h->physical.absMinRPM ) cmd->request.args.asStart.speed =  h->physical.absMinRPM;
+		if (  cmd->request.args.asStart.speed < 0.0f && cmd->request.args.asStart.speed > -h->physical.absMinRPM ) cmd->request.args.asStart.speed = -h->physical.absMinRPM;
+
+		int directionChange = 0;
+		if ((h->currentSpeed < 0.0f && cmd->request.args.asStart.speed > 0.0f) ||
+			(h->currentSpeed > 0.0f && cmd->request.args.asStart.speed < 0.0f))
+			directionChange = 1;
+		h->currentSpeed = cmd->request.args.asStart.speed;
+		h->stopping = 0;
+		if ( h->running == 0 )
+		{
+			h->faults = 0;
+			h->noFeedbackSteps = 0;
+		}
+
+		if ( h->ramped )
 		{
-			if ( cmd.response == NULL || cmd.request.syncEvent == NULL )
+			// the ramp starts at the current ramp speed, which is zero when the spindle was stopped
+			xEventGroupClearBits(h->events, SPINDLE_EVENT_AT_SPEED);
+			h->atSpeed = 0;
+			if ( h->running == 0 )
 			{
-				cmd.response = &asyncResponse;
+				h->integral = 0;
+				h->ramp.speed = 0;
+				h->ramp.rate = 0;
+				h->backward = h->currentSpeed < 0.0f;
+				h->physical.setDirection(h, h->physical.context, h->backward );
+				h->physical.setDutyCycle(h, h->physical.context, 0.0f );
+				h->lastControl = xTaskGetTickCount();
 			}
-			memset(cmd.response, 0, sizeof(StepCommandResponse_t));
-			cmd.response->code = -1;
-			cmd.response->requestID = cmd.head.requestID;
+			h->physical.enaPWM(h, h->physical.context, 1);
+			h->running = 1;
+			break;
+		}
 
+		// without acceleration the new speed is set at once
+		h->ramp.speed = h->currentSpeed;
+		h->backward = h->currentSpeed < 0.0f;
+		h->physical.setDirection(h, h->physical.context, h->currentSpeed < 0.0f );
+		if ( h->closedLoop )
+		{
+			// the controller starts with the open loop duty cycle, it needs no boost
+			if ( h->running == 0 || directionChange == 1 ) h->integral = 0;
+			h->startupBoost = 0;
+			SpindleControlStep(h, 0.0f);
+		}
+		else if ( h->running == 1 && directionChange == 0 )
+		{
+			h->physical.setDutyCycle(h, h->physical.context, SpindleDutyForRPM(h, h->currentSpeed) );
+			h->startupBoost = 0;
+		}
+		else if ( ( h->running == 0 || directionChange == 1 ) && fabsf(cmd->request.args.asStart.speed) <= (0.25f * h->physical.maxRPM) &&
+		          h->calibration.count == 0 )
+		{
+			// the boost is only required without a calibration table, the table covers the deadband
+			h->physical.setDutyCycle(h, h->physical.context, 0.5f );
+			h->startupBoost = 1;
+			h->boostEnd = xTaskGetTickCount() + pdMS_TO_TICKS(SPINDLE_BOOST_MS);
+		}
+		if ( h->startupBoost == 0 && !h->closedLoop )
+		{
+			h->physical.setDutyCycle(h, h->physical.context, SpindleDutyForRPM(h, h->currentSpeed) );
+		}
 
-			switch ( cmd.head.type )
+		h->physical.enaPWM(h, h->physical.context, 1);
+		h->running = 1;
+		xEventGroupSetBits(h->events, SPINDLE_EVENT_AT_SPEED);
+		break;
+	case cctSTOP:
+		cmd->response->code = 0;
+		h->currentSpeed = 0;
+		if ( h->ramped && h->running )
+		{
+			// the spindle is switched off when the ramp arrives at zero
+			xEventGroupClearBits(h->events, SPINDLE_EVENT_AT_SPEED);
+			h->atSpeed = 0;
+			h->stopping = 1;
+			break;
+		}
+		h->ramp.speed = 0;
+		h->ramp.rate = 0;
+		h->integral = 0;
+		h->startupBoost = 0;
+		h->running = 0;
+		h->physical.setDutyCycle(h, h->physical.context, 0.0f );
+		h->physical.enaPWM(h, h->physical.context, 0);
+		xEventGroupSetBits(h->events, SPINDLE_EVENT_AT_SPEED);
+		break;
+	case cctSTATUS:
+		cmd->response->code = 0;
+		cmd->response->args.asStatus.running = h->running;
+		cmd->response->args.asStatus.speed = h->currentSpeed;
+		cmd->response->args.asStatus.measured = h->closedLoop ? h->measuredSpeed : h->ramp.speed;
+		break;
+	case cctCALIBRATE:
+		// only possible with a measurement and a stopped spindle, the caller waits until the sweep has ended
+		if ( h->running || !h->closedLoop ) break;
+		SpindleSweepBegin(h, cmd, xTaskGetTickCount());
+		return ( cmd->request.caller != NULL );
+	case cctTABLE:
+		cmd->response->code = 0;
+		if ( cmd->request.args.asTable.get != NULL ) *cmd->request.args.asTable.get = h->calibration;
+		if ( cmd->request.args.asTable.set != NULL )
+		{
+			// the table is only replaced while the spindle is stopped, because storing it may take a while
+			const SpindleCalibration_t* set = cmd->request.args.asTable.set;
+			if ( h->running || ( set->count != 0 && !SpindleCalibrationValid(set) ) )
 			{
-			case cctNONE:
-				cmd.response->code = 0;
-				break;
-			case cctSTART:
-				cmd.response->code = 0;
-				if ( cmd.request.args.asStart.speed < h->physical.minRPM ) cmd.request.args.asStart.speed = h->physical.minRPM;
-				if ( cmd.request.args.asStart.speed > h->physical.maxRPM ) cmd.request.args.asStart.speed = h->physical.maxRPM;
-
-				if (  cmd.request.args.asStart.speed > 0.0f && cmd.request.args.asStart.speed <  h->physical.absMinRPM ) cmd.request.args.asStart.speed =  h->physical.absMinRPM;
-				if (  cmd.request.args.asStart.speed < 0.0f && cmd.request.args.asStart.speed > -h->physical.absMinRPM ) cmd.request.args.asStart.speed = -h->physical.absMinRPM;
-
-				int directionChange = 0;
-				if ((h->currentSpeed < 0.0f && cmd.request.args.asStart.speed > 0.0f) ||
-					(h->currentSpeed > 0.0f && cmd.request.args.asStart.speed < 0.0f))
-					directionChange = 1;
-				h->currentSpeed = cmd.request.args.asStart.speed;
-
-
-				h->physical.setDirection(h, h->physical.context, h->currentSpeed < 0.0f );
-				if ( running == 1 && directionChange == 0 )
-				{
-					h->physical.setDutyCycle(h, h->physical.context, ( fabsf(h->currentSpeed) / h->physical.maxRPM) );
-					startupBoost = 0;
-				}
-				else if ( ( running == 0 || directionChange == 1 ) && fabsf(cmd.request.args.asStart.speed) <= (0.25f * h->physical.maxRPM) )
-				{
-					h->physical.setDutyCycle(h, h->physical.context, 0.5f );
-					startupBoost = 1;
-				}
-				if ( startupBoost == 0 )
-				{
-					h->physical.setDutyCycle(h, h->physical.context, ( fabsf(h->currentSpeed) / h->physical.maxRPM ) );
-				}
-
-				h->physical.enaPWM(h, h->physical.context, 1);
-				running = 1;
-				break;
-			case cctSTOP:
-				cmd.response->code = 0;
-				h->currentSpeed = 0;
-				startupBoost = 0;
-				running = 0;
-				h->physical.setDutyCycle(h, h->physical.context, 0.0f );
-				h->physical.enaPWM(h, h->physical.context, 0);
-				break;
-			case cctSTATUS:
-				cmd.response->code = 0;
-				cmd.response->args.asStatus.running = running;
-				cmd.response->args.asStatus.speed = h->currentSpeed;
-				break;
-			default:
+				cmd->response->code = -1;
 				break;
 			}
+			if ( set->count == 0 ) memset(&h->calibration, 0, sizeof(SpindleCalibration_t));
+			else h->calibration = *set;
+			if ( h->physical.storeCalibration != NULL &&
+					h->physical.storeCalibration(h, h->physical.context, &h->calibration) != 0 ) cmd->response->code = -1;
+		}
+		break;
+	default:
+		break;
+	}
+	return 0;
+}
 
-			// after processing the command we have to release the caller to keep
-			// synchronous calling mechanism. In case there is no sync object, it was##
-			// called asynchronously
-			if ( cmd.request.syncEvent != NULL )
+// --------------------------------------------------------------------------------------------------------------------
+static TickType_t SpindleNextStep( SpindleHandle_t h, TickType_t now )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// ticks until the instance needs the worker again, without a pending step the worker only waits for commands
+	TickType_t due;
+	if ( h->sweep.active ) due = h->sweep.due;
+	else if ( h->running && ( h->closedLoop || h->ramped ) ) due = h->lastControl + h->controlPeriod;
+	else if ( h->running && h->startupBoost ) due = h->boostEnd;
+	else return portMAX_DELAY;
+
+	return SpindleIsDue(now, due) ? 0 : ( due - now );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindleStep( SpindleHandle_t h, TickType_t now )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h->sweep.active )
+	{
+		SpindleSweepStep(h, now);
+		SpindlePublish(h);
+		return;
+	}
+
+	if ( !h->closedLoop && !h->ramped )
+	{
+		// here we have to do some additional steps to regulate correct rpm in case
+		// the low speed boost has been performed
+		if ( h->startupBoost == 1 && h->running == 1 && SpindleIsDue(now, h->boostEnd) )
+		{
+			h->startupBoost = 0;
+			h->physical.setDutyCycle(h, h->physical.context, SpindleDutyForRPM(h, h->currentSpeed) );
+		}
+	}
+
+	// the steps are based on the last due time and not on the time of the wakeup, so commands
+	// do not shift the rate. After a longer gap (spindle stopped) there is no catching up.
+	if ( ( h->closedLoop || ( h->ramped && h->running ) ) && ( now - h->lastControl ) >= h->controlPeriod )
+	{
+		float dt = (float)h->controlPeriod / (float)configTICK_RATE_HZ;
+		h->lastControl += h->controlPeriod;
+		if ( ( now - h->lastControl ) >= h->controlPeriod ) h->lastControl = now;
+
+		if ( h->closedLoop )
+		{
+			// the measurement is an absolute value, the sign is taken from the current direction
+			float measured = fabsf(h->physical.getMeasuredRPM(h, h->physical.context));
+			h->measuredSpeed = h->backward ? -measured : measured;
+
+			// no feedback for half a second while the spindle should turn
+			if ( h->running && measured == 0.0f && fabsf(h->ramp.speed) >= h->physical.absMinRPM )
+			{
+				h->noFeedbackSteps += 1;
+				if ( (float)h->noFeedbackSteps * dt >= 0.5f ) h->faults |= SPINDLE_FAULT_NO_FEEDBACK;
+			}
+			else
 			{
-				xSemaphoreGive(cmd.request.syncEvent);
+				h->noFeedbackSteps = 0;
 			}
 		}
-		else
+
+		if ( h->running && h->ramped )
 		{
-			// here we have to do some additional steps to regulate correct rpm in case
-			// the low speed boost has been performed
-			if ( startupBoost == 1 && running == 1 )
+			SpindleRampStep(h, dt);
+			if ( h->stopping && h->ramp.speed == 0.0f )
+			{
+				h->stopping = 0;
+				h->running = 0;
+				h->integral = 0;
+				h->physical.setDutyCycle(h, h->physical.context, 0.0f );
+				h->physical.enaPWM(h, h->physical.context, 0);
+			}
+			else
+			{
+				SpindleApplyOutput(h, h->closedLoop, dt);
+			}
+
+			// callers which wait for the spindle are released as soon as the ramp has arrived
+			if ( !h->atSpeed && h->ramp.speed == h->currentSpeed )
 			{
-				startupBoost = 0;
-				h->physical.setDutyCycle(h, h->physical.context, ( fabsf(h->currentSpeed) / h->physical.maxRPM) );
+				h->atSpeed = 1;
+				xEventGroupSetBits(h->events, SPINDLE_EVENT_AT_SPEED);
 			}
 		}
+		else if ( h->running )
+		{
+			SpindleControlStep(h, dt);
+		}
 	}
+
+	SpindlePublish(h);
 }
 
 // --------------------------------------------------------------------------------------------------------------------
-static SemaphoreHandle_t GetCommandEvent( SpindleHandle_t h )
+static void SpindleWorkerFunction( void * arg )
 // --------------------------------------------------------------------------------------------------------------------
 {
-	xSemaphoreTakeRecursive( h->syncEventPool.lockGuard, -1 );
+	CtrlCommand_t cmd;
+	StepCommandResponse_t asyncResponse;
+	(void)arg;
 
-	stepSyncEventElement_t* el = LIST_FIRST(&h->syncEventPool.pool);
-	while ( el != NULL )
+	// now here comes the command processor part
+	for ( ;; )
 	{
-		if ( el->content.allocated == 0 )
+		// the queue is only waited for until the next step of any instance is due
+		TickType_t now = xTaskGetTickCount();
+		TickType_t timeout = 100;
+		for ( SpindleHandle_t h = SpindleWorker.instances; h != NULL; h = h->next )
+		{
+			TickType_t wait = SpindleNextStep(h, now);
+			if ( wait < timeout ) timeout = wait;
+		}
+
+		// wait for next command
+		if ( xQueueReceive( SpindleWorker.cmdQueue, &cmd, timeout) == pdPASS )
+		{
+			if ( cmd.response == NULL || cmd.request.caller == NULL )
+			{
+				cmd.response = &asyncResponse;
+			}
+			memset(cmd.response, 0, sizeof(StepCommandResponse_t));
+			cmd.response->code = -1;
+			cmd.response->requestID = cmd.head.requestID;
+
+			// after processing the command we have to release the caller to keep
+			// synchronous calling mechanism. The response is already in the stack frame
+			// of the caller. In case there is no caller task, it was called asynchronously
+			if ( !SpindleCommand(cmd.head.target, &cmd) && cmd.request.caller != NULL )
+			{
+				cmd.response->done = 1;
+				xTaskNotifyGive(cmd.request.caller);
+			}
+		}
+
+		now = xTaskGetTickCount();
+		for ( SpindleHandle_t h = SpindleWorker.instances; h != NULL; h = h->next )
 		{
-			el->content.allocated = 1;
-			// make sure we the event is in held state
-			xSemaphoreTake( el->content.event, 0 );
-			xSemaphoreGiveRecursive( h->syncEventPool.lockGuard );
-			return el->content.event;
+			SpindleStep(h, now);
 		}
-		el = LIST_NEXT(el, navigate);
 	}
+}
 
-	xSemaphoreGiveRecursive( h->syncEventPool.lockGuard );
-	return 0;
+// --------------------------------------------------------------------------------------------------------------------
+static TickType_t SpindleTimeout( unsigned int timeoutMs )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	return ( timeoutMs == (unsigned int)-1 ) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
 }
 
 // --------------------------------------------------------------------------------------------------------------------
-static void ReleaseCommandEvent( SpindleHandle_t h, SemaphoreHandle_t s )
+static int SpindleExecute( SpindleHandle_t h, CtrlCommand_t* cmd, TickType_t timeout )
 // --------------------------------------------------------------------------------------------------------------------
 {
-	xSemaphoreTakeRecursive( h->syncEventPool.lockGuard, -1 );
+	// synchronous call, the controller writes the response into the stack frame of the caller
+	// and notifies the calling task directly, so there are no sync objects to allocate
+	StepCommandResponse_t* response = cmd->response;
+	response->done = 0;
+	response->code = -1;
+	cmd->request.caller = xTaskGetCurrentTaskHandle();
+	cmd->head.target = h;
+	cmd->head.requestID = h->nextRequestID;
+	h->nextRequestID += 1;
 
-	stepSyncEventElement_t* el = LIST_FIRST(&h->syncEventPool.pool);
-	while ( el != NULL )
+	// the timeout is only used for the queue, once the command is queued the caller must wait
+	// for the response, because the controller writes it into the stack frame of the caller
+	if ( pdPASS != xQueueSend( SpindleWorker.cmdQueue, cmd, timeout ) )
 	{
-		if ( el->content.allocated == 1 && el->content.event == s)
-		{
-			el->content.allocated = 0;
-			xSemaphoreGiveRecursive( h->syncEventPool.lockGuard );
-			return;
-		}
-		el = LIST_NEXT(el, navigate);
+		return -1;
+	}
+
+	// the notification value may also be given by others (like the console job processor),
+	// so the caller waits until its response has been completed
+	while ( !response->done )
+	{
+		ulTaskNotifyTake(pdTRUE, -1);
 	}
+	return response->code;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int SpindleSubmit( SpindleHandle_t h, CtrlCommand_t* cmd )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// asynchronous call, the controller uses its own response and nobody is notified
+	cmd->response = NULL;
+	cmd->request.caller = NULL;
+	cmd->head.target = h;
+	cmd->head.requestID = h->nextRequestID;
+	h->nextRequestID += 1;
+	return ( pdPASS == xQueueSend( SpindleWorker.cmdQueue, cmd, 0 ) ) ? 0 : -1;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_Start( SpindleHandle_t h, float rpm, unsigned int timeoutMs )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h == NULL ) return -1;
+	StepCommandResponse_t response;
+	CtrlCommand_t cmd;
+	cmd.response = &response;
+	cmd.head.type = cctSTART;
+	cmd.request.args.asStart.speed = rpm;
+	return SpindleExecute(h, &cmd, SpindleTimeout(timeoutMs));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_Stop( SpindleHandle_t h, unsigned int timeoutMs )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h == NULL ) return -1;
+	StepCommandResponse_t response;
+	CtrlCommand_t cmd;
+	cmd.response = &response;
+	cmd.head.type = cctSTOP;
+	return SpindleExecute(h, &cmd, SpindleTimeout(timeoutMs));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_GetSnapshot( SpindleHandle_t h, SpindleSnapshot_t* snapshot )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h == NULL || snapshot == NULL ) return -1;
 
-	xSemaphoreGiveRecursive( h->syncEventPool.lockGuard );
+	// the copy is only consistent when the writer has not published a new one in between. An ISR
+	// can never loop here, because the spindle task can not publish while the ISR is running
+	unsigned int sequence;
+	do
+	{
+		sequence = h->snapshot.sequence;
+		portMEMORY_BARRIER();
+		*snapshot = h->snapshot.copy[sequence & 1];
+		portMEMORY_BARRIER();
+	}
+	while ( sequence != h->snapshot.sequence );
+	return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_GetStatus( SpindleHandle_t h, SpindleStatus_t* status, unsigned int timeoutMs )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the status is taken from the snapshot, so there is no round trip through the controller anymore
+	(void)timeoutMs;
+	SpindleSnapshot_t snapshot;
+	if ( status == NULL || SPINDLE_GetSnapshot(h, &snapshot) != 0 ) return -1;
+	status->running  = snapshot.running;
+	status->speed    = snapshot.setpoint;
+	status->measured = snapshot.measured;
+	return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_Calibrate( SpindleHandle_t h, SpindleCalibration_t* table, unsigned int timeoutMs )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h == NULL ) return -1;
+	StepCommandResponse_t response;
+	CtrlCommand_t cmd;
+	cmd.response = &response;
+	cmd.head.type = cctCALIBRATE;
+	cmd.request.args.asTable.set = NULL;
+	cmd.request.args.asTable.get = table;
+	return SpindleExecute(h, &cmd, SpindleTimeout(timeoutMs));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_SetCalibration( SpindleHandle_t h, const SpindleCalibration_t* table, unsigned int timeoutMs )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h == NULL || table == NULL ) return -1;
+	StepCommandResponse_t response;
+	CtrlCommand_t cmd;
+	cmd.response = &response;
+	cmd.head.type = cctTABLE;
+	cmd.request.args.asTable.set = table;
+	cmd.request.args.asTable.get = NULL;
+	return SpindleExecute(h, &cmd, SpindleTimeout(timeoutMs));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_GetCalibration( SpindleHandle_t h, SpindleCalibration_t* table, unsigned int timeoutMs )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h == NULL || table == NULL ) return -1;
+	StepCommandResponse_t response;
+	CtrlCommand_t cmd;
+	cmd.response = &response;
+	cmd.head.type = cctTABLE;
+	cmd.request.args.asTable.set = NULL;
+	cmd.request.args.asTable.get = table;
+	return SpindleExecute(h, &cmd, SpindleTimeout(timeoutMs));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_StartAsync( SpindleHandle_t h, float rpm )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h == NULL ) return -1;
+	CtrlCommand_t cmd;
+	cmd.head.type = cctSTART;
+	cmd.request.args.asStart.speed = rpm;
+	return SpindleSubmit(h, &cmd);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_StopAsync( SpindleHandle_t h )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h == NULL ) return -1;
+	CtrlCommand_t cmd;
+	cmd.head.type = cctSTOP;
+	return SpindleSubmit(h, &cmd);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindlePrintCalibration( const SpindleCalibration_t* t )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( t->count == 0 )
+	{
+		printf("no calibration table, duty cycle = RPM / maxRPM\r\n");
+		return;
+	}
+	for ( unsigned int i = 0; i < t->count; i++ )
+	{
+		printf("%.3f %d\r\n", t->duty[i], (int)t->rpm[i]);
+	}
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -265,14 +885,15 @@ static int SpindleConsoleFunction( int argc, char** argv, void* ctx )
 	//(spindle) start 100
 	//(spindle) stop
 	//(spindle) status
+	//(spindle) wait [timeout ms]
+	//(spindle) bench [round trips]
+	//(spindle) calibrate
+	//(spindle) table
 
 	SpindleHandle_t h = (SpindleHandle_t)ctx;
-	StepCommandResponse_t response = { 0 };
-	CtrlCommand_t cmd;
-
-	cmd.response       = &response;
-	cmd.head.requestID = h->nextRequestID;
-	h->nextRequestID += 1;
+	SpindleStatus_t status;
+	SpindleCalibration_t table;
+	int result = -1;
 
 	// first decode the subcommand and all arguments
 	if ( argc == 0 )
@@ -283,25 +904,80 @@ static int SpindleConsoleFunction( int argc, char** argv, void* ctx )
 	if ( strcmp(argv[0], "stop") == 0 )
 	{
 		// no further arguments
-		cmd.head.type = cctSTOP;
+		result = SPINDLE_Stop(h, -1);
 	}
 	else if ( strcmp(argv[0], "start") == 0 )
 	{
 		// rpm value directly after start
-		cmd.head.type = cctSTART;
-		cmd.request.args.asStart.speed    = 600.0f;
 		if ( argc < 2 )
 		{
 			printf("missing RPM value for start command\r\nFAIL");
 			return -1;
 		}
 
-		cmd.request.args.asStart.speed = (float)atof(argv[1]);
+		result = SPINDLE_Start(h, (float)atof(argv[1]), -1);
 	}
 	else if ( strcmp(argv[0], "status") == 0 )
 	{
 		// no further arguments, everything in result
+		result = SPINDLE_GetStatus(h, &status, -1);
+		if ( result == 0 )
+		{
+			printf("%d\r\n", !!status.running);
+			printf("%d\r\n", (int)status.speed);
+			printf("%d\r\n", (int)status.measured);
+		}
+	}
+	else if ( strcmp(argv[0], "wait") == 0 )
+	{
+		// there is no request to the controller, the caller is blocked until the ramp has arrived
+		unsigned int timeoutMs = ( argc > 1 ) ? (unsigned int)atoi(argv[1]) : 10000;
+		if ( SPINDLE_WaitForSpeed(h, timeoutMs) != 0 )
+		{
+			printf("timeout\r\nFAIL");
+			return -1;
+		}
+		printf("OK");
+		return 0;
+	}
+	else if ( strcmp(argv[0], "calibrate") == 0 )
+	{
+		// takes the whole sweep, the recorded table is printed even when it is not valid
+		memset(&table, 0, sizeof(table));
+		result = SPINDLE_Calibrate(h, &table, -1);
+		SpindlePrintCalibration(&table);
+	}
+	else if ( strcmp(argv[0], "table") == 0 )
+	{
+		result = SPINDLE_GetCalibration(h, &table, -1);
+		if ( result == 0 ) SpindlePrintCalibration(&table);
+	}
+	else if ( strcmp(argv[0], "bench") == 0 )
+	{
+		// measures synchronous status round trips through the controller task, the spindle is not touched
+		int rounds = ( argc > 1 ) ? atoi(argv[1]) : 1000;
+		if ( rounds <= 0 ) rounds = 1000;
+		StepCommandResponse_t response;
+		CtrlCommand_t cmd;
+		cmd.response = &response;
 		cmd.head.type = cctSTATUS;
+		uint32_t start = SPINDLE_BENCH_NOW();
+		for ( int i = 0; i < rounds; i++ )
+		{
+			if ( SpindleExecute(h, &cmd, portMAX_DELAY) != 0 )
+			{
+				printf("error returned\r\nFAIL");
+				return -1;
+			}
+		}
+		// the 32 bit counter wraps after about 20 s at 216 MHz, which is far more than the default rounds take
+		uint32_t counts = SPINDLE_BENCH_NOW() - start;
+		if ( counts == 0 ) counts = 1;
+		printf("%d round trips in %lu us, %lu counts of %lu Hz each, %lu per second\r\nOK", rounds,
+				(unsigned long)((unsigned long long)counts * 1000000u / SPINDLE_BENCH_HZ),
+				(unsigned long)(counts / (uint32_t)rounds), (unsigned long)SPINDLE_BENCH_HZ,
+				(unsigned long)((unsigned long long)rounds * SPINDLE_BENCH_HZ / counts));
+		return 0;
 	}
 	else
 	{
@@ -309,26 +985,9 @@ static int SpindleConsoleFunction( int argc, char** argv, void* ctx )
 		return -1;
 	}
 
-	// now pass the request to the controller
-	cmd.request.syncEvent = GetCommandEvent(h);
-
-	if ( pdPASS != xQueueSend( h->cmdQueue, &cmd, -1 ) )
-	{
-		ReleaseCommandEvent(h, cmd.request.syncEvent );
-		return -1;
-	}
-
-	xSemaphoreTake( cmd.request.syncEvent, -1 );
-	ReleaseCommandEvent(h, cmd.request.syncEvent );
-
-	// now decode the result in case there is one
-	if ( response.code == 0 )
+	// now decode the result
+	if ( result == 0 )
 	{
-		if ( cmd.head.type == cctSTATUS )
-		{
-			printf("%d\r\n", !!cmd.response->args.asStatus.running);
-			printf("%d\r\n", (int)cmd.response->args.asStatus.speed);
-		}
 		printf("OK");
 	}
 	else
@@ -337,113 +996,148 @@ static int SpindleConsoleFunction( int argc, char** argv, void* ctx )
 	}
 
 	// now back to console
-	return response.code;
+	return result;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+int SPINDLE_WaitForSpeed( SpindleHandle_t h, unsigned int timeoutMs )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( h == NULL ) return -1;
+	EventBits_t bits = xEventGroupWaitBits(h->events, SPINDLE_EVENT_AT_SPEED, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeoutMs));
+	return ( bits & SPINDLE_EVENT_AT_SPEED ) ? 0 : -1;
 }
 
 // --------------------------------------------------------------------------------------------------------------------
 static void SpindleRegisterBasicCommands( SpindleHandle_t h, ConsoleHandle_t cH )
 // --------------------------------------------------------------------------------------------------------------------
 {
-	CONSOLE_RegisterCommand(cH, "spindle", "<<spindle>> is used to control a spindle motor.\r\nValid subcommands are start, stop, status.\r\nStart needs an additional RPM argument!",
+	// the console copies the names, so the name of the instance must only be valid during the registration
+	char* name = (char*)h->physical.name;
+	CONSOLE_RegisterCommand(cH, name, "is used to control a spindle motor.\r\nValid subcommands are start, stop, status, wait, calibrate, table, bench.\r\nStart needs an additional RPM argument, wait an optional timeout in ms!\r\n"
+			"Bench measures status round trips through the controller task, with an optional number of rounds.\r\n"
+			"Calibrate stores the table at the end, which may stall the controller (e.g. a flash erase). When the\r\n"
+			"platform refuses to store it, e.g. during a stepper move, the table is used but FAIL is returned.",
 			SpindleConsoleFunction, h);
+	CONSOLE_RegisterSubcommand(cH, name, "start");
+	CONSOLE_RegisterSubcommand(cH, name, "stop");
+	CONSOLE_RegisterSubcommand(cH, name, "status");
+	CONSOLE_RegisterSubcommand(cH, name, "wait");
+	CONSOLE_RegisterSubcommand(cH, name, "bench");
+	CONSOLE_RegisterSubcommand(cH, name, "calibrate");
+	CONSOLE_RegisterSubcommand(cH, name, "table");
 }
 
 // --------------------------------------------------------------------------------------------------------------------
-SpindleHandle_t SPINDLE_CreateInstance( unsigned int uxStackDepth, int xPrio, ConsoleHandle_t cH, SpindlePhysicalParams_t* p )
+static int SpindleCheckParams( ConsoleHandle_t cH, SpindlePhysicalParams_t* p )
 // --------------------------------------------------------------------------------------------------------------------
 {
-#define ON_NULL_GOTO_ERROR(x) do { if ((x) == NULL) goto error; } while(0);
-	// singleton pattern
-	if ( SpindleInstancePointer != NULL ) return SpindleInstancePointer;
-
-	if ( p == NULL || p->enaPWM == NULL || p->setDirection == NULL ||
-	     p->minRPM >= p->maxRPM || p->setDutyCycle == NULL || cH == NULL )
-		return NULL;
-
-	struct SpindleHandle* h = calloc(sizeof(struct SpindleHandle), 1);
-	ON_NULL_GOTO_ERROR(h);
+	return !( p == NULL || p->enaPWM == NULL || p->setDirection == NULL ||
+	          p->minRPM >= p->maxRPM || p->setDutyCycle == NULL || cH == NULL );
+}
 
-	if ( h == NULL ) return NULL;
+// --------------------------------------------------------------------------------------------------------------------
+static void SpindleSetup( SpindleHandle_t h, ConsoleHandle_t cH, SpindlePhysicalParams_t* p )
+// --------------------------------------------------------------------------------------------------------------------
+{
 	h->consoleH = cH;
-	h->cancel = 0;
 	h->nextRequestID = 0;
-	h->cmdQueue = xQueueCreate(16, sizeof(CtrlCommand_t));
-	ON_NULL_GOTO_ERROR(h->cmdQueue);
 
 	// copy arguments
 	memcpy(&h->physical, p, sizeof(SpindlePhysicalParams_t));
+	if ( h->physical.controlPeriodMs == 0 ) h->physical.controlPeriodMs = 10;
+	if ( h->physical.name == NULL ) h->physical.name = "spindle";
+}
 
-	// now we create the sync event pool
-	LIST_INIT(&h->syncEventPool.pool);
-	h->syncEventPool.lockGuard = xSemaphoreCreateRecursiveMutex();
-	ON_NULL_GOTO_ERROR(h->syncEventPool.lockGuard);
-	for ( int i = 0; i < 8; i++)
-	{
-		stepSyncEventElement_t* el = (stepSyncEventElement_t*)calloc(sizeof(stepSyncEventElement_t), 1);
-		ON_NULL_GOTO_ERROR(el);
-		el->content.allocated = 0;
-		el->content.event = xSemaphoreCreateBinary();
-		if (el->content.event == NULL)
+// --------------------------------------------------------------------------------------------------------------------
+static int SpindleActivate( SpindleHandle_t h, ConsoleHandle_t cH )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// the worker initializes the instance and adds it to its list, this also works before the scheduler runs
+	CtrlCommand_t cmd;
+	cmd.head.type = cctINIT;
+	if ( SpindleSubmit(h, &cmd) != 0 ) return -1;
+
+	// setup the console commands
+	SpindleRegisterBasicCommands(h, cH);
+	return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+SpindleHandle_t SPINDLE_CreateInstance( unsigned int uxStackDepth, int xPrio, ConsoleHandle_t cH, SpindlePhysicalParams_t* p )
+// --------------------------------------------------------------------------------------------------------------------
+{
+#define ON_NULL_GOTO_ERROR(x) do { if ((x) == NULL) goto error; } while(0);
+	if ( !SpindleCheckParams(cH, p) ) return NULL;
+
+	struct SpindleHandle* h = calloc(sizeof(struct SpindleHandle), 1);
+	if ( h == NULL ) return NULL;
+	h->events = xEventGroupCreate();
+	ON_NULL_GOTO_ERROR(h->events);
+	SpindleSetup(h, cH, p);
+
+	// the first instance creates the worker task which handles all communications and the RPM generation
+	// of all instances, the stack depth and the priority of later instances are not used
+	if ( SpindleWorker.cmdQueue == NULL )
+	{
+		SpindleWorker.cmdQueue = xQueueCreate(SPINDLE_STATIC_QUEUE_LENGTH, sizeof(CtrlCommand_t));
+		ON_NULL_GOTO_ERROR(SpindleWorker.cmdQueue);
+		xTaskCreate(SpindleWorkerFunction, "spindlectrl", uxStackDepth, NULL, xPrio, &SpindleWorker.tHandle);
+		if ( SpindleWorker.tHandle == NULL )
 		{
-			free(el);
-			el = NULL;
+			vQueueDelete(SpindleWorker.cmdQueue);
+			SpindleWorker.cmdQueue = NULL;
 			goto error;
 		}
-		else
-		{
-			LIST_INSERT_HEAD(&h->syncEventPool.pool, el, navigate);
-		}
 	}
 
-	// setup the console commands
-	SpindleRegisterBasicCommands(h, cH);
-	SpindleInstancePointer = h;
-
-	// setup the task which handles all communications and the RPM generation
-	xTaskCreate(SpindleFunction, "spindlectrl", uxStackDepth, h, xPrio, &h->tHandle);
-	ON_NULL_GOTO_ERROR(h->tHandle);
+	if ( SpindleActivate(h, cH) != 0 ) goto error;
 	return h;
 
 error:
-	if (h != NULL)
+	if (h->events != NULL)
 	{
-		if (h->cmdQueue != NULL)
-		{
-			vQueueDelete(h->cmdQueue);
-			h->cmdQueue = NULL;
-		}
+		vEventGroupDelete(h->events);
+		h->events = NULL;
+	}
+	free(h);
+	return NULL;
+}
 
-		if (h->syncEventPool.lockGuard != NULL)
-		{
-			vSemaphoreDelete(h->syncEventPool.lockGuard);
-			h->syncEventPool.lockGuard = NULL;
-		}
+#if defined(configSUPPORT_STATIC_ALLOCATION) && ( configSUPPORT_STATIC_ALLOCATION == 1 )
+// --------------------------------------------------------------------------------------------------------------------
+SpindleHandle_t SPINDLE_CreateStatic( unsigned int uxStackDepth, int xPrio, ConsoleHandle_t cH, SpindlePhysicalParams_t* p,
+		SpindleStaticBuffers_t* buffers )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// fails to compile when the reserved words of the header are too small for the current platform
+	typedef char SpindleStaticHandleCheck_t[ ( sizeof(struct SpindleHandle) <= sizeof(buffers->handle) ) ? 1 : -1 ];
+	typedef char SpindleStaticCommandCheck_t[ ( sizeof(CtrlCommand_t) <= SPINDLE_STATIC_COMMAND_WORDS * sizeof(void*) ) ? 1 : -1 ];
+	(void)sizeof(SpindleStaticHandleCheck_t);
+	(void)sizeof(SpindleStaticCommandCheck_t);
 
-		// first clean all event elements
-		stepSyncEventElement_t* el = NULL;
-		stepSyncEventElement_t* tel = NULL;
-		for (el = LIST_FIRST(&h->syncEventPool.pool); el && (tel = LIST_NEXT(el, navigate), 1); el = tel)
-		{
-			if (el->content.event != NULL)
-			{
-				vSemaphoreDelete(el->content.event);
-				el->content.event = NULL;
-			}
-		}
+	if ( !SpindleCheckParams(cH, p) || buffers == NULL ) return NULL;
+	if ( SpindleWorker.cmdQueue == NULL && ( buffers->worker == NULL || buffers->worker->stack == NULL ) ) return NULL;
 
-		// now remove all elements one by one from the list and free them
-		while (!LIST_EMPTY(&h->syncEventPool.pool))
-		{
-			stepSyncEventElement_t* el = LIST_FIRST(&h->syncEventPool.pool);
-			if (el != NULL)
-			{
-				LIST_REMOVE(el, navigate);
-				free(el);
-			}
-		}
+	struct SpindleHandle* h = (struct SpindleHandle*)buffers->handle;
+	memset(h, 0, sizeof(struct SpindleHandle));
+	h->events = xEventGroupCreateStatic(&buffers->events);
+	SpindleSetup(h, cH, p);
 
-		free(h);
+	// the worker buffers of the first instance are used, later instances do not need them
+	if ( SpindleWorker.cmdQueue == NULL )
+	{
+		SpindleWorker.cmdQueue = xQueueCreateStatic(SPINDLE_STATIC_QUEUE_LENGTH, sizeof(CtrlCommand_t),
+				(uint8_t*)buffers->worker->queueStorage, &buffers->worker->queue);
+		SpindleWorker.tHandle = xTaskCreateStatic(SpindleWorkerFunction, "spindlectrl", uxStackDepth, NULL, xPrio,
+				buffers->worker->stack, &buffers->worker->task);
 	}
 
-	return NULL;
+	if ( SpindleActivate(h, cH) != 0 )
+	{
+		vEventGroupDelete(h->events);
+		return NULL;
+	}
+	return h;
 }
+#endif
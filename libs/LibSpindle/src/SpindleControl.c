@@ -0,0 +1,85 @@
+/*
+ * SpindleControl.c
+ *
+ *  Created on: Feb 4, 2026
+ *      Author: Basti
+ */
+
+ /*! \file */
+
+#include <math.h>
+
+#include "SpindleControl.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+int SpindleCalibrationValid( const SpindleCalibration_t* t )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( t->count < 2 || t->count > SPINDLE_CALIBRATION_POINTS ) return 0;
+
+	// the comparisons are written in a way that NaN values are rejected as well
+	if ( !( t->duty[0] >= 0.0f ) || !( t->duty[t->count - 1] <= 1.0f ) || !( t->rpm[0] >= 0.0f ) ) return 0;
+	for ( unsigned int i = 1; i < t->count; i++ )
+	{
+		if ( !( t->duty[i] > t->duty[i - 1] ) || !( t->rpm[i] >= t->rpm[i - 1] ) ) return 0;
+	}
+	return t->rpm[t->count - 1] > 0.0f;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+float SpindleCalibrationDuty( const SpindleCalibration_t* t, float maxRPM, float rpm )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	rpm = fabsf(rpm);
+	if ( t->count == 0 ) return rpm / maxRPM;
+	if ( rpm <= 0.0f ) return 0.0f;
+
+	// binary search for the first point which is not slower than the requested speed
+	unsigned int lo = 0;
+	unsigned int hi = t->count;
+	while ( lo < hi )
+	{
+		unsigned int mid = ( lo + hi ) / 2;
+		if ( t->rpm[mid] < rpm ) lo = mid + 1;
+		else hi = mid;
+	}
+
+	float duty;
+	if ( lo == t->count )
+	{
+		// faster than the table, extrapolated from the last point
+		duty = t->duty[lo - 1] * rpm / t->rpm[lo - 1];
+	}
+	else if ( lo == 0 )
+	{
+		duty = t->duty[0] * rpm / t->rpm[0];
+	}
+	else
+	{
+		// the point before is slower than the requested speed, so there is no division by zero. Within the
+		// deadband the interpolation starts at the last duty cycle which did not turn the spindle
+		float f = ( rpm - t->rpm[lo - 1] ) / ( t->rpm[lo] - t->rpm[lo - 1] );
+		duty = t->duty[lo - 1] + f * ( t->duty[lo] - t->duty[lo - 1] );
+	}
+	return ( duty > 1.0f ) ? 1.0f : duty;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+float SpindleControlOutput( float* integral, float kp, float ki, float feedForward, float error, float dt, int* saturated )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	float next = *integral + ki * error * dt;
+	float duty = feedForward + kp * error + next;
+
+	// anti windup, the integral part is only taken over while the output is not saturated
+	*saturated = 0;
+	if ( duty > 1.0f )
+	{
+		duty = 1.0f;
+		*saturated = 1;
+	}
+	else if ( duty < 0.0f ) duty = 0.0f;
+	else *integral = next;
+
+	return duty;
+}
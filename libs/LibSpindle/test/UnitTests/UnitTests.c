@@ -0,0 +1,320 @@
+
+// standard includes for the unit test framework
+#include <stdio.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <math.h>
+#include <string.h>
+
+// includes for the library, only the calibration table and the controller which do not need FreeRTOS
+#include "SpindleControl.h"
+
+
+// ====================================================================================================================
+// area of state helpers and mockup functions
+// ====================================================================================================================
+
+#define TEST_MAX_RPM        9000.0f
+#define TEST_DEADBAND       0.1f
+#define TEST_TIME_CONSTANT  0.15f
+#define TEST_KP             0.00005f
+#define TEST_KI             0.0002f
+#define TEST_DT             0.01f
+
+#define assert_near(a, b, eps) assert_true(fabsf((float)(a) - (float)(b)) <= (eps))
+
+// first order model of the spindle motor, the steady state speed is linear above a deadband of the duty cycle
+struct myMotor
+{
+	float           gain;
+	float           speed;
+};
+
+// result of a closed loop run against the motor model
+struct myResponse
+{
+	float           peak;
+	float           settleTime;
+	float           final;
+	int             saturatedSteps;
+};
+
+struct myState
+{
+	SpindleCalibration_t table;
+	struct myMotor       motor;
+	float                integral;
+};
+
+static struct myState myState;
+
+// --------------------------------------------------------------------------------------------------------------------
+static float myMotorSteadyState( float gain, float duty )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	if ( duty <= TEST_DEADBAND ) return 0.0f;
+	return gain * TEST_MAX_RPM * ( duty - TEST_DEADBAND ) / ( 1.0f - TEST_DEADBAND );
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void myMotorStep( struct myMotor* m, float duty, float dt )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	// exact discretization of the first order lag, stable for any dt
+	float a = expf(-dt / TEST_TIME_CONSTANT);
+	m->speed = a * m->speed + ( 1.0f - a ) * myMotorSteadyState(m->gain, duty);
+}
+
+// records the table the same way the calibration sweep does it, with the nominal motor
+// --------------------------------------------------------------------------------------------------------------------
+static void myRecordTable( SpindleCalibration_t* t )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	memset(t, 0, sizeof(SpindleCalibration_t));
+	for ( unsigned int i = 0; i < SPINDLE_CALIBRATION_POINTS; i++ )
+	{
+		t->duty[i] = (float)i / (float)( SPINDLE_CALIBRATION_POINTS - 1 );
+		t->rpm[i] = myMotorSteadyState(1.0f, t->duty[i]);
+	}
+	t->count = SPINDLE_CALIBRATION_POINTS;
+}
+
+// runs the controller for the given time with the speed of the motor as measurement, the response is measured
+// from the speed at the call to the target
+// --------------------------------------------------------------------------------------------------------------------
+static void myRunLoop( struct myState* s, float target, float seconds, struct myResponse* r )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	float start = s->motor.speed;
+	float band = 0.02f * fabsf(target - start);
+	float feedForward = SpindleCalibrationDuty(&s->table, TEST_MAX_RPM, target);
+	int steps = (int)( seconds / TEST_DT + 0.5f );
+
+	memset(r, 0, sizeof(struct myResponse));
+	r->peak = start;
+	for ( int i = 0; i < steps; i++ )
+	{
+		int saturated;
+		float duty = SpindleControlOutput(&s->integral, TEST_KP, TEST_KI, feedForward, target - s->motor.speed, TEST_DT, &saturated);
+		assert_true(duty >= 0.0f && duty <= 1.0f);
+		r->saturatedSteps += saturated;
+
+		myMotorStep(&s->motor, duty, TEST_DT);
+		if ( ( target > start && s->motor.speed > r->peak ) || ( target < start && s->motor.speed < r->peak ) ) r->peak = s->motor.speed;
+
+		// the settle time is the end of the last step outside of the band
+		if ( fabsf(s->motor.speed - target) > band ) r->settleTime = (float)( i + 1 ) * TEST_DT;
+	}
+	r->final = s->motor.speed;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int myStartFixtureFunction( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	memset(&myState, 0, sizeof(myState));
+	myRecordTable(&myState.table);
+	myState.motor.gain = 1.0f;
+	*state = &myState;
+	return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static int myStopFixtureFunction( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	(void)state;
+	return 0;
+}
+
+
+// ====================================================================================================================
+// area of test functions
+// ====================================================================================================================
+
+// --------------------------------------------------------------------------------------------------------------------
+static void calibration_valid_table( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	assert_int_equal(SpindleCalibrationValid(&s->table), 1);
+
+	// points with the same speed are the deadband and allowed
+	assert_near(s->table.rpm[0], 0.0f, 0.001f);
+	assert_near(s->table.rpm[1], 0.0f, 0.001f);
+
+	// two points are enough
+	SpindleCalibration_t t = { .count = 2, .duty = { 0.0f, 1.0f }, .rpm = { 0.0f, 9000.0f } };
+	assert_int_equal(SpindleCalibrationValid(&t), 1);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void calibration_rejects_invalid_table( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	SpindleCalibration_t t;
+
+	// not enough or too many points
+	t = s->table; t.count = 1;
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+	t = s->table; t.count = SPINDLE_CALIBRATION_POINTS + 1;
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+
+	// the duty cycles must increase strictly
+	t = s->table; t.duty[5] = t.duty[4];
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+
+	// the speeds must not decrease
+	t = s->table; t.rpm[8] = t.rpm[7] - 1.0f;
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+
+	// duty cycles outside of 0.0 to 1.0 and negative speeds
+	t = s->table; t.duty[0] = -0.1f;
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+	t = s->table; t.duty[SPINDLE_CALIBRATION_POINTS - 1] = 1.1f;
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+	t = s->table; t.rpm[0] = -1.0f;
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+
+	// a spindle which never turned and NaN values
+	t = s->table; memset(t.rpm, 0, sizeof(t.rpm));
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+	t = s->table; t.rpm[6] = NAN;
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+	t = s->table; t.duty[6] = NAN;
+	assert_int_equal(SpindleCalibrationValid(&t), 0);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void calibration_interpolation( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+
+	// above the point where the deadband ends the table gives back the duty cycle of the model
+	for ( float rpm = 300.0f; rpm <= TEST_MAX_RPM; rpm += 100.0f )
+	{
+		float duty = SpindleCalibrationDuty(&s->table, TEST_MAX_RPM, rpm);
+		assert_near(myMotorSteadyState(1.0f, duty), rpm, 0.5f);
+	}
+
+	// exactly on a point, the sign is ignored and a stopped spindle has no duty cycle
+	assert_near(SpindleCalibrationDuty(&s->table, TEST_MAX_RPM, s->table.rpm[8]), s->table.duty[8], 0.0001f);
+	assert_near(SpindleCalibrationDuty(&s->table, TEST_MAX_RPM, -s->table.rpm[8]), s->table.duty[8], 0.0001f);
+	assert_near(SpindleCalibrationDuty(&s->table, TEST_MAX_RPM, 0.0f), 0.0f, 0.0001f);
+
+	// a slow speed starts at the last duty cycle of the deadband
+	assert_true(SpindleCalibrationDuty(&s->table, TEST_MAX_RPM, 1.0f) > s->table.duty[1]);
+
+	// faster than the table is extrapolated and limited to full duty
+	SpindleCalibration_t t = { .count = 3, .duty = { 0.0f, 0.25f, 0.5f }, .rpm = { 0.0f, 1000.0f, 3000.0f } };
+	assert_near(SpindleCalibrationDuty(&t, TEST_MAX_RPM, 2000.0f), 0.375f, 0.0001f);
+	assert_near(SpindleCalibrationDuty(&t, TEST_MAX_RPM, 4500.0f), 0.75f, 0.0001f);
+	assert_near(SpindleCalibrationDuty(&t, TEST_MAX_RPM, 9000.0f), 1.0f, 0.0001f);
+
+	// slower than the first point with a speed
+	SpindleCalibration_t u = { .count = 2, .duty = { 0.5f, 1.0f }, .rpm = { 4000.0f, 9000.0f } };
+	assert_near(SpindleCalibrationDuty(&u, TEST_MAX_RPM, 2000.0f), 0.25f, 0.0001f);
+
+	// without a table the duty cycle is proportional to the speed
+	t.count = 0;
+	assert_near(SpindleCalibrationDuty(&t, TEST_MAX_RPM, 4500.0f), 0.5f, 0.0001f);
+}
+
+// the motor is 15 percent weaker than recorded in the table, the integral part has to make up the difference
+// --------------------------------------------------------------------------------------------------------------------
+static void control_step_response( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	struct myResponse r;
+	s->motor.gain = 0.85f;
+
+	myRunLoop(s, 3000.0f, 5.0f, &r);
+	assert_near(r.final, 3000.0f, 5.0f);
+	assert_true(r.settleTime <= 1.0f);
+	assert_true(r.peak <= 3000.0f + 0.1f * 3000.0f);
+	assert_int_equal(r.saturatedSteps, 0);
+
+	// a step down to a slow speed
+	myRunLoop(s, 1000.0f, 5.0f, &r);
+	assert_near(r.final, 1000.0f, 5.0f);
+	assert_true(r.settleTime <= 1.0f);
+	assert_true(r.peak >= 1000.0f - 0.1f * 2000.0f);
+}
+
+// with an exact table the proportional part still drives the start of a large step, the overshoot stays limited
+// --------------------------------------------------------------------------------------------------------------------
+static void control_large_step( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	struct myResponse r;
+
+	myRunLoop(s, 6000.0f, 5.0f, &r);
+	assert_near(r.final, 6000.0f, 5.0f);
+	assert_true(r.settleTime <= 2.0f);
+	assert_true(r.peak <= 6000.0f + 0.1f * 6000.0f);
+}
+
+// a speed which the weak motor can not reach saturates the output, the integral must not wind up meanwhile
+// --------------------------------------------------------------------------------------------------------------------
+static void control_anti_windup( void** state )
+// --------------------------------------------------------------------------------------------------------------------
+{
+	struct myState* s = (struct myState*)*state;
+	struct myResponse r;
+	s->motor.gain = 0.85f;
+
+	myRunLoop(s, 8500.0f, 5.0f, &r);
+	assert_true(r.saturatedSteps > 0);
+	assert_near(r.final, 0.85f * TEST_MAX_RPM, 10.0f);
+
+	// without the limit the integral would have grown to ki * 850 RPM * 5 s = 0.85
+	assert_true(s->integral <= 0.05f);
+
+	// back to a reachable speed the undershoot stays limited
+	myRunLoop(s, 3000.0f, 5.0f, &r);
+	assert_near(r.final, 3000.0f, 5.0f);
+	assert_true(r.settleTime <= 2.5f);
+	assert_true(r.peak >= 3000.0f - 0.15f * ( 0.85f * TEST_MAX_RPM - 3000.0f ));
+}
+
+
+// ====================================================================================================================
+// area of main entry point and test execution as well as its corresponding variables
+// ====================================================================================================================
+
+// interpolation and validation of the calibration table
+// --------------------------------------------------------------------------------------------------------------------
+const struct CMUnitTest calibration_tests[] = {
+	cmocka_unit_test_setup_teardown(calibration_valid_table,           myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(calibration_rejects_invalid_table, myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(calibration_interpolation,         myStartFixtureFunction, myStopFixtureFunction),
+};
+
+// speed controller closed against a first order model of the motor
+// --------------------------------------------------------------------------------------------------------------------
+const struct CMUnitTest control_tests[] = {
+	cmocka_unit_test_setup_teardown(control_step_response,      myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(control_large_step,         myStartFixtureFunction, myStopFixtureFunction),
+	cmocka_unit_test_setup_teardown(control_anti_windup,        myStartFixtureFunction, myStopFixtureFunction),
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+int main()
+// --------------------------------------------------------------------------------------------------------------------
+{
+	int result = 0;
+	cmocka_set_message_output(CM_OUTPUT_STDOUT);
+	result |= cmocka_run_group_tests(calibration_tests, NULL, NULL);
+	result |= cmocka_run_group_tests(control_tests, NULL, NULL);
+	return result;
+}
@@ -14,5 +14,20 @@
 #define CONSOLE_LINE_SIZE 120
 #define CONSOLE_COMMAND_MAX_LENGTH 64
 #define CONSOLE_HELP_MAX_LENGTH 512
+#define CONSOLE_JOB_WORKERS 2
+#define CONSOLE_JOB_MAX 4
+#define CONSOLE_JOB_STACK_DEPTH (2 * configMINIMAL_STACK_SIZE)
+// idle workers should not wake up the CPU from tickless idle ten times per second
+#define CONSOLE_JOB_POLL_MS 1000
+
+#include "Memory_implementation/my_pool.h"
+#if POOL_FOR_CONSOLE
+#define CONSOLE_MALLOC(size) Pool_Malloc(size)
+#define CONSOLE_FREE(ptr) Pool_Free(ptr)
+#endif
+
+#include "Runtime_implementation/my_trace.h"
+#define CONSOLE_TRACE_BEGIN(cmd) TRACE_COMMAND(cmd)
+#define CONSOLE_TRACE_END(result) TRACE_EVENT(TRACE_CONSOLE_END, result)
 
 #endif /* INC_CONSOLE_CONSOLECONFIG_H_ */
@@ -23,14 +23,14 @@
   extern uint32_t SystemCoreClock;
 /* USER CODE BEGIN 0 */
     extern void configureTimerForRunTimeStats(void);
-    extern unsigned long getRunTimeCounterValue(void);
+    extern uint64_t getRunTimeCounterValue(void);
 /* USER CODE END 0 */
 #endif
 #define configENABLE_FPU                         1
 #define configENABLE_MPU                         0
 
 #define configUSE_PREEMPTION                     1
-#define configSUPPORT_STATIC_ALLOCATION          0
+#define configSUPPORT_STATIC_ALLOCATION          1
 #define configSUPPORT_DYNAMIC_ALLOCATION         1
 #define configUSE_IDLE_HOOK                      0
 #define configUSE_TICK_HOOK                      0
@@ -77,6 +77,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelayUntil              1
 #define INCLUDE_vTaskDelay                   1
 #define INCLUDE_xTaskGetSchedulerState       1
+#define INCLUDE_xTaskGetIdleTaskHandle       1
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
@@ -122,8 +123,10 @@ standard names. */
 
 /* USER CODE BEGIN 2 */
 /* Definitions needed when configGENERATE_RUN_TIME_STATS is on */
-#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()  //SetupRunTimeStatsTimer
-#define portGET_RUN_TIME_COUNTER_VALUE() (xTaskGetTickCount())//GetHighFrequencyTickValue
+/* DWT cycle counter extended to 64 bit, interrupt time excluded (see my_runtime.c) */
+#define configRUN_TIME_COUNTER_TYPE               uint64_t
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()  configureTimerForRunTimeStats()
+#define portGET_RUN_TIME_COUNTER_VALUE()          getRunTimeCounterValue()
 
 #define configISR_STACK_SIZE_WORDS 4096
 #define configUSE_NEWLIB_REENTRANT 1
@@ -132,7 +135,19 @@ standard names. */
 /* USER CODE BEGIN Defines */
 #define configAPPLICATION_ALLOCATED_HEAP           1
 #define configRECORD_STACK_HIGH_ADDRESS            1  /* 1: record stack high address for the debugger, 0: do not record stack high address */
+/* tickless idle: SysTick stays the time base and is stretched over the idle time, the CPU sleeps in WFI while all
+   timers keep running. Skipped while the stepper or the spindle run (see my_power.c) */
+#ifndef WIN32
+#define configUSE_TICKLESS_IDLE                    1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP      2
+#endif
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  /* binary event trace fed by the kernel trace macros (see my_trace.h) */
+  #include "Runtime_implementation/my_trace.h"
+  #include "Runtime_implementation/my_power.h"
+  #define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )  Power_SuppressTicksAndSleep( xExpectedIdleTime )
+#endif
 
 
 /* USER CODE END Defines */
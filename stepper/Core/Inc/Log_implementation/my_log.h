@@ -0,0 +1,62 @@
+/*
+ * my_log.h
+ *
+ *  Created on: Jan 30, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_LOG_H
+#define MY_LOG_H
+
+#include <stdint.h>
+#include <string.h>
+
+// verzoegerte Ausgabe ueber den Log Task (log Befehl), 0 entfernt den Ring und alle LOG Aufrufe
+#define LOG_ENABLE      1
+
+// Stufen, eine Meldung wird aufgezeichnet, wenn ihre Stufe <= der Schwelle ihres Moduls ist
+#define LOG_OFF         0
+#define LOG_ERROR       1
+#define LOG_WARN        2
+#define LOG_INFO        3
+#define LOG_DEBUG       4
+
+// Module mit eigener Schwelle, die Namen stehen in my_log.c
+#define LOG_SYSTEM      0
+#define LOG_STEPPER     1
+#define LOG_SPINDLE     2
+#define LOG_CONSOLE     3
+#define LOG_MODULES     4
+
+// Argumente je Meldung, jedes wird als rohes 32 Bit Wort gespeichert
+#define LOG_MAX_ARGS    4
+
+struct ConsoleHandle;
+
+// Aufzeichnung ohne Formatierung und ohne Sperre, aus Tasks und allen Interrupts aufrufbar. Die Formatzeichenkette
+// muss ein Literal sein, im Ring steht nur ihre Adresse. Erlaubt sind %d %i %u %x %X %o %c und %f %e %g mit
+// LOG_FLOAT, Breite und Genauigkeit werden uebernommen, %s nicht.
+void Log_Write(uint8_t level, uint8_t module, const char* format, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+// Bits eines float, der Log Task macht daraus wieder die Zahl (ein einfacher Cast wuerde sie abschneiden)
+static inline uint32_t Log_FloatBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+#if LOG_ENABLE
+// LOG(level, module, format, bis zu LOG_MAX_ARGS Argumente), fehlende Argumente werden mit 0 aufgefuellt
+#define LOG(level, module, ...)     LOG_ARGS_((level), (module), __VA_ARGS__, 0, 0, 0, 0, 0)
+#define LOG_ARGS_(level, module, format, a0, a1, a2, a3, ...) \
+		Log_Write((level), (module), (format), (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3))
+#define LOG_FLOAT(value)            Log_FloatBits((float)(value))
+#else
+#define LOG(level, module, ...)
+#define LOG_FLOAT(value)            0
+#endif
+
+void Log_Init(struct ConsoleHandle* c);
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ * my_heap.h
+ *
+ *  Created on: Jan 29, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_HEAP_H
+#define MY_HEAP_H
+
+#include <stddef.h>
+
+// Aufrufer und Groesse jedes lebenden malloc Blocks mitschreiben (heap Befehl), 0 laesst nur die Wrapper in
+// newlib_abs.c als reine Weiterleitung uebrig. Auf dem Target kommen alle Anforderungen ueber die --wrap Optionen
+// des Linkers, in der Host Simulation nur die, die der Pool an malloc weitergibt.
+#define HEAP_TRACKER    1
+
+struct ConsoleHandle;
+
+// beide sperren selbst, __malloc_lock ist rekursiv und darf schon gehalten werden
+void Heap_TrackAlloc(void* ptr, size_t size, void* caller);
+void Heap_TrackFree(void* ptr);
+
+void Heap_Init(struct ConsoleHandle* c);
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * my_pool.h
+ *
+ *  Created on: Jan 19, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_POOL_H
+#define MY_POOL_H
+
+#include <stddef.h>
+
+// Auswahl, welche Anforderungen aus den Pools bedient werden (1) und welche direkt von newlib malloc (0)
+#define POOL_FOR_RTOS       1   // pvPortMalloc / vPortFree
+#define POOL_FOR_STEPPER    1   // StepLibraryMalloc / StepLibraryFree
+#define POOL_FOR_CONSOLE    1   // Handle, Befehle und Knoten der LibRTOSConsole (siehe ConsoleConfig.h)
+
+// eigene Blockgroesse 1024 Byte fuer die Befehle und Aliase der Konsole (je Eintrag ca. 740 Byte), das sind 32 KB der
+// sonst ca. 47 KB statischen RAMs der Pools. Mit 0 gehen diese Eintraege an malloc, der Heap belegt dann nur die
+// tatsaechlich registrierten (26 Befehle, ca. 19 KB). Sie werden beim Start angelegt, ISRs fordern sie nie an
+#define POOL_CONSOLE_COMMANDS   0
+
+struct ConsoleHandle;
+
+// Blockgroessen 16/32/64/128/512 Byte (und 1024 mit POOL_CONSOLE_COMMANDS), Belegen und Freigeben in O(1) und auch aus einer ISR erlaubt.
+// Passt eine Anforderung in keinen freien Block, wird sie (nur im Task Kontext) an malloc weitergegeben.
+void* Pool_Malloc(size_t size);
+void Pool_Free(void* ptr);
+
+void Pool_Init(struct ConsoleHandle* c);
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ * my_isrstat.h
+ *
+ *  Created on: Jan 23, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_ISRSTAT_H
+#define MY_ISRSTAT_H
+
+#include <stdint.h>
+
+// Dauer und Jitter der Interrupts messen (isr Befehl), 0 entfernt die Messung komplett
+#define ISRSTAT_ENABLE  1
+
+// gemessene Interruptquellen
+typedef enum
+{
+	ISRSTAT_STEP = 0,   // TIM4, ein Schrittpuls
+	ISRSTAT_LIMIT,      // EXTI9_5, Endschalter
+	ISRSTAT_TACHO,      // EXTI0, Drehzahlgeber der Spindel
+	ISRSTAT_PWM,        // TIM2, Dithering der Spindel PWM
+	ISRSTAT_SOURCES
+} IsrStatSource_t;
+
+struct ConsoleHandle;
+
+uint32_t IsrStat_Enter(IsrStatSource_t source);
+void IsrStat_Exit(IsrStatSource_t source, uint32_t start);
+void IsrStat_Restart(IsrStatSource_t source);
+
+// ISRSTAT_ENTER und ISRSTAT_EXIT stehen am Anfang und am Ende derselben Funktion
+#if ISRSTAT_ENABLE
+#define ISRSTAT_ENTER(source)   uint32_t isrStatStart = IsrStat_Enter(source)
+#define ISRSTAT_EXIT(source)    IsrStat_Exit(source, isrStatStart)
+#define ISRSTAT_RESTART(source) IsrStat_Restart(source)
+#else
+#define ISRSTAT_ENTER(source)
+#define ISRSTAT_EXIT(source)
+#define ISRSTAT_RESTART(source)
+#endif
+
+void IsrStat_Init(struct ConsoleHandle* c);
+
+#endif
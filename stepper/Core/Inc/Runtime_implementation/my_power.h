@@ -0,0 +1,31 @@
+/*
+ * my_power.h
+ *
+ *  Created on: Jan 28, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_POWER_H
+#define MY_POWER_H
+
+#include <stdint.h>
+
+// Gruende, den Tick nicht abzuschalten (Bitmaske fuer Power_SetBusy)
+#define POWER_BUSY_STEPPER  (1u << 0)   // Fahrt mit dem Schrittmotor
+#define POWER_BUSY_SPINDLE  (1u << 1)   // Spindel PWM aktiv, die Drehzahl wird mit CYCCNT gemessen
+
+// Ersatz fuer portSUPPRESS_TICKS_AND_SLEEP (siehe FreeRTOSConfig.h): schlaeft ueber vPortSuppressTicksAndSleep,
+// solange kein Grund aus Power_SetBusy gesetzt ist. Der Parameter ist ein TickType_t.
+void Power_SuppressTicksAndSleep(uint32_t expectedIdleTime);
+
+// aus Tasks und Interrupts aufrufbar
+void Power_SetBusy(uint32_t reason, int busy);
+
+// 1 wenn einer der Gruende in reason gesetzt ist, z.B. POWER_BUSY_STEPPER waehrend einer Fahrt
+int Power_IsBusy(uint32_t reason);
+
+// Anzahl der Schlafphasen des Idle Tasks (jede endet mit einem Aufwachen) und die darin uebersprungenen Ticks
+uint32_t Power_GetWakeups(void);
+uint32_t Power_GetSleptTicks(void);
+
+#endif
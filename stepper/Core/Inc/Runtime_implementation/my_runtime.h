@@ -0,0 +1,44 @@
+/*
+ * my_runtime.h
+ *
+ *  Created on: Jan 21, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_RUNTIME_H
+#define MY_RUNTIME_H
+
+#include <stdint.h>
+
+// Zeit in den Interrupts getrennt von den Tasks erfassen (RUNTIME_ISR_ENTER/EXIT in stm32f7xx_it.c)
+#define RUNTIME_ISR_ACCOUNTING  1
+
+struct ConsoleHandle;
+
+// Zeitbasis der FreeRTOS Laufzeitstatistik (siehe FreeRTOSConfig.h): DWT CYCCNT auf 64 Bit erweitert, in der
+// Host Simulation eine monotone Uhr in us. Die Zeit in Interrupts wird herausgerechnet, damit die Tasks nur ihre
+// eigene Rechenzeit bekommen.
+void configureTimerForRunTimeStats(void);
+uint64_t getRunTimeCounterValue(void);
+
+// Zyklen seit dem Start des Schedulers (inklusive Interrupts) und die davon in Interrupts verbrachten Zyklen
+uint64_t Runtime_GetCycles(void);
+uint64_t Runtime_GetIsrCycles(void);
+
+// Zyklen, die CYCCNT im Tickless Idle nicht gezaehlt hat (aus Power_SuppressTicksAndSleep)
+void Runtime_AddSleepCycles(uint64_t cycles);
+
+void Runtime_IsrEnter(void);
+void Runtime_IsrExit(void);
+
+#if RUNTIME_ISR_ACCOUNTING
+#define RUNTIME_ISR_ENTER()     Runtime_IsrEnter()
+#define RUNTIME_ISR_EXIT()      Runtime_IsrExit()
+#else
+#define RUNTIME_ISR_ENTER()
+#define RUNTIME_ISR_EXIT()
+#endif
+
+void Runtime_Init(struct ConsoleHandle* c);
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ * my_stacks.h
+ *
+ *  Created on: Jan 27, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_STACKS_H
+#define MY_STACKS_H
+
+// Bericht der Stacks einmalig nach dieser Zeit ab Start ausgeben, 0 nur ueber den stacks Befehl
+#define STACKS_BOOT_REPORT_MS   10000
+
+// Empfehlung: genutzte Worte plus STACKS_MARGIN_PERCENT, mindestens STACKS_MARGIN_WORDS mehr, aufgerundet auf
+// STACKS_ROUND_WORDS
+#define STACKS_MARGIN_PERCENT   25
+#define STACKS_MARGIN_WORDS     128
+#define STACKS_ROUND_WORDS      64
+
+struct ConsoleHandle;
+
+// Hochwassermarken aller Tasks und des ISR Stacks (MSP), der ISR Stack wird dafuer kurz nach dem Start des
+// Schedulers mit einem Muster gefuellt
+void Stacks_Init(struct ConsoleHandle* c);
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * my_trace.h
+ *
+ *  Created on: Jan 26, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_TRACE_H
+#define MY_TRACE_H
+
+#include <stdint.h>
+
+// binaerer Ereignis-Ring (trace Befehl), 0 entfernt die Aufzeichnung und die Trace Makros des Kernels
+#define TRACE_ENABLE    1
+
+// Ereignistypen eines Records, die Nummern sind Teil des Formats (siehe SCA/trace_decode.c)
+#define TRACE_TASK_IN           1   // value: Nummer des Tasks
+#define TRACE_QUEUE_SEND        2   // value: Adresse der Queue
+#define TRACE_QUEUE_RECEIVE     3
+#define TRACE_SEM_GIVE          4   // value: Adresse des Semaphors oder Mutex
+#define TRACE_SEM_TAKE          5
+#define TRACE_ISR_ENTER         6   // value: Nummer der Exception (IPSR)
+#define TRACE_ISR_EXIT          7
+#define TRACE_STEPPER_START     16  // value: Anzahl Schritte
+#define TRACE_STEPPER_DONE      17
+#define TRACE_STEPPER_CANCEL    18
+#define TRACE_SPINDLE_DUTY      19  // value: Tastgrad in Promille
+#define TRACE_SPINDLE_DIR       20  // value: 1 vorwaerts, 0 rueckwaerts
+#define TRACE_CONSOLE_BEGIN     21  // value: die ersten vier Zeichen des Befehls
+#define TRACE_CONSOLE_END       22  // value: Rueckgabewert
+
+struct ConsoleHandle;
+
+void Trace_Event(uint8_t type, uint32_t value);
+void Trace_TaskSwitchedIn(uint32_t taskNumber);
+void Trace_Queue(uint8_t type, const void* queue, uint8_t queueType);
+void Trace_Command(const char* name);
+
+#if TRACE_ENABLE
+#define TRACE_EVENT(type, value)    Trace_Event((type), (uint32_t)(value))
+#define TRACE_COMMAND(name)         Trace_Command(name)
+
+// Trace Makros des Kernels, nur in tasks.c und queue.c expandiert
+#define traceTASK_SWITCHED_IN()                 Trace_TaskSwitchedIn(pxCurrentTCB->uxTCBNumber)
+#define traceQUEUE_SEND(pxQueue)                Trace_Queue(TRACE_QUEUE_SEND, (pxQueue), (pxQueue)->ucQueueType)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)       Trace_Queue(TRACE_QUEUE_SEND, (pxQueue), (pxQueue)->ucQueueType)
+#define traceQUEUE_RECEIVE(pxQueue)             Trace_Queue(TRACE_QUEUE_RECEIVE, (pxQueue), (pxQueue)->ucQueueType)
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)    Trace_Queue(TRACE_QUEUE_RECEIVE, (pxQueue), (pxQueue)->ucQueueType)
+#else
+#define TRACE_EVENT(type, value)
+#define TRACE_COMMAND(name)
+#endif
+
+void Trace_Init(struct ConsoleHandle* c);
+
+#endif
@@ -9,7 +9,9 @@
 #define MY_SPINDLE_H
 
 
+#include "main.h"
 #include "Spindle.h"
+#include <stdint.h>
 //Initial Configurations
 void init_Spindle(void);
 //notwendige Harware Funktionen, die an die Lib Spindle uebergeben werden muessen
@@ -18,5 +20,18 @@ void SPINDLE_SetDutyCycle(SpindleHandle_t h, void* context, float dutyCycle);
 void SPINDLE_EnaPWM(SpindleHandle_t h, void* context, int ena);
 
 void Initialize_Spindle(ConsoleHandle_t c);
+SpindleHandle_t Spindle_GetHandle(void);
+float Spindle_GetCachedRPM(void);
+//Drehzahlmessung ueber SPINDLE_SI_R, die ISR bekommt den Pin des EXTI Interrupts
+float SPINDLE_GetMeasuredRPM(SpindleHandle_t h, void* context);
+void Spindle_TachoEdgeISR(uint16_t pin);
+//Umdrehungen aus dem Index (SPINDLE_SI_R) fuer die Synchronisation des Vorschubs
+double Spindle_GetRevolutions(void);
+//PWM Frequenz und Dithering der ersten Spindel, die ISR bekommt den Timer des Update Interrupts
+int Spindle_ConfigurePWM(uint32_t frequency_hz, int dither);
+void Spindle_PWMUpdateISR(TIM_TypeDef* timer);
+//Kalibriertabelle im letzten Flash Sektor
+int SPINDLE_LoadCalibration(SpindleHandle_t h, void* context, SpindleCalibration_t* table);
+int SPINDLE_StoreCalibration(SpindleHandle_t h, void* context, const SpindleCalibration_t* table);
 
 #endif
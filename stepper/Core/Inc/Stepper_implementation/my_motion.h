@@ -0,0 +1,32 @@
+/*
+ * my_motion.h
+ *
+ *  Created on: Feb 2, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_MOTION_H
+#define MY_MOTION_H
+
+// Besitzer der laufenden synchronen Fahrt (move ohne -a, reference, sync). Der Job haelt den Besitz fuer seine
+// ganze Dauer, auch waehrend er den Treiber in StepperDelayUnlocked freigibt. Eine zweite Fahrt auf dem anderen
+// Worker wird so mit "FAIL: busy" abgewiesen, statt die Position und den Referenzstatus der ersten zu ueberschreiben.
+// Ohne FreeRTOS, der Besitzer ist der Task Handle des Jobs als void*.
+
+// 1 fuer die Unterbefehle, die eine Fahrt starten
+int Motion_IsMotionCommand(int argc, char** argv);
+
+// 0 wenn der Besitz uebernommen wurde, -1 wenn schon eine andere Fahrt laeuft
+int Motion_Acquire(void* owner);
+
+// gibt den Besitz nur frei, wenn owner ihn haelt
+void Motion_Release(void* owner);
+
+// Besitzer der laufenden Fahrt, NULL wenn keine laeuft
+void* Motion_GetOwner(void);
+
+// 1 wenn der Unterbefehl von caller gerade ausgefuehrt werden darf: status und cancel immer, alles andere nur ohne
+// laufende Fahrt oder vom Besitzer selbst
+int Motion_IsAllowed(int argc, char** argv, void* caller);
+
+#endif
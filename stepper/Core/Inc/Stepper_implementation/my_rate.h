@@ -0,0 +1,36 @@
+/*
+ * my_rate.h
+ *
+ *  Created on: Feb 3, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_RATE_H
+#define MY_RATE_H
+
+#include <stdint.h>
+
+// Takt von TIM4 (APB1 Timer Takt), aus ihm ergibt sich die Schrittrate = Takt / ((PSC + 1) * (ARR + 1))
+#define RATE_TIMER_CLOCK_HZ     90000000.0f
+// eine neue Rate darf bis auf diesen Anteil der Rate fallen, bei der der Prescaler gewaehlt wurde
+#define RATE_RANGE_FACTOR       0.25f
+// kleinster ARR mit Prescaler > 0, darunter wird die Rate zu grob (Fehler bis 1 / ARR) und der Prescaler neu gewaehlt
+#define RATE_ARR_MIN            4096u
+
+// Berechnung der Timer Werte fuer veraenderliche Raten (stepper sync), ohne HAL und FreeRTOS
+
+// Prescaler, mit dem ARR bis min_steps_per_sec in 16 Bit passt
+uint32_t Rate_Prescaler(float min_steps_per_sec);
+
+// ARR fuer die Rate mit dem festen Prescaler. 0 wenn es passt, -1 wenn ARR auf 1..65535 begrenzt werden musste oder
+// mit einem Prescaler > 0 unter RATE_ARR_MIN liegt
+int Rate_Reload(float steps_per_sec, uint32_t prescaler, uint32_t* arr);
+
+// Rate, die der Timer mit prescaler und arr tatsaechlich erzeugt
+float Rate_Achieved(uint32_t prescaler, uint32_t arr);
+
+// fuehrt prescaler und arr einer neuen Rate nach: verlaesst ARR seinen Bereich, wird der Prescaler fuer die neue
+// Rate neu gewaehlt (1 zurueck). -1 wenn die Rate auch so nicht erreichbar ist, sonst 0
+int Rate_Track(float steps_per_sec, uint32_t* prescaler, uint32_t* arr);
+
+#endif
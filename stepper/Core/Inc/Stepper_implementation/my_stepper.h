@@ -15,13 +15,35 @@ void StepLibraryDelay(unsigned int ms);
 int StepTimerAsync(void *pPWM, int dir, unsigned int numPulses, void(*doneClb)(L6474_Handle_t), L6474_Handle_t h);
 int StepTimerCancelAsync(void *pPWM);
 
+// Bits des zwischengespeicherten Treiberstatus (Stepper_GetCachedStatus)
+#define STEPPER_STATUS_HIGHZ    (1u << 0)
+#define STEPPER_STATUS_DIR      (1u << 1)
+#define STEPPER_STATUS_NOTPERF  (1u << 2)
+#define STEPPER_STATUS_WRONG    (1u << 3)
+#define STEPPER_STATUS_UVLO     (1u << 4)
+#define STEPPER_STATUS_TH_WARN  (1u << 5)
+#define STEPPER_STATUS_TH_SD    (1u << 6)
+#define STEPPER_STATUS_OCD      (1u << 7)
+#define STEPPER_STATUS_ONGOING  (1u << 8)
+
 // own functions
 void Initialize_Stepper(void);
 void SetStepperSpeed(float steps_per_sec);
 void FindOptimalTimerSettings(float steps_per_sec, uint32_t timer_clk, uint16_t *out_prescaler, uint16_t *out_arr);
+// veraenderliche Rate waehrend einer Fahrt (stepper sync)
+void Stepper_PrepareRate(float min_steps_per_sec);
+int Stepper_UpdateRate(float steps_per_sec);
 int check_abs(L6474_Handle_t t, int mm_to_move);
 // void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim);
 int EnableStepperDrivers(void);
-void vLedBlinkTask(void* pvParameters);
+// blaue LED blinken lassen (Treiber aktiv) oder ausschalten
+void Stepper_SetLedBlinking(int on);
+
+// zwischengespeicherter Zustand, lesbar ohne SPI Zugriff auf den Treiber
+int Stepper_GetCachedPosition(void);
+void Stepper_SetCachedPosition(int position);
+float Stepper_GetCachedSpeed(void);
+unsigned int Stepper_GetCachedStatus(void);
+void Stepper_SetCachedStatus(const L6474_Status_t* status);
 
 #endif
@@ -0,0 +1,30 @@
+/*
+ * my_telemetry.h
+ *
+ *  Created on: Jan 12, 2026
+ *      Author: Basti
+ */
+
+#ifndef MY_TELEMETRY_H
+#define MY_TELEMETRY_H
+
+#include "Console.h"
+
+// Signale, die mit watch abonniert werden koennen
+#define TELEMETRY_POSITION  (1u << 0)
+#define TELEMETRY_SPEED     (1u << 1)
+#define TELEMETRY_STATUS    (1u << 2)
+#define TELEMETRY_RPM       (1u << 3)
+#define TELEMETRY_HEAP      (1u << 4)
+#define TELEMETRY_CPU       (1u << 5)
+#define TELEMETRY_ALL       (0x3Fu)
+
+#define TELEMETRY_RATE_MIN  1
+#define TELEMETRY_RATE_MAX  500
+
+void Telemetry_Init(ConsoleHandle_t c);
+// gibt die erreichte Rate in Hz zurueck, die Periode ist eine ganze Zahl von Ticks. -1 bei Fehler
+int Telemetry_Start(unsigned int signals, unsigned int rate_hz);
+void Telemetry_Stop(void);
+
+#endif
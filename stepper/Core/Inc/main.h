@@ -55,6 +55,8 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+// Empfang der Konsole ueber den USART3 Interrupt (siehe main.c)
+void __stdin_rx_isr(void);
 
 /* USER CODE END EFP */
 
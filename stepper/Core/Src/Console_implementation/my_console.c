@@ -12,21 +12,49 @@
 #include "LibL6474.h"
 #include "Spindle_implementation/my_spindle.h"
 #include "Stepper_implementation/my_stepper.h"
+#include "Stepper_implementation/my_motion.h"
+#include "Stepper_implementation/my_rate.h"
+#include "Telemetry_implementation/my_telemetry.h"
+#include "Memory_implementation/my_pool.h"
+#include "Memory_implementation/my_heap.h"
+#include "Runtime_implementation/my_runtime.h"
+#include "Runtime_implementation/my_isrstat.h"
+#include "Runtime_implementation/my_trace.h"
+#include "Runtime_implementation/my_stacks.h"
+#include "Log_implementation/my_log.h"
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include <main.h>
 #include <task.h> // wichtig für vTaskDelay() !!!
+#include <semphr.h>
 
 extern bool error_variable;
 extern L6474_Handle_t stepperHandle;
 bool doneReference = false; // bevor reference Fahrt nicht gemacht wurde, darf Stepper nicht auf absolute Position 0 fahren
-extern int blueLedBlinking;
 int steps = 0; // for calculation of steps
 float sec_per_min = 60.0f;
 extern L6474_BaseParameter_t base_parameter;
 
+// create the console processor. There are no additional arguments required because it uses stdin, stderr and
+// stdout of the stdlib of the platform
+ConsoleHandle_t console_handle =  NULL;
+#define CONSOLE_STACK_DEPTH     ( 4 * configMINIMAL_STACK_SIZE )
+
+// move und reference laufen als Job in einem eigenen Task, deshalb muss der SPI Zugriff auf den Treiber
+// zwischen Job und Konsole gegenseitig ausgeschlossen werden. Die Sperre wird in den Wartezeiten freigegeben,
+// gegen eine zweite Fahrt schuetzt deshalb zusaetzlich der Besitz aus my_motion.c
+static SemaphoreHandle_t stepperLock = NULL;
+
+// synchronisierte Fahrt (stepper sync): Takt der Nachfuehrung, Verstaerkung der Phasenregelung in 1/s, groesste
+// Schrittrate und die Wartezeit auf die Index Flanke
+#define SYNC_PERIOD_MS          5
+#define SYNC_PHASE_GAIN         5.0f
+#define SYNC_MAX_STEPS_PER_SEC  50000.0f
+#define SYNC_INDEX_TIMEOUT_MS   1000
+
 
 // register the function, there is always a help text required, an empty string or null is not allowed!
 static int CapabilityFunc( int argc, char** argv, void* ctx )
@@ -66,7 +94,125 @@ static int CapabilityFunc( int argc, char** argv, void* ctx )
     return 0;
 }
 
-int StepperCommand(int argc, char **argv, void *context)
+// waehrend der Wartezeit einer synchronen Fahrt wird der Treiber freigegeben, damit die Konsole z.B. den
+// Status abfragen oder die Fahrt abbrechen kann
+static void StepperDelayUnlocked(TickType_t ticks)
+{
+	xSemaphoreGive(stepperLock);
+	vTaskDelay(ticks);
+	xSemaphoreTake(stepperLock, portMAX_DELAY);
+}
+
+// wie StepperDelayUnlocked, aber mit festem Takt ab dem letzten Aufwachzeitpunkt
+static void StepperDelayUntilUnlocked(TickType_t* last, TickType_t period)
+{
+	xSemaphoreGive(stepperLock);
+	vTaskDelayUntil(last, period);
+	xSemaphoreTake(stepperLock, portMAX_DELAY);
+}
+
+// fuehrt die Schrittrate der gemessenen Spindeldrehzahl nach: Rate = |RPM| / 60 * Schritte pro Umdrehung. Mit
+// phase_lock beginnt die Fahrt an einer Index Flanke und der Abstand zwischen den gefahrenen und den aus den
+// Umdrehungen erwarteten Schritten wird zusaetzlich ausgeregelt, damit z.B. jeder Gewindedurchgang gleich liegt
+static int StepperSync(int sync_steps, float steps_per_rev, int phase_lock)
+{
+	SpindleHandle_t spindle_handle = Spindle_GetHandle();
+	SpindleSnapshot_t spindle;
+	if (spindle_handle == NULL || SPINDLE_GetSnapshot(spindle_handle, &spindle) != 0 || !spindle.running || !spindle.atSpeed)
+	{
+		printf("FAIL: spindle is not running at speed\r\n");
+		return -1;
+	}
+
+	float rate = fabsf(spindle.measured) / 60.0f * steps_per_rev;
+	if (rate <= 0.0f || rate > SYNC_MAX_STEPS_PER_SEC)
+	{
+		printf("FAIL: feed not possible at the current spindle speed\r\n");
+		return -1;
+	}
+
+	// der Prescaler passt zunaechst bis zu einem Viertel der Startrate, faellt die Spindel weiter ab, waehlt
+	// Stepper_UpdateRate ihn neu (siehe my_rate.c)
+	Stepper_PrepareRate(rate * RATE_RANGE_FACTOR);
+	Stepper_UpdateRate(rate);
+
+	double start_revolutions = 0.0;
+	if (phase_lock)
+	{
+		// auf die naechste Index Flanke warten, ab ihr werden die Umdrehungen gezaehlt
+		double revolutions = floor(Spindle_GetRevolutions());
+		TickType_t start = xTaskGetTickCount();
+		while (floor(Spindle_GetRevolutions()) == revolutions)
+		{
+			if (CONSOLE_IsJobCancelled(console_handle) || (xTaskGetTickCount() - start) > pdMS_TO_TICKS(SYNC_INDEX_TIMEOUT_MS))
+			{
+				printf("FAIL: no spindle index\r\n");
+				return -1;
+			}
+			StepperDelayUnlocked(1);
+		}
+		start_revolutions = floor(Spindle_GetRevolutions());
+	}
+
+	int start_position = Stepper_GetCachedPosition();
+	LOG(LOG_INFO, LOG_CONSOLE, "Sync move %d steps at %.2f steps/rev", sync_steps, LOG_FLOAT(steps_per_rev));
+	L6474_StepIncremental(stepperHandle, sync_steps);
+
+	TickType_t last = xTaskGetTickCount();
+	int moving = 1;
+	while (moving == 1)
+	{
+		StepperDelayUntilUnlocked(&last, pdMS_TO_TICKS(SYNC_PERIOD_MS));
+
+		// der Snapshot der Spindel ist ohne Anfrage an die Spindel Task lesbar
+		if (SPINDLE_GetSnapshot(spindle_handle, &spindle) != 0 || !spindle.running)
+		{
+			L6474_StopMovement(stepperHandle);
+			printf("FAIL: spindle stopped during sync move\r\n");
+			return -1;
+		}
+
+		rate = fabsf(spindle.measured) / 60.0f * steps_per_rev;
+		if (phase_lock)
+		{
+			float expected = (float)((Spindle_GetRevolutions() - start_revolutions) * steps_per_rev);
+			float done = (float)abs(Stepper_GetCachedPosition() - start_position);
+			float correction = SYNC_PHASE_GAIN * (expected - done);
+			if (correction > 0.5f * rate)
+			{
+				correction = 0.5f * rate;
+			}
+			if (correction < -0.5f * rate)
+			{
+				correction = -0.5f * rate;
+			}
+			rate += correction;
+		}
+		if (rate > SYNC_MAX_STEPS_PER_SEC)
+		{
+			rate = SYNC_MAX_STEPS_PER_SEC;
+		}
+		// kann der Timer die Rate nicht mehr erzeugen, stimmt der Vorschub pro Umdrehung nicht mehr
+		if (Stepper_UpdateRate(rate) != 0)
+		{
+			L6474_StopMovement(stepperHandle);
+			printf("FAIL: feed can not follow the spindle speed\r\n");
+			return -1;
+		}
+
+		L6474_IsMoving(stepperHandle, &moving);
+	}
+
+	if (CONSOLE_IsJobCancelled(console_handle))
+	{
+		printf("FAIL: Sync movement cancelled\r\n");
+		return -1;
+	}
+	printf("OK, Sync movement done\r\n");
+	return 0;
+}
+
+static int StepperCommandLocked(int argc, char **argv, void *context)
 {
 	// da context nicht verwendet wird
 	(void)context;
@@ -205,6 +351,7 @@ int StepperCommand(int argc, char **argv, void *context)
             printf("FAIL: Could not read current position\r\n");
             return -1;
         }
+        Stepper_SetCachedPosition(current_steps);
 
         // Berechnung wie weit man in mm von reference point entfernt ist
         float current_mm = ((float)current_steps * mm_per_turn) / (steps_per_turn * microsteps);
@@ -242,8 +389,9 @@ int StepperCommand(int argc, char **argv, void *context)
         SetStepperSpeed(steps_per_sec);
         // ternary operator for absolute oder relative Unterscheidung
         float delta_mm = relative ? target_mm : (target_mm - current_mm);
-        //TODO: delta_mm evt. noch falsch, wenn absolute Fahrt umgesetzt wird -> fuer debugging Zwecke printf
-        printf("Moving %.2f mm at %.2f steps/sec (%d steps)\r\n", delta_mm, steps_per_sec, steps);
+        //TODO: delta_mm evt. noch falsch, wenn absolute Fahrt umgesetzt wird -> fuer debugging Zwecke geloggt
+        LOG(LOG_INFO, LOG_CONSOLE, "Moving %.2f mm at %.2f steps/sec (%d steps)", LOG_FLOAT(delta_mm),
+            LOG_FLOAT(steps_per_sec), steps);
 
         // Funktion die ausgefuehrt wird, damit der Schrittmotor faehrt
         L6474_StepIncremental(stepperHandle, steps);
@@ -255,13 +403,106 @@ int StepperCommand(int argc, char **argv, void *context)
             while(moving == 1)
             {
                 L6474_IsMoving(stepperHandle, &moving); // Funktion schreibt in moving rein, ob sich Stepper noch bewegt oder nicht
-                vTaskDelay(100);
+                StepperDelayUnlocked(100);
+
+                // kill des Jobs: die Fahrt gehoert diesem Job, sie wird hier angehalten, auch wenn StepperCancel
+                // sie noch nicht gestoppt hat
+                if (CONSOLE_IsJobCancelled(console_handle))
+                {
+                    L6474_StopMovement(stepperHandle);
+                    printf("FAIL: Movement cancelled\r\n");
+                    return -1;
+                }
             }
         }
 
         return 0;
     }
 
+    // Abfrage ob subcommand "sync": Vorschub pro Umdrehung der Spindel, immer synchron als Job
+    // stepper sync <Ziel> -f <mm pro Umdrehung> [-r] [-p]
+    else if (strcmp(argv[0], "sync") == 0)
+    {
+        float feed_mm_per_rev = 0.0f;
+        int relative = 0;
+        int phase_lock = 0;
+
+        if (doneReference == false)
+        {
+        	printf("FAIL: reference run not done\r\n");
+        	return -1;
+        }
+
+        if (argc < 2)
+        {
+			printf("Invalid number of arguments\r\n");
+			return -1;
+		}
+
+        float target_mm = atof(argv[1]);
+		for (int i = 2; i < argc; )
+		{
+			if (strcmp(argv[i], "-r") == 0)
+			{
+				relative = 1;
+				i++;
+			}
+			// Index der Spindel als Phasenbezug
+			else if (strcmp(argv[i], "-p") == 0)
+			{
+				phase_lock = 1;
+				i++;
+			}
+			else if (strcmp(argv[i], "-f") == 0)
+			{
+				if (i == argc - 1)
+				{
+					printf("Invalid number of arguments\r\n");
+					return -1;
+				}
+
+				feed_mm_per_rev = atof(argv[i + 1]);
+				i += 2;
+			}
+			else
+			{
+				printf("Invalid Flag\r\n");
+				return -1;
+			}
+		}
+
+        if (feed_mm_per_rev <= 0.0f)
+        {
+        	printf("FAIL: feed per revolution missing\r\n");
+        	return -1;
+        }
+
+        if (EnableStepperDrivers() != 0)
+        {
+            printf("FAIL: Could not enable drivers\r\n");
+            return -1;
+        }
+
+        int current_steps = 0;
+        if (L6474_GetAbsolutePosition(stepperHandle, &current_steps) != errcNONE)
+        {
+            printf("FAIL: Could not read current position\r\n");
+            return -1;
+        }
+        Stepper_SetCachedPosition(current_steps);
+
+        float current_mm = ((float)current_steps * mm_per_turn) / (steps_per_turn * microsteps);
+        float delta_mm = relative ? target_mm : (target_mm - current_mm);
+        steps = (delta_mm * steps_per_turn * microsteps) / mm_per_turn;
+        if (steps == 0)
+        {
+            printf("OK, Already at target position\r\n");
+            return 0;
+        }
+
+        return StepperSync(steps, feed_mm_per_rev * (steps_per_turn * microsteps) / mm_per_turn, phase_lock);
+    }
+
     // Abfrage ob sucommand "reference": synchron mit Stop bei Schalter
     else if(strcmp(argv[0], "reference") == 0)
     {
@@ -326,7 +567,7 @@ int StepperCommand(int argc, char **argv, void *context)
 
 
         // TODO: finish implementation of timeout
-        if (power_output_enabled == true)
+        if (power_output_enabled_after_refrun == true)
 		{
 			// TODO: implement this function
         	printf("FAIL: power output enabled after reference not implemented\r\n");
@@ -337,6 +578,7 @@ int StepperCommand(int argc, char **argv, void *context)
         {
         	L6474_SetPositionMark(stepperHandle, 0);
 			L6474_SetAbsolutePosition(stepperHandle, 0);
+			Stepper_SetCachedPosition(0);
 			doneReference = true;
         	return 0;
         }
@@ -349,7 +591,7 @@ int StepperCommand(int argc, char **argv, void *context)
 			// printf("%d\n", result);
 			// result = L6474_StopMovement(stepperHandle); // just for safety
 			// printf("%d\n", result);
-			vTaskDelay(1000);
+			StepperDelayUnlocked(1000);
 		}
 
         L6474_StepIncremental(stepperHandle, -10000000);
@@ -364,6 +606,7 @@ int StepperCommand(int argc, char **argv, void *context)
                 L6474_StopMovement(stepperHandle);
                 L6474_SetPositionMark(stepperHandle, 0);
                 L6474_SetAbsolutePosition(stepperHandle, 0);
+                Stepper_SetCachedPosition(0);
                 doneReference = true; // es soll geschaut werden, ob reference Fahrt schon gemacht wurde
                 // ob Referenzfahrt vor absoluter Fahrt zu 0 schon gemacht wurde
                 printf("OK, Reference found and position set to 0\r\n");
@@ -371,7 +614,13 @@ int StepperCommand(int argc, char **argv, void *context)
             }
 
             L6474_IsMoving(stepperHandle, &moving);
-            vTaskDelay(100);
+            StepperDelayUnlocked(100);
+        }
+
+        if (CONSOLE_IsJobCancelled(console_handle))
+        {
+        	printf("FAIL: Reference movement cancelled\r\n");
+        	return -1;
         }
 
         // falls Schrittmotor nicht an Referenzpunkt angekommen ist wird while-loop verlassen
@@ -388,9 +637,10 @@ int StepperCommand(int argc, char **argv, void *context)
             printf("Fail: Could not read absolute position\r\n");
             return -1;
         }
+        Stepper_SetCachedPosition(steps);
 
         float pos_mm = ((float)steps * mm_per_turn) / (steps_per_turn * microsteps);
-        printf("OK, Current absolute position: %d steps = %.2f mm\r\n", steps, pos_mm);
+        CONSOLE_Printf("OK, Current absolute position: %d steps = %.2f mm\r\n", steps, pos_mm);
         return 0;
     }
 
@@ -403,6 +653,7 @@ int StepperCommand(int argc, char **argv, void *context)
             printf("FAIL: Could not read status\r\n");
             return -1;
         }
+        Stepper_SetCachedStatus(&status);
 
         // unterschiedliche Werte des Status structs werden auf der Konsole ausgegeben
         printf("Ok, Stepper status:\r\n");
@@ -427,13 +678,13 @@ int StepperCommand(int argc, char **argv, void *context)
             HAL_GPIO_WritePin(LED_RED_GPIO_Port, LED_RED_Pin, GPIO_PIN_SET);
             HAL_GPIO_WritePin(LED_GREEN_GPIO_Port, LED_GREEN_Pin, GPIO_PIN_RESET);
             // printf("blueLedBlinking disabled3\n"); // TODO: remove debugging
-            blueLedBlinking = 0;
+            Stepper_SetLedBlinking(0);
             return -1;
         }
 
         HAL_GPIO_WritePin(LED_GREEN_GPIO_Port, LED_GREEN_Pin, GPIO_PIN_SET);
         HAL_GPIO_WritePin(LED_RED_GPIO_Port, LED_RED_Pin, GPIO_PIN_RESET);
-        blueLedBlinking = 0;
+        Stepper_SetLedBlinking(0);
         return 0;
     }
 
@@ -458,25 +709,144 @@ int StepperCommand(int argc, char **argv, void *context)
     return -1;
 }
 
+int StepperCommand(int argc, char **argv, void *context)
+{
+	void* self = xTaskGetCurrentTaskHandle();
+	int motion = Motion_IsMotionCommand(argc, argv);
 
+	// waehrend einer synchronen Fahrt kommen nur status und cancel durch die freigegebene Sperre
+	if (motion ? (Motion_Acquire(self) != 0) : !Motion_IsAllowed(argc, argv, self))
+	{
+		printf("FAIL: busy\r\n");
+		return -1;
+	}
+
+	xSemaphoreTake(stepperLock, portMAX_DELAY);
+	int result;
+	int moving = 0;
+	// eine asynchrone Fahrt (move -a) hat keinen Besitzer, sie laeuft aber noch auf dem Treiber
+	if (motion && L6474_IsMoving(stepperHandle, &moving) == errcNONE && moving)
+	{
+		printf("FAIL: busy\r\n");
+		result = -1;
+	}
+	else
+	{
+		result = StepperCommandLocked(argc, argv, context);
+	}
+	xSemaphoreGive(stepperLock);
+
+	if (motion)
+	{
+		Motion_Release(self);
+	}
+	return result;
+}
+
+// synchrone Fahrten (move ohne -a und reference) laufen als Job, damit die Konsole waehrend der Fahrt bedienbar bleibt
+static int StepperIsLongRunning(int argc, char **argv, void *context)
+{
+	(void)context;
+
+	if (argc == 0)
+	{
+		return 0;
+	}
+
+	if (strcmp(argv[0], "reference") == 0 || strcmp(argv[0], "sync") == 0)
+	{
+		return 1;
+	}
+
+	if (strcmp(argv[0], "move") == 0)
+	{
+		for (int i = 2; i < argc; i++)
+		{
+			if (strcmp(argv[i], "-a") == 0)
+			{
+				return 0;
+			}
+		}
+		return 1;
+	}
+
+	return 0;
+}
+
+// wird bei kill aufgerufen, nach dem Stoppen verlaesst der Job seine Warteschleife. Gestoppt wird nur, wenn der
+// beendete Job die laufende Fahrt besitzt, ein abgewiesener oder anderer Job haelt sie nicht an
+static void StepperCancel(void *context)
+{
+	(void)context;
+
+	void* owner = Motion_GetOwner();
+	if (owner == NULL || !CONSOLE_IsWorkerJobCancelled(console_handle, owner))
+	{
+		return;
+	}
+
+	xSemaphoreTake(stepperLock, portMAX_DELAY);
+	L6474_StopMovement(stepperHandle);
+	xSemaphoreGive(stepperLock);
+}
 
-// create the console processor. There are no additional arguments required because it uses stdin, stderr and
-// stdout of the stdlib of the platform
-ConsoleHandle_t console_handle =  NULL;
 void MyConsole_Init(void)
 {
     // Jetzt die Instanz zur Laufzeit erstellen und der globalen Variable zuweisen
-    console_handle = CONSOLE_CreateInstance( 4 * configMINIMAL_STACK_SIZE, configMAX_PRIORITIES - 5 );
+    // alle Stacks, Queues und der Handle liegen statisch im RAM (siehe CONSOLE_CreateStatic)
+    static ConsoleStaticBuffers_t consoleBuffers;
+    static StackType_t consoleStack[CONSOLE_STACK_DEPTH];
+    static StackType_t consoleWorkerStacks[CONSOLE_JOB_WORKERS][CONSOLE_JOB_STACK_DEPTH];
+    consoleBuffers.stack = consoleStack;
+    for (unsigned int i = 0; i < CONSOLE_JOB_WORKERS; i++)
+    {
+    	consoleBuffers.workerStacks[i] = consoleWorkerStacks[i];
+    }
+    console_handle = CONSOLE_CreateStatic( CONSOLE_STACK_DEPTH, configMAX_PRIORITIES - 5, &consoleBuffers );
 
     // Befehl registrieren, nachdem die Instanz erstellt wurde
     CONSOLE_RegisterCommand(console_handle, "capability", "prints a specified string of capability bits", CapabilityFunc, NULL);
 
-    // Stepper Befehl registrieren
-    CONSOLE_RegisterCommand(console_handle, "stepper", "commands to control the stepper command", StepperCommand, NULL);
+    // Stepper Befehl registrieren, lange Fahrten laufen als Job (siehe jobs, wait und kill)
+    static StaticSemaphore_t stepperLockBuffer;
+    stepperLock = xSemaphoreCreateMutexStatic(&stepperLockBuffer);
+    CONSOLE_RegisterJobCommand(console_handle, "stepper", "commands to control the stepper command", StepperCommand,
+    		StepperIsLongRunning, StepperCancel, NULL);
+
+    // Unterbefehle fuer die TAB Vervollstaendigung bekannt machen
+    static char* const stepperSubcommands[] = { "move", "sync", "reference", "position", "status", "reset", "cancel", "config" };
+    for (unsigned int i = 0; i < sizeof(stepperSubcommands) / sizeof(stepperSubcommands[0]); i++)
+    {
+    	CONSOLE_RegisterSubcommand(console_handle, "stepper", stepperSubcommands[i]);
+    }
+
+    // Log Task zuerst, damit auch die Meldungen der folgenden Initialisierung ankommen (log Befehl)
+    Log_Init(console_handle);
 
     // Spindle initialisieren
     Initialize_Spindle(console_handle);
 
     // Stepper initialisieren
     Initialize_Stepper();
+
+    // Telemetrie (watch Befehl) initialisieren
+    Telemetry_Init(console_handle);
+
+    // Statistik des Pool Allocators (pools Befehl)
+    Pool_Init(console_handle);
+
+    // Freiliste und Aufrufer der malloc Bloecke (heap Befehl)
+    Heap_Init(console_handle);
+
+    // Rechenzeit je Task und der Interrupts (top Befehl)
+    Runtime_Init(console_handle);
+
+    // Dauer und Jitter der Interrupts (isr Befehl)
+    IsrStat_Init(console_handle);
+
+    // binaerer Ereignis-Ring (trace Befehl)
+    Trace_Init(console_handle);
+
+    // Hochwassermarken der Stacks (stacks Befehl und Bericht nach dem Start)
+    Stacks_Init(console_handle);
 }
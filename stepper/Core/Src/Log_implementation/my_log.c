@@ -0,0 +1,357 @@
+/*
+ * my_log.c
+ *
+ *  Created on: Jan 30, 2026
+ *      Author: Basti
+ */
+#include "Log_implementation/my_log.h"
+#include "Runtime_implementation/my_runtime.h"
+#include "Console.h"
+#include "FreeRTOS.h"
+#include <task.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#ifndef WIN32
+#include "main.h"
+#endif
+
+// Anzahl der Records im Ring (Zweierpotenz), bei vollem Ring wird die neue Meldung verworfen und gezaehlt
+#define LOG_RECORDS         64
+// der Log Task wartet auf die Benachrichtigung eines Tasks, Meldungen aus Interrupts holt er spaetestens so spaet ab
+#define LOG_POLL_MS         250
+#define LOG_STACK_DEPTH     configMINIMAL_STACK_SIZE
+#define LOG_LINE_SIZE       160
+// Aufrufe je Messung im log bench Befehl, aufgezeichnet werden nur LOG_BENCH_RECORDS davon (Zweierpotenz, so
+// gross ist der eigene Ring der Messung)
+#define LOG_BENCH_CALLS     1000
+#define LOG_BENCH_RECORDS   16
+
+typedef struct
+{
+	uint32_t    sequence;   // Nummer des Records + 1, sobald er vollstaendig geschrieben ist
+	const char* format;
+	uint32_t    tick;
+	uint8_t     level;
+	uint8_t     module;
+	uint16_t    reserved;
+	uint32_t    args[LOG_MAX_ARGS];
+} LogRecord_t;
+
+typedef struct
+{
+	LogRecord_t* records;
+	uint32_t     mask;      // Anzahl der Records - 1, die Anzahl ist eine Zweierpotenz
+	uint32_t     head;      // Anzahl der reservierten Records
+	uint32_t     tail;      // Anzahl der ausgegebenen Records, nur der Leser schreibt
+	uint32_t     dropped;
+} LogRing_t;
+
+static LogRecord_t logRecords[LOG_RECORDS];
+static LogRing_t logRing = { logRecords, LOG_RECORDS - 1, 0, 0, 0 };
+static volatile uint8_t logLevels[LOG_MODULES] = { LOG_INFO, LOG_INFO, LOG_INFO, LOG_INFO };
+static TaskHandle_t logTask = NULL;
+
+static const char* const logModuleNames[LOG_MODULES] = { "system", "stepper", "spindle", "console" };
+static const char* const logLevelNames[] = { "off", "error", "warn", "info", "debug" };
+static const char logLevelLetters[] = "-EWID";
+
+// schreibt einen Record in den Ring, -1 wenn er voll ist, 1 wenn er vorher leer war, sonst 0
+static int LogPut(LogRing_t* ring, uint8_t level, uint8_t module, const char* format, uint32_t a0, uint32_t a1,
+		uint32_t a2, uint32_t a3)
+{
+	// Platz mit LDREX/STREX reservieren: unterbricht ein Interrupt zwischen Lesen und Schreiben, schlaegt das
+	// Schreiben fehl und der Versuch wird wiederholt. Keine Sperre, damit auch Interrupts oberhalb von
+	// configMAX_SYSCALL_INTERRUPT_PRIORITY schreiben koennen
+	uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+	uint32_t tail;
+	do
+	{
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if (head - tail > ring->mask)
+		{
+			__atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+			return -1;
+		}
+	} while (!__atomic_compare_exchange_n(&ring->head, &head, head + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+	LogRecord_t* r = &ring->records[head & ring->mask];
+	r->format = format;
+	r->tick = (uint32_t)xTaskGetTickCount();
+	r->level = level;
+	r->module = module;
+	r->reserved = 0;
+	r->args[0] = a0;
+	r->args[1] = a1;
+	r->args[2] = a2;
+	r->args[3] = a3;
+	__atomic_store_n(&r->sequence, head + 1, __ATOMIC_RELEASE);
+	return (head == tail) ? 1 : 0;
+}
+
+void Log_Write(uint8_t level, uint8_t module, const char* format, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+	if (module >= LOG_MODULES || level == LOG_OFF || level > logLevels[module])
+	{
+		return;
+	}
+	int wasEmpty = LogPut(&logRing, level, module, format, a0, a1, a2, a3);
+
+	// nur der Uebergang von leer nach nicht leer weckt den Log Task, aus Interrupts gar nicht, weil dort auch
+	// Prioritaeten ohne Zugriff auf die FreeRTOS API schreiben
+#ifndef WIN32
+	if (__get_IPSR() != 0)
+	{
+		return;
+	}
+#endif
+	if (wasEmpty == 1 && logTask != NULL && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+	{
+		xTaskNotifyGive(logTask);
+	}
+}
+
+#if LOG_ENABLE
+// naechsten vollstaendigen Record kopieren, 0 wenn der Ring leer ist oder der aelteste noch geschrieben wird
+static int LogTake(LogRecord_t* out)
+{
+	uint32_t tail = logRing.tail;
+	LogRecord_t* r = &logRing.records[tail & logRing.mask];
+	if (__atomic_load_n(&r->sequence, __ATOMIC_ACQUIRE) != tail + 1)
+	{
+		return 0;
+	}
+	memcpy(out, r, sizeof(LogRecord_t));
+	__atomic_store_n(&logRing.tail, tail + 1, __ATOMIC_RELEASE);
+	return 1;
+}
+
+// wertet die Formatzeichenkette selbst aus und uebergibt CONSOLE_Snprintf je Umwandlung genau ein Argument mit dem
+// passenden Typ. Laengenangaben wie l und h werden entfernt, alle Argumente sind 32 Bit breit
+static unsigned int LogFormat(char* line, unsigned int size, const LogRecord_t* r)
+{
+	const char* f = r->format;
+	unsigned int n = 0;
+	unsigned int arg = 0;
+	char spec[16];
+
+	while (*f != 0 && n + 1 < size)
+	{
+		if (*f != '%')
+		{
+			line[n++] = *f++;
+			continue;
+		}
+		if (f[1] == '%')
+		{
+			line[n++] = '%';
+			f += 2;
+			continue;
+		}
+
+		unsigned int s = 0;
+		spec[s++] = *f++;
+		while (*f != 0 && strchr("-+ #0123456789.lhzjt", *f) != NULL)
+		{
+			if (strchr("lhzjt", *f) == NULL && s < sizeof(spec) - 2)
+			{
+				spec[s++] = *f;
+			}
+			f++;
+		}
+		if (*f == 0)
+		{
+			break;
+		}
+		char conversion = *f++;
+		spec[s++] = conversion;
+		spec[s] = 0;
+
+		uint32_t value = (arg < LOG_MAX_ARGS) ? r->args[arg] : 0;
+		arg++;
+		int written;
+		if (strchr("di", conversion) != NULL)
+		{
+			written = CONSOLE_Snprintf(&line[n], size - n, spec, (int)value);
+		}
+		else if (strchr("uxXoc", conversion) != NULL)
+		{
+			written = CONSOLE_Snprintf(&line[n], size - n, spec, (unsigned int)value);
+		}
+		else if (strchr("feEgG", conversion) != NULL)
+		{
+			float number;
+			memcpy(&number, &value, sizeof(number));
+			written = CONSOLE_Snprintf(&line[n], size - n, spec, (double)number);
+		}
+		else
+		{
+			written = CONSOLE_Snprintf(&line[n], size - n, "%%%c?", conversion);
+		}
+		if (written > 0)
+		{
+			n += ((unsigned int)written < size - n) ? (unsigned int)written : size - n - 1;
+		}
+	}
+	line[n] = 0;
+	return n;
+}
+
+// einziger Ort, an dem die Meldungen formatiert werden, mit niedriger Prioritaet und eigenem Stack
+static void LogTaskFunc(void* arg)
+{
+	static LogRecord_t record;
+	static char line[LOG_LINE_SIZE];
+	uint32_t reported = 0;
+	(void)arg;
+
+	for (;;)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_POLL_MS));
+		while (LogTake(&record))
+		{
+			LogFormat(line, sizeof(line), &record);
+			CONSOLE_Printf("%lu %c %s: %s\r\n", (unsigned long)record.tick, logLevelLetters[record.level],
+					logModuleNames[record.module], line);
+		}
+
+		uint32_t dropped = __atomic_load_n(&logRing.dropped, __ATOMIC_RELAXED);
+		if (dropped != reported)
+		{
+			printf("log: %lu records dropped\r\n", (unsigned long)(dropped - reported));
+			reported = dropped;
+		}
+	}
+}
+
+static int LogFindName(const char* const* names, unsigned int count, const char* name)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (strcmp(names[i], name) == 0)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+// Kosten eines LOG Aufrufs im Hot Path: herausgefiltert, aufgezeichnet und zum Vergleich dieselbe Meldung mit
+// snprintf formatiert (printf kaeme noch die Ausgabe ueber die UART dazu). Auf dem Target in Zyklen, in der
+// Host Simulation in ns. Aufgezeichnet wird in einen eigenen Ring, der Log Task gibt davon nichts aus und der
+// echte Ring verliert keinen Platz
+static void LogBench(void)
+{
+	static char buffer[LOG_LINE_SIZE];
+	static LogRecord_t benchRecords[LOG_BENCH_RECORDS];
+	LogRing_t bench = { benchRecords, LOG_BENCH_RECORDS - 1, 0, 0, 0 };
+	uint8_t saved = logLevels[LOG_SYSTEM];
+	uint64_t start;
+
+	logLevels[LOG_SYSTEM] = LOG_INFO;
+	start = Runtime_GetCycles();
+	for (unsigned int i = 0; i < LOG_BENCH_CALLS; i++)
+	{
+		LOG(LOG_DEBUG, LOG_SYSTEM, "bench %u at %.2f steps/sec", i, LOG_FLOAT(1234.5f));
+	}
+	uint64_t filtered = Runtime_GetCycles() - start;
+	logLevels[LOG_SYSTEM] = saved;
+
+	start = Runtime_GetCycles();
+	for (unsigned int i = 0; i < LOG_BENCH_RECORDS; i++)
+	{
+		LogPut(&bench, LOG_DEBUG, LOG_SYSTEM, "bench %u at %.2f steps/sec", i, LOG_FLOAT(1234.5f), 0, 0);
+	}
+	uint64_t recorded = Runtime_GetCycles() - start;
+
+	start = Runtime_GetCycles();
+	for (unsigned int i = 0; i < LOG_BENCH_RECORDS; i++)
+	{
+		snprintf(buffer, sizeof(buffer), "bench %u at %.2f steps/sec", i, 1234.5);
+	}
+	uint64_t formatted = Runtime_GetCycles() - start;
+
+#ifndef WIN32
+	const char* unit = "cycles";
+	unsigned int scale = 1;
+#else
+	const char* unit = "ns";
+	unsigned int scale = 1000;
+#endif
+	printf("per call in %s: filtered %lu, recorded %lu, snprintf %lu\r\n", unit,
+			(unsigned long)(filtered * scale / LOG_BENCH_CALLS), (unsigned long)(recorded * scale / LOG_BENCH_RECORDS),
+			(unsigned long)(formatted * scale / LOG_BENCH_RECORDS));
+}
+
+// log                  -> Schwellen je Modul, Fuellstand und verworfene Records ausgeben
+// log <modul|all> <stufe> -> Schwelle setzen (off, error, warn, info, debug)
+// log bench            -> Kosten eines Aufrufs messen
+static int LogCommand(int argc, char** argv, void* ctx)
+{
+	(void)ctx;
+
+	if (argc == 0)
+	{
+		for (unsigned int i = 0; i < LOG_MODULES; i++)
+		{
+			printf("%-8s %s\r\n", logModuleNames[i], logLevelNames[logLevels[i]]);
+		}
+		printf("%lu of %u records pending, %lu written, %lu dropped\r\nOK",
+				(unsigned long)(logRing.head - logRing.tail), LOG_RECORDS, (unsigned long)logRing.head,
+				(unsigned long)logRing.dropped);
+		return 0;
+	}
+
+	if (argc == 1 && strcmp(argv[0], "bench") == 0)
+	{
+		LogBench();
+	}
+	else if (argc == 2)
+	{
+		int level = LogFindName(logLevelNames, sizeof(logLevelNames) / sizeof(logLevelNames[0]), argv[1]);
+		int module = LogFindName(logModuleNames, LOG_MODULES, argv[0]);
+		if (level < 0 || (module < 0 && strcmp(argv[0], "all") != 0))
+		{
+			printf("invalid arguments\r\nFAIL");
+			return -1;
+		}
+		for (unsigned int i = 0; i < LOG_MODULES; i++)
+		{
+			if (module < 0 || (unsigned int)module == i)
+			{
+				logLevels[i] = (uint8_t)level;
+			}
+		}
+	}
+	else
+	{
+		printf("invalid arguments\r\nFAIL");
+		return -1;
+	}
+
+	printf("OK");
+	return 0;
+}
+#endif
+
+void Log_Init(struct ConsoleHandle* c)
+{
+#if LOG_ENABLE
+	static StaticTask_t logTaskBuffer;
+	static StackType_t logTaskStack[LOG_STACK_DEPTH];
+
+	logTask = xTaskCreateStatic(LogTaskFunc, "log", LOG_STACK_DEPTH, NULL, tskIDLE_PRIORITY + 1, logTaskStack,
+			&logTaskBuffer);
+
+	CONSOLE_RegisterCommand(c, "log", "<<log>> prints the level of each module and the state of the log ring.\r\n"
+			"<<log>> <module|all> <off|error|warn|info|debug> sets a level, <<log bench>> measures a call.",
+			LogCommand, NULL);
+	static char* const logSubcommands[] = { "bench", "all", "system", "stepper", "spindle", "console" };
+	for (unsigned int i = 0; i < sizeof(logSubcommands) / sizeof(logSubcommands[0]); i++)
+	{
+		CONSOLE_RegisterSubcommand(c, "log", logSubcommands[i]);
+	}
+#else
+	(void)c;
+#endif
+}
@@ -0,0 +1,260 @@
+/*
+ * my_heap.c
+ *
+ *  Created on: Jan 29, 2026
+ *      Author: Basti
+ */
+#include "Memory_implementation/my_heap.h"
+#include "Console.h"
+#include "FreeRTOS.h"
+#include <task.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#ifndef WIN32
+#include <malloc.h>
+#endif
+
+// Anzahl der gleichzeitig verfolgten Bloecke, die meisten kleinen Anforderungen landen schon im Pool
+#define HEAP_TRACK_ENTRIES  256
+// verschiedene Aufrufer in der Auswertung und davon ausgegebene
+#define HEAP_SITES          32
+#define HEAP_TOP_SITES      8
+// Eimer b zaehlt die freien Bloecke aus [2^b, 2^(b+1)) Byte
+#define HEAP_BUCKETS        20
+
+typedef struct
+{
+	uintptr_t ptr;      // 0 fuer einen freien Eintrag
+	uintptr_t caller;   // Ruecksprungadresse in den Aufrufer von malloc
+	uint32_t  size;
+} HeapEntry_t;
+
+typedef struct
+{
+	uintptr_t caller;
+	uint32_t  count;
+	uint32_t  bytes;
+} HeapSite_t;
+
+typedef struct
+{
+	uint32_t buckets[HEAP_BUCKETS];
+	uint32_t blocks;
+	uint32_t bytes;
+	uint32_t largest;
+} HeapFree_t;
+
+static HeapEntry_t heapEntries[HEAP_TRACK_ENTRIES];
+static unsigned int heapNext = 0;       // Suche nach einem freien Eintrag beginnt hier
+static uint32_t heapUntracked = 0;      // Anforderungen bei voller Tabelle
+
+#ifndef WIN32
+// in newlib_abs.c, besucht die Freiliste von newlib-nano und liefert den noch nicht per sbrk vergebenen Rest
+extern size_t __malloc_walk_free(void (*visit)(size_t size, void* ctx), void* ctx);
+
+#define HEAP_LOCK()     __malloc_lock(_REENT)
+#define HEAP_UNLOCK()   __malloc_unlock(_REENT)
+#else
+#define HEAP_LOCK()     vTaskSuspendAll()
+#define HEAP_UNLOCK()   xTaskResumeAll()
+#endif
+
+void Heap_TrackAlloc(void* ptr, size_t size, void* caller)
+{
+#if HEAP_TRACKER
+	HEAP_LOCK();
+	for (unsigned int n = 0; n < HEAP_TRACK_ENTRIES; n++)
+	{
+		unsigned int i = (heapNext + n) % HEAP_TRACK_ENTRIES;
+		if (heapEntries[i].ptr == 0)
+		{
+			heapEntries[i].ptr = (uintptr_t)ptr;
+#ifndef WIN32
+			// ohne das Thumb Bit, damit addr2line die Adresse direkt aufloest
+			heapEntries[i].caller = (uintptr_t)caller & ~(uintptr_t)1;
+#else
+			heapEntries[i].caller = (uintptr_t)caller;
+#endif
+			heapEntries[i].size = (uint32_t)size;
+			heapNext = (i + 1) % HEAP_TRACK_ENTRIES;
+			HEAP_UNLOCK();
+			return;
+		}
+	}
+	heapUntracked++;
+	HEAP_UNLOCK();
+#else
+	(void)ptr;
+	(void)size;
+	(void)caller;
+#endif
+}
+
+void Heap_TrackFree(void* ptr)
+{
+#if HEAP_TRACKER
+	// Bloecke von vor dem Start oder bei voller Tabelle fehlen, dann gibt es nichts zu tun
+	HEAP_LOCK();
+	for (unsigned int i = 0; i < HEAP_TRACK_ENTRIES; i++)
+	{
+		if (heapEntries[i].ptr == (uintptr_t)ptr)
+		{
+			heapEntries[i].ptr = 0;
+			heapNext = i;
+			break;
+		}
+	}
+	HEAP_UNLOCK();
+#else
+	(void)ptr;
+#endif
+}
+
+#if HEAP_TRACKER
+#ifndef WIN32
+// laeuft unter __malloc_lock, darf also selbst nichts allozieren
+static void HeapVisitFree(size_t size, void* ctx)
+{
+	HeapFree_t* f = (HeapFree_t*)ctx;
+	unsigned int b = (size == 0) ? 0 : 31 - __builtin_clz((unsigned int)size);
+	f->buckets[(b < HEAP_BUCKETS) ? b : HEAP_BUCKETS - 1]++;
+	f->blocks++;
+	f->bytes += (uint32_t)size;
+	if (size > f->largest)
+	{
+		f->largest = (uint32_t)size;
+	}
+}
+#endif
+
+// fasst die lebenden Bloecke je Aufrufer zusammen, sortiert nach Bytes
+static unsigned int HeapCollectSites(const HeapEntry_t* entries, HeapSite_t* sites, HeapSite_t* other)
+{
+	unsigned int count = 0;
+	memset(other, 0, sizeof(HeapSite_t));
+	for (unsigned int i = 0; i < HEAP_TRACK_ENTRIES; i++)
+	{
+		if (entries[i].ptr == 0)
+		{
+			continue;
+		}
+
+		HeapSite_t* s = NULL;
+		for (unsigned int k = 0; k < count; k++)
+		{
+			if (sites[k].caller == entries[i].caller)
+			{
+				s = &sites[k];
+				break;
+			}
+		}
+		if (s == NULL && count < HEAP_SITES)
+		{
+			s = &sites[count++];
+			s->caller = entries[i].caller;
+			s->count = 0;
+			s->bytes = 0;
+		}
+		if (s == NULL)
+		{
+			s = other;
+		}
+		s->count++;
+		s->bytes += entries[i].size;
+	}
+
+	for (unsigned int i = 1; i < count; i++)
+	{
+		HeapSite_t key = sites[i];
+		unsigned int k = i;
+		while (k > 0 && sites[k - 1].bytes < key.bytes)
+		{
+			sites[k] = sites[k - 1];
+			k--;
+		}
+		sites[k] = key;
+	}
+	return count;
+}
+
+// heap -> Histogramm der freien Bloecke, groesster freier Block und die Aufrufer mit den meisten lebenden Bytes
+static int HeapCommand(int argc, char** argv, void* ctx)
+{
+	static HeapEntry_t entries[HEAP_TRACK_ENTRIES];
+	static HeapSite_t sites[HEAP_SITES];
+	static HeapFree_t freeBlocks;
+	HeapSite_t other;
+	(void)argv;
+	(void)ctx;
+
+	if (argc != 0)
+	{
+		printf("invalid arguments\r\nFAIL");
+		return -1;
+	}
+
+	// Kopie unter der Sperre, ausgegeben wird danach, printf darf selbst wieder allozieren
+	memset(&freeBlocks, 0, sizeof(freeBlocks));
+	HEAP_LOCK();
+	memcpy(entries, heapEntries, sizeof(entries));
+	uint32_t untracked = heapUntracked;
+#ifndef WIN32
+	size_t reserve = __malloc_walk_free(HeapVisitFree, &freeBlocks);
+#endif
+	HEAP_UNLOCK();
+
+#ifndef WIN32
+	printf("free blocks <limit:count in bytes\r\n ");
+	for (unsigned int b = 0; b < HEAP_BUCKETS; b++)
+	{
+		if (freeBlocks.buckets[b] != 0)
+		{
+			printf(" <%lu:%lu", (b == HEAP_BUCKETS - 1) ? 0xFFFFFFFFUL : (2UL << b), (unsigned long)freeBlocks.buckets[b]);
+		}
+	}
+	// Anteil des freien Speichers in der Freiliste, der nicht im groessten Block liegt
+	unsigned int fragmentation = (freeBlocks.bytes == 0) ? 0 :
+			(unsigned int)(100ULL * (freeBlocks.bytes - freeBlocks.largest) / freeBlocks.bytes);
+	printf("\r\nfree list %lu bytes in %lu blocks, largest %lu, fragmentation %u %%, never used %lu\r\n",
+			(unsigned long)freeBlocks.bytes, (unsigned long)freeBlocks.blocks, (unsigned long)freeBlocks.largest,
+			fragmentation, (unsigned long)reserve);
+#else
+	printf("no free list in the host simulation\r\n");
+#endif
+
+	unsigned int count = HeapCollectSites(entries, sites, &other);
+	uint32_t liveCount = other.count;
+	uint32_t liveBytes = other.bytes;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		liveCount += sites[i].count;
+		liveBytes += sites[i].bytes;
+	}
+	printf("live %lu blocks with %lu bytes, untracked %lu\r\n", (unsigned long)liveCount, (unsigned long)liveBytes,
+			(unsigned long)untracked);
+
+	printf("caller      count  bytes\r\n");
+	for (unsigned int i = 0; i < count && i < HEAP_TOP_SITES; i++)
+	{
+		printf("0x%08lx  %5lu  %5lu\r\n", (unsigned long)sites[i].caller, (unsigned long)sites[i].count,
+				(unsigned long)sites[i].bytes);
+	}
+	if (other.count != 0)
+	{
+		printf("(others)    %5lu  %5lu\r\n", (unsigned long)other.count, (unsigned long)other.bytes);
+	}
+	printf("OK");
+	return 0;
+}
+#endif
+
+void Heap_Init(struct ConsoleHandle* c)
+{
+#if HEAP_TRACKER
+	CONSOLE_RegisterCommand(c, "heap", "<<heap>> prints a histogram of the free heap blocks, the largest free block and\r\n"
+			"the callers holding the most live malloc bytes (resolve them with addr2line).", HeapCommand, NULL);
+#else
+	(void)c;
+#endif
+}
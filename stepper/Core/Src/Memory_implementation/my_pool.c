@@ -0,0 +1,210 @@
+/*
+ * my_pool.c
+ *
+ *  Created on: Jan 19, 2026
+ *      Author: Basti
+ */
+#include "Memory_implementation/my_pool.h"
+#include "Memory_implementation/my_heap.h"
+#include "Console.h"
+#include "FreeRTOS.h"
+#include <task.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// Anzahl der Bloecke je Groesse. 16 Byte sind die Knoten der TAB Vervollstaendigung, 1024 Byte die Befehle
+// und Aliase der Konsole, dazwischen liegen die kleinen Anforderungen von FreeRTOS und der LibL6474
+#define POOL_COUNT_16     384
+#define POOL_COUNT_32     32
+#define POOL_COUNT_64     32
+#define POOL_COUNT_128    16
+#define POOL_COUNT_512    8
+#if POOL_CONSOLE_COMMANDS
+#define POOL_COUNT_1024   32
+#endif
+
+// freie Bloecke sind ueber ihr erstes Wort verkettet
+typedef struct PoolBlock
+{
+	struct PoolBlock* next;
+} PoolBlock_t;
+
+typedef struct
+{
+	unsigned int size;
+	unsigned int count;
+	uint8_t*     memory;
+	PoolBlock_t* freeList;
+	unsigned int untouched; // noch nie vergebene Bloecke am Ende, dadurch braucht der Pool keine Initialisierung
+	unsigned int used;
+	unsigned int highWater;
+	unsigned int failed;    // Anforderungen, fuer die diese Groesse voll war
+} Pool_t;
+
+static uint8_t pool16[16 * POOL_COUNT_16] __attribute__((aligned(8)));
+static uint8_t pool32[32 * POOL_COUNT_32] __attribute__((aligned(8)));
+static uint8_t pool64[64 * POOL_COUNT_64] __attribute__((aligned(8)));
+static uint8_t pool128[128 * POOL_COUNT_128] __attribute__((aligned(8)));
+static uint8_t pool512[512 * POOL_COUNT_512] __attribute__((aligned(8)));
+#if POOL_CONSOLE_COMMANDS
+static uint8_t pool1024[1024 * POOL_COUNT_1024] __attribute__((aligned(8)));
+#endif
+
+// aufsteigend sortiert, Pool_Malloc nimmt die kleinste passende Groesse und weicht bei Bedarf nach oben aus
+static Pool_t pools[] =
+{
+	{ 16,   POOL_COUNT_16,   pool16,   NULL, POOL_COUNT_16,   0, 0, 0 },
+	{ 32,   POOL_COUNT_32,   pool32,   NULL, POOL_COUNT_32,   0, 0, 0 },
+	{ 64,   POOL_COUNT_64,   pool64,   NULL, POOL_COUNT_64,   0, 0, 0 },
+	{ 128,  POOL_COUNT_128,  pool128,  NULL, POOL_COUNT_128,  0, 0, 0 },
+	{ 512,  POOL_COUNT_512,  pool512,  NULL, POOL_COUNT_512,  0, 0, 0 },
+#if POOL_CONSOLE_COMMANDS
+	{ 1024, POOL_COUNT_1024, pool1024, NULL, POOL_COUNT_1024, 0, 0, 0 },
+#endif
+};
+#define POOL_CLASSES	(sizeof(pools) / sizeof(pools[0]))
+
+// an malloc weitergegebene Anforderungen und Anforderungen, die aus einer ISR nicht bedient werden konnten
+static volatile unsigned int poolFallback = 0;
+static volatile unsigned int poolLost = 0;
+
+// nur wenige Befehle unter BASEPRI, damit sind die Pools auch aus ISRs bis configMAX_SYSCALL_INTERRUPT_PRIORITY nutzbar
+static void* PoolTake(Pool_t* pool)
+{
+	void* block = NULL;
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	if (pool->freeList != NULL)
+	{
+		block = pool->freeList;
+		pool->freeList = pool->freeList->next;
+	}
+	else if (pool->untouched > 0)
+	{
+		block = &pool->memory[(pool->count - pool->untouched) * pool->size];
+		pool->untouched--;
+	}
+
+	if (block != NULL)
+	{
+		pool->used++;
+		if (pool->used > pool->highWater)
+		{
+			pool->highWater = pool->used;
+		}
+	}
+	else
+	{
+		pool->failed++;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+	return block;
+}
+
+void* Pool_Malloc(size_t size)
+{
+	for (unsigned int i = 0; i < POOL_CLASSES; i++)
+	{
+		if (size <= pools[i].size)
+		{
+			void* block = PoolTake(&pools[i]);
+			if (block != NULL)
+			{
+				return block;
+			}
+		}
+	}
+
+	// zu gross oder alle passenden Pools voll, newlib malloc ist ueber einen Mutex geschuetzt und nicht ISR fest
+	if (xPortIsInsideInterrupt())
+	{
+		poolLost++;
+		return NULL;
+	}
+	poolFallback++;
+#ifndef WIN32
+	return malloc(size);
+#else
+	// in der Host Simulation gibt es keine --wrap Optionen, dort sieht der heap Befehl nur diese Anforderungen
+	void* ptr = malloc(size);
+	if (ptr != NULL)
+	{
+		Heap_TrackAlloc(ptr, size, __builtin_return_address(0));
+	}
+	return ptr;
+#endif
+}
+
+void Pool_Free(void* ptr)
+{
+	if (ptr == NULL)
+	{
+		return;
+	}
+
+	for (unsigned int i = 0; i < POOL_CLASSES; i++)
+	{
+		Pool_t* pool = &pools[i];
+		if ((uint8_t*)ptr >= pool->memory && (uint8_t*)ptr < &pool->memory[pool->count * pool->size])
+		{
+			PoolBlock_t* block = (PoolBlock_t*)ptr;
+			UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+			block->next = pool->freeList;
+			pool->freeList = block;
+			pool->used--;
+			portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+			return;
+		}
+	}
+
+	// gehoert keinem Pool, kam also von malloc
+#ifdef WIN32
+	Heap_TrackFree(ptr);
+#endif
+	free(ptr);
+}
+
+// pools        -> Belegung, Hochwassermarke und Fehlschlaege je Blockgroesse ausgeben
+// pools reset  -> Hochwassermarken auf die aktuelle Belegung und alle Zaehler auf 0 setzen
+static int PoolsCommand(int argc, char** argv, void* ctx)
+{
+	(void)ctx;
+
+	if (argc == 1 && strcmp(argv[0], "reset") == 0)
+	{
+		for (unsigned int i = 0; i < POOL_CLASSES; i++)
+		{
+			UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+			pools[i].highWater = pools[i].used;
+			pools[i].failed = 0;
+			portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+		}
+		poolFallback = 0;
+		poolLost = 0;
+		printf("OK");
+		return 0;
+	}
+
+	if (argc != 0)
+	{
+		printf("invalid arguments\r\nFAIL");
+		return -1;
+	}
+
+	printf("size  count  used  peak  failed\r\n");
+	for (unsigned int i = 0; i < POOL_CLASSES; i++)
+	{
+		printf("%4u  %5u  %4u  %4u  %6u\r\n", pools[i].size, pools[i].count, pools[i].used, pools[i].highWater,
+				pools[i].failed);
+	}
+	printf("fallback to malloc %u, lost in ISR %u\r\nOK", poolFallback, poolLost);
+	return 0;
+}
+
+void Pool_Init(struct ConsoleHandle* c)
+{
+	CONSOLE_RegisterCommand(c, "pools", "<<pools>> prints the usage, the high-water mark and the failed requests of\r\n"
+			"each block size of the pool allocator. <<pools reset>> clears the marks and counters.", PoolsCommand, NULL);
+	CONSOLE_RegisterSubcommand(c, "pools", "reset");
+}
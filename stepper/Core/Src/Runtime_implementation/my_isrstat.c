@@ -0,0 +1,183 @@
+/*
+ * my_isrstat.c
+ *
+ *  Created on: Jan 23, 2026
+ *      Author: Basti
+ */
+#include "Runtime_implementation/my_isrstat.h"
+#include "Console.h"
+#include "FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+#ifndef WIN32
+#include "main.h"
+#endif
+
+// Eimer b zaehlt die Werte aus [2^(b-1), 2^b) Zyklen, Eimer 0 die Werte 0
+#define ISRSTAT_BUCKETS 33
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t maxDuration;
+	uint32_t maxJitter;
+	uint32_t last;      // Zyklenzaehler beim letzten Eintritt
+	uint32_t interval;  // Abstand der letzten beiden Eintritte
+	uint32_t chain;     // 0 keine Vorgeschichte, 1 last gueltig, 2 auch interval gueltig
+	uint32_t duration[ISRSTAT_BUCKETS];
+	uint32_t jitter[ISRSTAT_BUCKETS]; // Abweichung des Abstands vom vorherigen Abstand
+} IsrStat_t;
+
+static IsrStat_t isrStats[ISRSTAT_SOURCES];
+
+#ifndef WIN32
+static inline uint32_t IsrStatBucket(uint32_t value)
+{
+	return (value == 0) ? 0 : 32 - __CLZ(value);
+}
+#endif
+
+// jede Quelle wird nur von ihrem eigenen Interrupt geschrieben, der sich nicht selbst unterbricht
+uint32_t IsrStat_Enter(IsrStatSource_t source)
+{
+#ifndef WIN32
+	uint32_t now = DWT->CYCCNT;
+	IsrStat_t* s = &isrStats[source];
+	if (s->chain != 0)
+	{
+		uint32_t interval = now - s->last;
+		if (s->chain == 2)
+		{
+			uint32_t jitter = (interval > s->interval) ? interval - s->interval : s->interval - interval;
+			s->jitter[IsrStatBucket(jitter)]++;
+			if (jitter > s->maxJitter)
+			{
+				s->maxJitter = jitter;
+			}
+		}
+		s->interval = interval;
+		s->chain = 2;
+	}
+	else
+	{
+		s->chain = 1;
+	}
+	s->last = now;
+	return now;
+#else
+	(void)source;
+	return 0;
+#endif
+}
+
+void IsrStat_Exit(IsrStatSource_t source, uint32_t start)
+{
+#ifndef WIN32
+	uint32_t duration = DWT->CYCCNT - start;
+	IsrStat_t* s = &isrStats[source];
+	s->count++;
+	s->duration[IsrStatBucket(duration)]++;
+	if (duration > s->maxDuration)
+	{
+		s->maxDuration = duration;
+	}
+#else
+	(void)source;
+	(void)start;
+#endif
+}
+
+// die Pause vor einer neuen Fahrt ist kein Jitter, der naechste Eintritt beginnt eine neue Folge
+void IsrStat_Restart(IsrStatSource_t source)
+{
+#ifndef WIN32
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	isrStats[source].chain = 0;
+	__set_PRIMASK(primask);
+#else
+	(void)source;
+#endif
+}
+
+#if ISRSTAT_ENABLE
+static const char* const isrStatNames[ISRSTAT_SOURCES] = { "step", "limit", "tacho", "pwm" };
+
+static void IsrStatPrintHistogram(const char* title, const uint32_t* buckets)
+{
+	printf("  %-8s", title);
+	for (unsigned int b = 0; b < ISRSTAT_BUCKETS; b++)
+	{
+		if (buckets[b] != 0)
+		{
+			printf(" <%lu:%lu", (b == 32) ? 0xFFFFFFFFUL : (1UL << b), (unsigned long)buckets[b]);
+		}
+	}
+	printf("\r\n");
+}
+
+// isr        -> Anzahl, Maximum und Histogramme von Dauer und Jitter je Quelle in Zyklen ausgeben
+// isr reset  -> alle Zaehler loeschen
+static int IsrStatCommand(int argc, char** argv, void* ctx)
+{
+	static IsrStat_t copy;
+	(void)ctx;
+
+	if (argc == 1 && strcmp(argv[0], "reset") == 0)
+	{
+		for (unsigned int i = 0; i < ISRSTAT_SOURCES; i++)
+		{
+#ifndef WIN32
+			uint32_t primask = __get_PRIMASK();
+			__disable_irq();
+			memset(&isrStats[i], 0, sizeof(IsrStat_t));
+			__set_PRIMASK(primask);
+#else
+			memset(&isrStats[i], 0, sizeof(IsrStat_t));
+#endif
+		}
+		printf("OK");
+		return 0;
+	}
+
+	if (argc != 0)
+	{
+		printf("invalid arguments\r\nFAIL");
+		return -1;
+	}
+
+	float cyclesPerUs = (float)configCPU_CLOCK_HZ / 1000000.0f;
+	CONSOLE_Printf("buckets <limit:count in cycles, %.0f cycles per us\r\n", cyclesPerUs);
+	for (unsigned int i = 0; i < ISRSTAT_SOURCES; i++)
+	{
+		// Kopie, damit die Ausgabe zu einem Zeitpunkt passt
+#ifndef WIN32
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		memcpy(&copy, &isrStats[i], sizeof(IsrStat_t));
+		__set_PRIMASK(primask);
+#else
+		memcpy(&copy, &isrStats[i], sizeof(IsrStat_t));
+#endif
+
+		CONSOLE_Printf("%s: count %lu, max duration %lu (%.2f us), max jitter %lu (%.2f us)\r\n", isrStatNames[i],
+				(unsigned long)copy.count, (unsigned long)copy.maxDuration, (float)copy.maxDuration / cyclesPerUs,
+				(unsigned long)copy.maxJitter, (float)copy.maxJitter / cyclesPerUs);
+		IsrStatPrintHistogram("duration", copy.duration);
+		IsrStatPrintHistogram("jitter", copy.jitter);
+	}
+	printf("OK");
+	return 0;
+}
+#endif
+
+void IsrStat_Init(struct ConsoleHandle* c)
+{
+#if ISRSTAT_ENABLE
+	CONSOLE_RegisterCommand(c, "isr", "<<isr>> prints count, maximum and log2 histograms of the duration and the jitter\r\n"
+			"of the step, limit, tacho and pwm interrupts. <<isr reset>> clears them.", IsrStatCommand, NULL);
+	CONSOLE_RegisterSubcommand(c, "isr", "reset");
+#else
+	(void)c;
+#endif
+}
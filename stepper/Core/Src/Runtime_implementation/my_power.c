@@ -0,0 +1,94 @@
+/*
+ * my_power.c
+ *
+ *  Created on: Jan 28, 2026
+ *      Author: Basti
+ */
+#include "Runtime_implementation/my_power.h"
+#include "Runtime_implementation/my_runtime.h"
+#include "FreeRTOS.h"
+#include <task.h>
+#ifndef WIN32
+#include "main.h"
+#endif
+
+static volatile uint32_t powerBusy = 0;
+static volatile uint32_t powerWakeups = 0;
+static volatile uint32_t powerSleptTicks = 0;
+
+void Power_SetBusy(uint32_t reason, int busy)
+{
+#ifndef WIN32
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+#endif
+	if (busy)
+	{
+		powerBusy |= reason;
+	}
+	else
+	{
+		powerBusy &= ~reason;
+	}
+#ifndef WIN32
+	__set_PRIMASK(primask);
+#endif
+}
+
+int Power_IsBusy(uint32_t reason)
+{
+	return (powerBusy & reason) != 0;
+}
+
+uint32_t Power_GetWakeups(void)
+{
+	return powerWakeups;
+}
+
+uint32_t Power_GetSleptTicks(void)
+{
+	return powerSleptTicks;
+}
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+// mit eigenem portSUPPRESS_TICKS_AND_SLEEP deklariert portmacro.h die Funktion des Ports nicht
+extern void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime);
+
+// laeuft im Idle Task bei angehaltenem Scheduler. Der SysTick bleibt die Zeitbasis und wird nur fuer die
+// erwartete Ruhezeit verlaengert, alle Timer laufen im Sleep Mode weiter. Waehrend einer Fahrt oder mit laufender
+// Spindel bleibt der 1 ms Tick trotzdem an: die Drehzahl und die ISR Statistik messen mit CYCCNT, der im Sleep Mode
+// stehen kann, und der Start einer Fahrt soll nicht auf die Korrektur des Ticks nach dem Aufwachen warten.
+void Power_SuppressTicksAndSleep(uint32_t expectedIdleTime)
+{
+	if (powerBusy != 0)
+	{
+		return;
+	}
+
+	TickType_t ticks = xTaskGetTickCount();
+	uint32_t cycles = DWT->CYCCNT;
+	vPortSuppressTicksAndSleep((TickType_t)expectedIdleTime);
+	ticks = xTaskGetTickCount() - ticks;
+	cycles = DWT->CYCCNT - cycles;
+	powerWakeups++;
+
+	if (ticks > 0)
+	{
+		// der Port traegt die uebersprungenen Ticks mit vTaskStepTick nach, der HAL Tick zaehlt nur im SysTick
+		uwTick += ticks;
+		powerSleptTicks += ticks;
+
+		// steht CYCCNT im Schlaf, fehlt die Zeit in top und den Laufzeiten, sie gehoert dem Idle Task
+		uint64_t expected = (uint64_t)ticks * (configCPU_CLOCK_HZ / configTICK_RATE_HZ);
+		if (expected > cycles)
+		{
+			Runtime_AddSleepCycles(expected - cycles);
+		}
+	}
+}
+#else
+void Power_SuppressTicksAndSleep(uint32_t expectedIdleTime)
+{
+	(void)expectedIdleTime;
+}
+#endif
@@ -0,0 +1,304 @@
+/*
+ * my_runtime.c
+ *
+ *  Created on: Jan 21, 2026
+ *      Author: Basti
+ */
+#include "Runtime_implementation/my_runtime.h"
+#include "Runtime_implementation/my_trace.h"
+#include "Runtime_implementation/my_power.h"
+#include "Console.h"
+#include "FreeRTOS.h"
+#include <task.h>
+#include <timers.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef WIN32
+#include "main.h"
+#else
+#include <time.h>
+#endif
+
+// top rechnet ueber ein gleitendes Fenster aus TOP_SLOTS - 1 Abtastungen im Abstand von TOP_SAMPLE_MS
+#define TOP_SAMPLE_MS   250
+#define TOP_SLOTS       9
+#define TOP_MAX_TASKS   16
+
+typedef struct
+{
+	uint64_t     wall;  // Zyklen inklusive Interrupts
+	uint64_t     isr;   // davon in Interrupts
+	uint32_t     wakeups;
+	uint32_t     slept; // im Tickless Idle uebersprungene Ticks
+	unsigned int count;
+	struct
+	{
+		TaskHandle_t                handle;
+		configRUN_TIME_COUNTER_TYPE runtime;
+	} tasks[TOP_MAX_TASKS];
+} TopSample_t;
+
+static TopSample_t topSamples[TOP_SLOTS];
+static unsigned int topHead = 0;
+static unsigned int topFilled = 0;
+static TaskStatus_t topStatus[TOP_MAX_TASKS];
+static StaticTimer_t topTimerBuffer;
+
+#ifndef WIN32
+// obere 32 Bit des Zyklenzaehlers, CYCCNT laeuft bei 216 MHz nach ca. 20 s ueber. Die Abtastung von top und jeder
+// Taskwechsel lesen ihn deutlich oefter, so wird kein Ueberlauf verpasst
+static uint32_t cycLast = 0;
+static uint32_t cycHigh = 0;
+
+// Zeit in Interrupts, die Verschachtelung wird mitgezaehlt und nur der aeusserste Interrupt gemessen
+static volatile uint32_t isrNesting = 0;
+static volatile uint32_t isrStart = 0;
+static volatile uint64_t isrCycles = 0;
+
+// im Tickless Idle verschlafene Zyklen, falls CYCCNT dabei stand
+static uint64_t cycSlept = 0;
+
+static uint64_t RuntimeExtend(uint32_t now)
+{
+	if (now < cycLast)
+	{
+		cycHigh++;
+	}
+	cycLast = now;
+	return (((uint64_t)cycHigh << 32) | now) + cycSlept;
+}
+#endif
+
+void configureTimerForRunTimeStats(void)
+{
+#ifndef WIN32
+	// CYCCNT wird nicht zurueckgesetzt, die Drehzahlmessung der Spindel stempelt ihre Flanken schon damit
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	cycLast = DWT->CYCCNT;
+	cycHigh = 0;
+#endif
+}
+
+uint64_t Runtime_GetCycles(void)
+{
+#ifndef WIN32
+	// PRIMASK statt BASEPRI, weil auch Interrupts oberhalb von configMAX_SYSCALL_INTERRUPT_PRIORITY gemessen werden
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint64_t now = RuntimeExtend(DWT->CYCCNT);
+	__set_PRIMASK(primask);
+	return now;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+void Runtime_AddSleepCycles(uint64_t cycles)
+{
+#ifndef WIN32
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	cycSlept += cycles;
+	__set_PRIMASK(primask);
+#else
+	(void)cycles;
+#endif
+}
+
+uint64_t Runtime_GetIsrCycles(void)
+{
+#ifndef WIN32
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint64_t cycles = isrCycles;
+	if (isrNesting > 0)
+	{
+		cycles += DWT->CYCCNT - isrStart;
+	}
+	__set_PRIMASK(primask);
+	return cycles;
+#else
+	return 0;
+#endif
+}
+
+// Taskzeit: Zyklen ohne die Interrupts, beides unter einer Sperre gelesen, sonst koennte der Wert zuruecklaufen
+uint64_t getRunTimeCounterValue(void)
+{
+#ifndef WIN32
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t now = DWT->CYCCNT;
+	uint64_t cycles = RuntimeExtend(now) - isrCycles;
+	if (isrNesting > 0)
+	{
+		cycles -= now - isrStart;
+	}
+	__set_PRIMASK(primask);
+	return cycles;
+#else
+	return Runtime_GetCycles();
+#endif
+}
+
+void Runtime_IsrEnter(void)
+{
+#ifndef WIN32
+	TRACE_EVENT(TRACE_ISR_ENTER, __get_IPSR());
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if (isrNesting++ == 0)
+	{
+		isrStart = DWT->CYCCNT;
+	}
+	__set_PRIMASK(primask);
+#endif
+}
+
+void Runtime_IsrExit(void)
+{
+#ifndef WIN32
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if (isrNesting > 0 && --isrNesting == 0)
+	{
+		isrCycles += DWT->CYCCNT - isrStart;
+	}
+	__set_PRIMASK(primask);
+	TRACE_EVENT(TRACE_ISR_EXIT, __get_IPSR());
+#endif
+}
+
+// laeuft im Timer Task und legt die Zaehler aller Tasks im Ring ab
+static void RuntimeSample(TimerHandle_t timer)
+{
+	(void)timer;
+
+	TopSample_t* s = &topSamples[topHead];
+	unsigned int count = (unsigned int)uxTaskGetSystemState(topStatus, TOP_MAX_TASKS, NULL);
+	s->wall = Runtime_GetCycles();
+	s->isr = Runtime_GetIsrCycles();
+	s->wakeups = Power_GetWakeups();
+	s->slept = Power_GetSleptTicks();
+	s->count = count;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		s->tasks[i].handle = topStatus[i].xHandle;
+		s->tasks[i].runtime = topStatus[i].ulRunTimeCounter;
+	}
+
+	topHead = (topHead + 1) % TOP_SLOTS;
+	if (topFilled < TOP_SLOTS)
+	{
+		topFilled++;
+	}
+}
+
+static int RuntimeFindTask(const TopSample_t* s, TaskHandle_t handle, configRUN_TIME_COUNTER_TYPE* runtime)
+{
+	for (unsigned int i = 0; i < s->count; i++)
+	{
+		if (s->tasks[i].handle == handle)
+		{
+			*runtime = s->tasks[i].runtime;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+// top -> Rechenzeit je Task, aller Interrupts und des Idle Tasks in Prozent ueber die letzten 2 s
+static int TopCommand(int argc, char** argv, void* ctx)
+{
+	static TopSample_t first;
+	static TopSample_t last;
+	static TaskStatus_t tasks[TOP_MAX_TASKS];
+	(void)argv;
+	(void)ctx;
+
+	if (argc != 0)
+	{
+		CONSOLE_Printf("invalid arguments\r\nFAIL");
+		return -1;
+	}
+
+	vTaskSuspendAll();
+	unsigned int filled = topFilled;
+	if (filled >= 2)
+	{
+		memcpy(&first, &topSamples[(topHead + TOP_SLOTS - filled) % TOP_SLOTS], sizeof(TopSample_t));
+		memcpy(&last, &topSamples[(topHead + TOP_SLOTS - 1) % TOP_SLOTS], sizeof(TopSample_t));
+	}
+	xTaskResumeAll();
+
+	if (filled < 2)
+	{
+		CONSOLE_Printf("no samples yet\r\nFAIL");
+		return -1;
+	}
+
+	float wall = (float)(last.wall - first.wall);
+	if (wall <= 0.0f)
+	{
+		CONSOLE_Printf("FAIL");
+		return -1;
+	}
+
+	// Namen aus dem aktuellen Zustand, damit kein Handle eines inzwischen geloeschten Tasks benutzt wird
+	unsigned int count = (unsigned int)uxTaskGetSystemState(tasks, TOP_MAX_TASKS, NULL);
+	TaskHandle_t idle = xTaskGetIdleTaskHandle();
+	float idlePercent = 0.0f;
+	CONSOLE_Printf("window %u ms\r\n", (filled - 1) * TOP_SAMPLE_MS);
+	CONSOLE_Printf("|------------------|-------|\r\n");
+	CONSOLE_Printf("| NAME             | CPU %% |\r\n");
+	CONSOLE_Printf("|------------------|-------|\r\n");
+	for (unsigned int i = 0; i < count; i++)
+	{
+		configRUN_TIME_COUNTER_TYPE end = 0;
+		configRUN_TIME_COUNTER_TYPE start = 0;
+		if (RuntimeFindTask(&last, tasks[i].xHandle, &end) != 0)
+		{
+			// erst nach der letzten Abtastung entstanden
+			continue;
+		}
+		// fehlt er in der ersten Abtastung, ist er erst im Fenster entstanden und startet bei 0
+		RuntimeFindTask(&first, tasks[i].xHandle, &start);
+
+		float percent = (float)(end - start) * 100.0f / wall;
+		if (tasks[i].xHandle == idle)
+		{
+			idlePercent = percent;
+		}
+		CONSOLE_Printf("| %-16.16s | %5.1f |\r\n", tasks[i].pcTaskName, percent);
+	}
+	CONSOLE_Printf("|------------------|-------|\r\n");
+
+	float isrPercent = (float)(last.isr - first.isr) * 100.0f / wall;
+	CONSOLE_Printf("| %-16.16s | %5.1f |\r\n", "(ISR)", isrPercent);
+	CONSOLE_Printf("|------------------|-------|\r\n");
+	CONSOLE_Printf("idle %.1f %%, load %.1f %%\r\n", idlePercent, 100.0f - idlePercent);
+
+	// Aufwachen aus dem Tickless Idle je Sekunde und der Anteil der Zeit ohne Tick
+	float window = (float)((filled - 1) * TOP_SAMPLE_MS);
+	CONSOLE_Printf("wake-ups %.1f /s, tickless %.1f %%\r\nOK", (float)(last.wakeups - first.wakeups) * 1000.0f / window,
+			(float)(last.slept - first.slept) * (1000.0f / configTICK_RATE_HZ) * 100.0f / window);
+	return 0;
+}
+
+void Runtime_Init(struct ConsoleHandle* c)
+{
+	TimerHandle_t timer = xTimerCreateStatic("top", pdMS_TO_TICKS(TOP_SAMPLE_MS), pdTRUE, NULL, RuntimeSample,
+			&topTimerBuffer);
+	if (timer == NULL || xTimerStart(timer, 0) != pdPASS)
+	{
+		printf("error at creating top in my_runtime.c\n");
+		return;
+	}
+
+	CONSOLE_RegisterCommand(c, "top", "<<top>> prints the CPU usage of each task, of all interrupts and the idle time\r\n"
+			"over the last 2 seconds, measured with the cycle counter, and the wake-ups per second\r\n"
+			"from tickless idle.", TopCommand, NULL);
+}
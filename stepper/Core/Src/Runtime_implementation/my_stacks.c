@@ -0,0 +1,226 @@
+/*
+ * my_stacks.c
+ *
+ *  Created on: Jan 27, 2026
+ *      Author: Basti
+ */
+#include "Runtime_implementation/my_stacks.h"
+#include "Console.h"
+#include "FreeRTOS.h"
+#include <task.h>
+#include <timers.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#ifndef WIN32
+#include "main.h"
+#endif
+
+#define STACKS_MAX_TASKS    16
+// gleiches Muster wie tskSTACK_FILL_BYTE, mit dem FreeRTOS die Task Stacks fuellt
+#define STACKS_PATTERN      0xA5A5A5A5UL
+
+static TaskStatus_t stacksStatus[STACKS_MAX_TASKS];
+static StaticTimer_t stacksTimerBuffer;
+static volatile uint32_t stacksPainted = 0;
+static uint32_t stacksBootDone = 0;
+
+// Ersatz fuer das Stressszenario der Host Simulation: die Konsole liest statt der Eingabe diese Zeilen und
+// durchlaeuft damit die tiefsten Pfade (Tabellen mit float Ausgabe, SPI Zugriffe, TAB Vervollstaendigung,
+// Historie, Loeschen im Zeileneditor). Die letzte Zeile gibt den Bericht aus. Es wird nichts bewegt, die Job
+// Worker erreichen ihre tiefsten Pfade erst mit einer Fahrt (stepper reference) vor dem Aufruf
+static const char stacksStressScript[] =
+	"help\r"
+	"tasks\r"
+	"top\r"
+	"heap\r"
+	"pools\r"
+	"isr\r"
+	"log\r"
+	"trace\r"
+	"pwm\r"
+	"mallinfo\r"
+	"spindle status\r"
+	"spindle table\r"
+	"stepper status\r"
+	"stepper position\r"
+	"watch 100 all\r"
+	"watch\r"
+	"watch stop\r"
+	"jobs\r"
+	"st\t"           // Kandidaten stacks und stepper auflisten
+	"\x7f\x7f"      // und wieder loeschen
+	"stepper st\t\r" // zu stepper status ergaenzen
+	"\033[A\033[A\r" // Historie: jobs nochmal
+	"stacks\r";
+static unsigned int stacksStressPos = 0;
+static struct ConsoleHandle* stacksConsole = NULL;
+
+#ifndef WIN32
+// Ende des RAM aus dem Linkerskript, der ISR Stack sind die obersten configISR_STACK_SIZE_WORDS Worte darunter
+// (newlib_abs.c haelt den Heap davon fern)
+extern uint32_t _estack;
+
+// laeuft im Timer Task: im Thread Mode ist kein Interrupt aktiv und der MSP steht wieder am Ende des RAM, main()
+// hat den Bereich vor dem Start des Schedulers aber schon benutzt. Unter PRIMASK kann kein Interrupt den Stack
+// waehrend des Fuellens brauchen, die wenigen tausend Schreibzugriffe dauern ca. 20 us
+static void StacksPaintIsr(void)
+{
+	uint32_t* bottom = &_estack - configISR_STACK_SIZE_WORDS;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t* limit = (uint32_t*)__get_MSP() - 8;
+	for (uint32_t* p = bottom; p < limit; p++)
+	{
+		*p = STACKS_PATTERN;
+	}
+	__set_PRIMASK(primask);
+	stacksPainted = 1;
+}
+
+// der Stack waechst nach unten, das unterste veraenderte Wort ist die Hochwassermarke
+static unsigned int StacksIsrUsed(void)
+{
+	uint32_t* p = &_estack - configISR_STACK_SIZE_WORDS;
+	while (p < &_estack && *p == STACKS_PATTERN)
+	{
+		p++;
+	}
+	return (unsigned int)(&_estack - p);
+}
+#endif
+
+static unsigned int StacksAdvice(unsigned int used)
+{
+	unsigned int margin = used * STACKS_MARGIN_PERCENT / 100;
+	if (margin < STACKS_MARGIN_WORDS)
+	{
+		margin = STACKS_MARGIN_WORDS;
+	}
+	return (used + margin + STACKS_ROUND_WORDS - 1) / STACKS_ROUND_WORDS * STACKS_ROUND_WORDS;
+}
+
+static void StacksPrintRow(const char* name, unsigned int size, unsigned int used, unsigned long* reclaim)
+{
+	unsigned int advice = StacksAdvice(used);
+	printf("| %-16.16s | %5u | %5u | %3u %% | %6u |%s\r\n", name, size, used, used * 100 / size, advice,
+			(used >= size) ? " overflow?" : "");
+	if (advice < size)
+	{
+		*reclaim += (unsigned long)(size - advice) * sizeof(StackType_t);
+	}
+}
+
+// Tabelle in Worten, die Empfehlung gilt nur fuer die bis dahin durchlaufenen Pfade
+static void StacksReport(void)
+{
+	unsigned long reclaim = 0;
+	unsigned int count = (unsigned int)uxTaskGetSystemState(stacksStatus, STACKS_MAX_TASKS, NULL);
+
+	printf("|------------------|-------|-------|-------|--------|\r\n");
+	printf("| NAME             |  SIZE |  USED |  USE%% | ADVICE |\r\n");
+	printf("|------------------|-------|-------|-------|--------|\r\n");
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int size = (unsigned int)(stacksStatus[i].pxEndOfStack - stacksStatus[i].pxStackBase) + 1;
+		unsigned int used = size - (unsigned int)stacksStatus[i].usStackHighWaterMark;
+		StacksPrintRow(stacksStatus[i].pcTaskName, size, used, &reclaim);
+	}
+	printf("|------------------|-------|-------|-------|--------|\r\n");
+#ifndef WIN32
+	if (stacksPainted)
+	{
+		StacksPrintRow("(ISR)", configISR_STACK_SIZE_WORDS, StacksIsrUsed(), &reclaim);
+	}
+	else
+#endif
+	{
+		printf("| %-16.16s | %5u |     - |     - |      - |\r\n", "(ISR)", configISR_STACK_SIZE_WORDS);
+	}
+	printf("|------------------|-------|-------|-------|--------|\r\n");
+	printf("words of %u bytes, advice keeps %u %% (at least %u words) margin, %lu bytes reclaimable\r\n",
+			(unsigned int)sizeof(StackType_t), STACKS_MARGIN_PERCENT, STACKS_MARGIN_WORDS, reclaim);
+}
+
+// erster Aufruf direkt nach dem Start: ISR Stack fuellen, zweiter Aufruf: Bericht nach STACKS_BOOT_REPORT_MS
+static void StacksTimer(TimerHandle_t timer)
+{
+	if (!stacksBootDone)
+	{
+		stacksBootDone = 1;
+#ifndef WIN32
+		StacksPaintIsr();
+#endif
+#if STACKS_BOOT_REPORT_MS > 0
+		xTimerChangePeriod(timer, pdMS_TO_TICKS(STACKS_BOOT_REPORT_MS), 0);
+#else
+		(void)timer;
+#endif
+		return;
+	}
+
+	printf("stacks %u ms after start\r\n", STACKS_BOOT_REPORT_MS);
+	StacksReport();
+}
+
+// Lesefunktion der Konsole waehrend stacks stress, am Ende des Skripts wird wieder auf die Eingabe umgeschaltet
+static int StacksStressRead(void* context, char* buffer, int num)
+{
+	(void)context;
+
+	unsigned int left = (unsigned int)(sizeof(stacksStressScript) - 1) - stacksStressPos;
+	if (left == 0)
+	{
+		CONSOLE_RedirectStreams(stacksConsole, NULL, NULL, NULL, NULL);
+		return -1;
+	}
+
+	unsigned int n = ((unsigned int)num < left) ? (unsigned int)num : left;
+	memcpy(buffer, &stacksStressScript[stacksStressPos], n);
+	stacksStressPos += n;
+	return (int)n;
+}
+
+// stacks        -> Groesse, Hochwassermarke und empfohlene Groesse je Task und des ISR Stacks
+// stacks stress -> erst die Befehle aus stacksStressScript ausfuehren, dann der Bericht
+static int StacksCommand(int argc, char** argv, void* ctx)
+{
+	if (argc == 1 && strcmp(argv[0], "stress") == 0)
+	{
+		// die Ausgabe bleibt auf stdout, nur die Eingabe kommt aus dem Skript
+		stacksConsole = (struct ConsoleHandle*)ctx;
+		stacksStressPos = 0;
+		if (CONSOLE_RedirectStreams(stacksConsole, StacksStressRead, NULL, NULL, NULL) != 0)
+		{
+			printf("redirection not supported\r\nFAIL");
+			return -1;
+		}
+		printf("OK");
+		return 0;
+	}
+
+	if (argc != 0)
+	{
+		printf("invalid arguments\r\nFAIL");
+		return -1;
+	}
+
+	StacksReport();
+	printf("OK");
+	return 0;
+}
+
+void Stacks_Init(struct ConsoleHandle* c)
+{
+	TimerHandle_t timer = xTimerCreateStatic("stacks", 1, pdFALSE, NULL, StacksTimer, &stacksTimerBuffer);
+	if (timer == NULL || xTimerStart(timer, 0) != pdPASS)
+	{
+		printf("error at creating stacks in my_stacks.c\n");
+		return;
+	}
+
+	CONSOLE_RegisterCommand(c, "stacks", "<<stacks>> prints size, high-water mark and an advised size in words of each\r\n"
+			"task stack and of the interrupt stack. <<stacks stress>> first runs the deepest console paths from a\r\n"
+			"script (input is ignored meanwhile) and prints the report at its end.", StacksCommand, c);
+	CONSOLE_RegisterSubcommand(c, "stacks", "stress");
+}
@@ -0,0 +1,224 @@
+/*
+ * my_trace.c
+ *
+ *  Created on: Jan 26, 2026
+ *      Author: Basti
+ */
+#include "Runtime_implementation/my_trace.h"
+#include "Runtime_implementation/my_runtime.h"
+#include "Console.h"
+#include "FreeRTOS.h"
+#include <task.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef WIN32
+#include "main.h"
+#endif
+
+// Anzahl der Records im Ring (Zweierpotenz), aeltere Records werden ueberschrieben
+#define TRACE_RECORDS       1024
+#define TRACE_MAX_TASKS     16
+// 4 Records (48 Byte) je Zeile, base64 kodiert
+#define TRACE_LINE_BYTES    48
+// Takt der Zeitstempel im Kopf: DWT CYCCNT auf dem Target, in der Host Simulation liefert Runtime_GetCycles
+// Mikrosekunden
+#ifndef WIN32
+#define TRACE_CLOCK_HZ      configCPU_CLOCK_HZ
+#else
+#define TRACE_CLOCK_HZ      1000000u
+#endif
+
+// 12 Byte im little endian Format des Cortex-M7, so wie sie im Speicher liegen wird der Ring auch ausgegeben
+typedef struct
+{
+	uint32_t timestamp; // DWT CYCCNT (Host: us), der Decoder erweitert den Ueberlauf
+	uint8_t  type;      // TRACE_xxx
+	uint8_t  task;      // Nummer des laufenden bzw. unterbrochenen Tasks
+	uint16_t reserved;
+	uint32_t value;
+} TraceRecord_t;
+
+static TraceRecord_t traceRing[TRACE_RECORDS];
+static uint32_t traceHead = 0; // Anzahl aller geschriebenen Records
+static volatile uint32_t traceEnabled = 1;
+static uint8_t traceCurrentTask = 0;
+
+static const char traceBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void Trace_Event(uint8_t type, uint32_t value)
+{
+	if (!traceEnabled)
+	{
+		return;
+	}
+
+#ifndef WIN32
+	// wenige Befehle unter PRIMASK, damit ist der Ring aus Tasks, dem Scheduler und allen Interrupts beschreibbar
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	TraceRecord_t* r = &traceRing[traceHead & (TRACE_RECORDS - 1)];
+	traceHead++;
+	r->timestamp = DWT->CYCCNT;
+	r->type = type;
+	r->task = traceCurrentTask;
+	r->reserved = 0;
+	r->value = value;
+	__set_PRIMASK(primask);
+#else
+	TraceRecord_t* r = &traceRing[traceHead & (TRACE_RECORDS - 1)];
+	traceHead++;
+	r->timestamp = (uint32_t)Runtime_GetCycles();
+	r->type = type;
+	r->task = traceCurrentTask;
+	r->reserved = 0;
+	r->value = value;
+#endif
+}
+
+// aus vTaskSwitchContext, der neue Task gilt auch fuer alle folgenden Records
+void Trace_TaskSwitchedIn(uint32_t taskNumber)
+{
+	traceCurrentTask = (uint8_t)taskNumber;
+	Trace_Event(TRACE_TASK_IN, taskNumber);
+}
+
+// Semaphore und Mutexe sind im Kernel Queues, sie unterscheiden sich nur im Typ (0 ist eine echte Queue)
+void Trace_Queue(uint8_t type, const void* queue, uint8_t queueType)
+{
+	if (queueType != 0)
+	{
+		type = (type == TRACE_QUEUE_SEND) ? TRACE_SEM_GIVE : TRACE_SEM_TAKE;
+	}
+	Trace_Event(type, (uint32_t)(uintptr_t)queue);
+}
+
+// der Name passt nicht in einen Record, die ersten vier Zeichen reichen zum Erkennen des Befehls
+void Trace_Command(const char* name)
+{
+	uint32_t value = 0;
+	for (unsigned int i = 0; i < 4 && name[i] != 0; i++)
+	{
+		value |= (uint32_t)(uint8_t)name[i] << (8 * i);
+	}
+	Trace_Event(TRACE_CONSOLE_BEGIN, value);
+}
+
+#if TRACE_ENABLE
+static void TracePrintBase64(const uint8_t* data, unsigned int length)
+{
+	char line[(TRACE_LINE_BYTES / 3) * 4 + 1];
+	unsigned int n = 0;
+	for (unsigned int i = 0; i < length; i += 3)
+	{
+		uint32_t bits = (uint32_t)data[i] << 16;
+		if (i + 1 < length) bits |= (uint32_t)data[i + 1] << 8;
+		if (i + 2 < length) bits |= data[i + 2];
+		line[n++] = traceBase64[(bits >> 18) & 0x3F];
+		line[n++] = traceBase64[(bits >> 12) & 0x3F];
+		line[n++] = (i + 1 < length) ? traceBase64[(bits >> 6) & 0x3F] : '=';
+		line[n++] = (i + 2 < length) ? traceBase64[bits & 0x3F] : '=';
+	}
+	line[n] = 0;
+	printf("#T,D,%s\r\n", line);
+}
+
+// Kopf mit Takt und Tasknamen, danach die Records vom aeltesten zum neuesten, jede Zeile mit #T, damit der Decoder
+// den Block aus der restlichen Ausgabe der Konsole herausfinden kann
+static void TraceDump(void)
+{
+	static TaskStatus_t tasks[TRACE_MAX_TASKS];
+	static uint8_t chunk[TRACE_LINE_BYTES];
+
+	uint32_t head = traceHead;
+	uint32_t count = (head < TRACE_RECORDS) ? head : TRACE_RECORDS;
+	printf("#T,B,%lu,%lu,%u\r\n", (unsigned long)TRACE_CLOCK_HZ, (unsigned long)count,
+			(unsigned int)sizeof(TraceRecord_t));
+
+	unsigned int numTasks = (unsigned int)uxTaskGetSystemState(tasks, TRACE_MAX_TASKS, NULL);
+	for (unsigned int i = 0; i < numTasks; i++)
+	{
+		printf("#T,N,%u,%s\r\n", (unsigned int)tasks[i].xTaskNumber, tasks[i].pcTaskName);
+	}
+
+	unsigned int fill = 0;
+	for (uint32_t i = head - count; i != head; i++)
+	{
+		memcpy(&chunk[fill], &traceRing[i & (TRACE_RECORDS - 1)], sizeof(TraceRecord_t));
+		fill += sizeof(TraceRecord_t);
+		if (fill == TRACE_LINE_BYTES)
+		{
+			TracePrintBase64(chunk, fill);
+			fill = 0;
+		}
+	}
+	if (fill > 0)
+	{
+		TracePrintBase64(chunk, fill);
+	}
+	printf("#T,E\r\n");
+}
+
+// trace              -> Anzahl der Records und Zustand ausgeben
+// trace start|stop   -> Aufzeichnung fortsetzen oder anhalten
+// trace clear        -> Ring leeren
+// trace dump         -> Ring kodiert ausgeben, waehrend der Ausgabe wird nicht aufgezeichnet
+static int TraceCommand(int argc, char** argv, void* ctx)
+{
+	(void)ctx;
+
+	if (argc == 0)
+	{
+		uint32_t head = traceHead;
+		printf("%lu records of %u, %s\r\nOK", (unsigned long)((head < TRACE_RECORDS) ? head : TRACE_RECORDS),
+				TRACE_RECORDS, traceEnabled ? "running" : "stopped");
+		return 0;
+	}
+
+	if (argc == 1 && strcmp(argv[0], "start") == 0)
+	{
+		traceEnabled = 1;
+	}
+	else if (argc == 1 && strcmp(argv[0], "stop") == 0)
+	{
+		traceEnabled = 0;
+	}
+	else if (argc == 1 && strcmp(argv[0], "clear") == 0)
+	{
+		uint32_t enabled = traceEnabled;
+		traceEnabled = 0;
+		traceHead = 0;
+		traceEnabled = enabled;
+	}
+	else if (argc == 1 && strcmp(argv[0], "dump") == 0)
+	{
+		uint32_t enabled = traceEnabled;
+		traceEnabled = 0;
+		TraceDump();
+		traceEnabled = enabled;
+	}
+	else
+	{
+		printf("invalid arguments\r\nFAIL");
+		return -1;
+	}
+
+	printf("OK");
+	return 0;
+}
+#endif
+
+void Trace_Init(struct ConsoleHandle* c)
+{
+#if TRACE_ENABLE
+	CONSOLE_RegisterCommand(c, "trace", "<<trace>> prints the state of the binary event trace. <<trace start>> and\r\n"
+			"<<trace stop>> control the recording, <<trace clear>> empties it and <<trace dump>> prints it\r\n"
+			"base64 encoded for SCA/trace_decode.", TraceCommand, NULL);
+	static char* const traceSubcommands[] = { "start", "stop", "clear", "dump" };
+	for (unsigned int i = 0; i < sizeof(traceSubcommands) / sizeof(traceSubcommands[0]); i++)
+	{
+		CONSOLE_RegisterSubcommand(c, "trace", traceSubcommands[i]);
+	}
+#else
+	(void)c;
+#endif
+}
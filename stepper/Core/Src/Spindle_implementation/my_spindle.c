@@ -8,17 +8,117 @@
 #include "Spindle_implementation/my_spindle.h" // own Spindle-Header file
 #include "Spindle.h"	// from LibSpindle
 #include "Console.h"	// fuer ConsoleHandle_t
+#include "Runtime_implementation/my_trace.h" // fuer TRACE_EVENT
+#include "Runtime_implementation/my_power.h" // fuer Power_SetBusy
+#include "Stepper_implementation/my_motion.h" // fuer Motion_Acquire waehrend des Flash Loeschens
+#include "FreeRTOS.h"
 #include "FreeRTOSConfig.h"
+#include <task.h>		// fuer taskENTER_CRITICAL
 #include <stdint.h>		// fuer einheitliche Datentypen
 #include <stdbool.h>	// fuer boolean type
+#include <math.h>		// fuer fabsf
 #include <stdio.h>		// fuer printf Output -> newlib liefert die selben Ergebnisse wie stdio.h ist aber spezifischer
 						// -> dadurch waere dieses Projekt nicht auf andere Microcontroller portierbar
+#include <string.h>		// fuer memcpy und strcmp
+#include <stdlib.h>		// fuer atoi
+#include <stddef.h>		// fuer offsetof
 
 extern bool error_variable;
 extern TIM_HandleTypeDef htim2; // wird in main.c definiert
-// direction 0 == vorwaerts, 1 == zurueck
-static int8_t current_spindle_direction = 1;
-float current_spindle_duty_cycle = 0;
+
+// PWM fuer die H-Bruecke: TIM2 ist ein 32 Bit Timer, daher laeuft er immer mit Prescaler 0 und die Aufloesung ergibt
+// sich aus Timertakt / Frequenz. Die Grenzen kommen von der H-Bruecke (BTS7960 bis 25 kHz)
+#define SPINDLE_PWM_DEFAULT_HZ			20000u
+#define SPINDLE_PWM_MIN_HZ				1000u
+#define SPINDLE_PWM_MAX_HZ				25000u
+// Nachkommabits des Duty Cycles in der Ganzzahlrechnung, der Rest unter einem Zaehlschritt wird gedithert
+#define SPINDLE_PWM_FRACTION_BITS		16
+#define SPINDLE_PWM_FRACTION_MASK		((1u << SPINDLE_PWM_FRACTION_BITS) - 1u)
+
+// Drehzahlmessung ueber SPINDLE_SI_R: jede steigende Flanke wird mit dem Zyklenzaehler (DWT) zeitgestempelt
+#define SPINDLE_TACHO_PULSES_PER_REV	1
+// ohne Flanke innerhalb dieser Zeit gilt die Spindel als stehend
+#define SPINDLE_TACHO_TIMEOUT_MS		200
+
+// die Kalibriertabelle der LibSpindle liegt im letzten Flash Sektor, der im Linker Script (STM32F746ZGTX_FLASH.ld)
+// vom Programm ausgenommen ist. Im Simulator wird sie stattdessen in eine Datei geschrieben
+#define SPINDLE_CALIBRATION_MAGIC		0x53434131u	// "SCA1"
+
+// Hardware und Zustand einer Spindel, wird der LibSpindle als context uebergeben. Alle Instanzen teilen sich die
+// Task der LibSpindle, pro Spindel gibt es nur diesen Kontext, den Timer und die Pins
+typedef struct
+{
+	const char*        name;			// Name des Konsolenbefehls
+	TIM_HandleTypeDef* timer;			// 32 Bit Timer am APB1 (TIM2 oder TIM5)
+	uint32_t           channelL;		// SPINDLE_PWM_L, rueckwaerts
+	uint32_t           channelR;		// SPINDLE_PWM_R, vorwaerts
+	GPIO_TypeDef*      enaLPort;
+	uint16_t           enaLPin;
+	GPIO_TypeDef*      enaRPort;
+	uint16_t           enaRPin;
+	GPIO_TypeDef*      tachoPort;		// Index Eingang fuer die Drehzahlmessung
+	uint16_t           tachoPin;
+	IRQn_Type          tachoIRQ;
+	uint32_t           calibrationSector;	// jede Spindel braucht einen eigenen, im Linker Script reservierten Sektor
+	uintptr_t          calibrationAddress;
+	const char*        calibrationFile;
+	float              maxRPM;
+
+	// direction 0 == vorwaerts, 1 == zurueck
+	int8_t             direction;
+	float              dutyCycle;
+	int                enabled;
+	SpindleHandle_t    handle;
+
+	uint32_t           pwmFrequency;
+	volatile uint32_t  pwmPeriod;		// Zaehlschritte pro PWM Periode (ARR + 1)
+	volatile uint32_t  pwmCompare;		// ganzzahliger Anteil des Compare Werts
+	volatile uint32_t  pwmFraction;		// Anteil unter einem Zaehlschritt in 1/65536
+	volatile uint32_t  pwmAccu;			// Akkumulator des Sigma-Delta Modulators
+	volatile uint8_t   pwmDither;
+
+	volatile uint32_t  tachoLastEdge;
+	volatile uint32_t  tachoSumCycles;
+	volatile uint32_t  tachoEdges;
+	volatile uint8_t   tachoValid;
+	float              tachoLastRPM;
+	// fuer die Synchronisation des Vorschubs: alle Flanken seit dem Start und die Dauer der letzten Umdrehung
+	volatile uint32_t  tachoTotalEdges;
+	volatile uint32_t  tachoLastPeriod;
+} SpindleContext_t;
+
+// das Board hat eine Spindel, eine zweite wird hier mit eigenem Timer, Pins und Flash Sektor eingetragen
+static SpindleContext_t spindle_contexts[] =
+{
+	{
+		.name               = "spindle",
+		.timer              = &htim2,
+		.channelL           = TIM_CHANNEL_3,
+		.channelR           = TIM_CHANNEL_4,
+		.enaLPort           = SPINDLE_ENA_L_GPIO_Port,
+		.enaLPin            = SPINDLE_ENA_L_Pin,
+		.enaRPort           = SPINDLE_ENA_R_GPIO_Port,
+		.enaRPin            = SPINDLE_ENA_R_Pin,
+		.tachoPort          = SPINDLE_SI_R_GPIO_Port,
+		.tachoPin           = SPINDLE_SI_R_Pin,
+		.tachoIRQ           = EXTI0_IRQn,
+		.calibrationSector  = FLASH_SECTOR_7,
+		.calibrationAddress = 0x080C0000u,
+		.calibrationFile    = "spindle_calibration.bin",
+		.maxRPM             = 9000.0f,
+		.direction          = 1,
+		.pwmFrequency       = SPINDLE_PWM_DEFAULT_HZ,
+		.pwmPeriod          = 4500,
+	},
+};
+#define SPINDLE_COUNT	(sizeof(spindle_contexts) / sizeof(spindle_contexts[0]))
+
+typedef struct
+{
+	uint32_t magic;
+	SpindleCalibration_t table;
+	uint32_t checksum;
+} SpindleCalibrationRecord_t;
 
 //Hardwarespezifische Funktionen - jetzt doch nicht mehr verwendet
 /*
@@ -29,44 +129,188 @@ void init_Spindle(void){
 
 void SPINDLE_SetDirection(SpindleHandle_t h, void* context, int backward){
 	//Hardware Funktion um Rotationsrichtung zu bestimmen
-	current_spindle_direction = (int8_t) backward;
+	SpindleContext_t* ctx = (SpindleContext_t*)context;
+	ctx->direction = (int8_t) backward;
+	TRACE_EVENT(TRACE_SPINDLE_DIR, backward ? 0 : 1);
 
-	// da context und h nicht verwendet werden
-	(void)context;
+	// da h nicht verwendet wird
 	(void)h;
 }
 
-void SPINDLE_SetDutyCycle(SpindleHandle_t h, void* context, float dutyCycle){
-	//DUTY Cycle bestimmt Drehgeschwindigkeit vermutlich mit maxRPM* %Duty Cycle
+// rechnet den Duty Cycle in den Compare Wert der aktiven Seite um, der andere Kanal wird auf 0 gesetzt
+static void Spindle_UpdateCompare(SpindleContext_t* ctx)
+{
+	float duty = ctx->dutyCycle;
+	if (duty < 0.0f) duty = 0.0f;
+	if (duty > 1.0f) duty = 1.0f;
+
+	// nur eine Umrechnung in Festkomma, der Rest ist Ganzzahlrechnung: Zaehlschritte mit 16 Nachkommabits
+	uint64_t counts = (uint64_t)(uint32_t)(duty * (float)(1u << SPINDLE_PWM_FRACTION_BITS) + 0.5f) * ctx->pwmPeriod;
+	uint32_t compare = (uint32_t)(counts >> SPINDLE_PWM_FRACTION_BITS);
+	uint32_t fraction = (uint32_t)counts & SPINDLE_PWM_FRACTION_MASK;
+
+	taskENTER_CRITICAL();
+	if (ctx->pwmDither && fraction != 0)
+	{
+		// der Update Interrupt addiert in jeder Periode den Bruchteil und gibt den Ueberlauf als einen Schritt mehr aus
+		ctx->pwmFraction = fraction;
+		__HAL_TIM_ENABLE_IT(ctx->timer, TIM_IT_UPDATE);
+	}
+	else
+	{
+		// ohne Dithering wird gerundet, der Interrupt wird nicht gebraucht
+		__HAL_TIM_DISABLE_IT(ctx->timer, TIM_IT_UPDATE);
+		ctx->pwmFraction = 0;
+		compare += (fraction >> (SPINDLE_PWM_FRACTION_BITS - 1));
+	}
+	ctx->pwmCompare = compare;
 
-	current_spindle_duty_cycle = dutyCycle;
 	// wenn Spindle rueckwaerts dreht
-	if (current_spindle_direction == 1)
+	if (ctx->direction == 1)
 	{
-		__HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_3, current_spindle_duty_cycle * 4499); // SPINDLE_PWM_L
-		__HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_4, 0); // SPINDLE_PWM_R
+		__HAL_TIM_SET_COMPARE(ctx->timer, ctx->channelL, compare); // SPINDLE_PWM_L
+		__HAL_TIM_SET_COMPARE(ctx->timer, ctx->channelR, 0); // SPINDLE_PWM_R
 	}
 	else
 	{
-		__HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_3, 0); // SPINDLE_PWM_L
-		__HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_4, current_spindle_duty_cycle * 4499); // SPINDLE_PWM_R
+		__HAL_TIM_SET_COMPARE(ctx->timer, ctx->channelL, 0); // SPINDLE_PWM_L
+		__HAL_TIM_SET_COMPARE(ctx->timer, ctx->channelR, compare); // SPINDLE_PWM_R
 	}
+	taskEXIT_CRITICAL();
+}
 
-	// da context und h nicht verwendet werden
-	(void)context;
+void SPINDLE_SetDutyCycle(SpindleHandle_t h, void* context, float dutyCycle){
+	//DUTY Cycle bestimmt Drehgeschwindigkeit vermutlich mit maxRPM* %Duty Cycle
+
+	SpindleContext_t* ctx = (SpindleContext_t*)context;
+	ctx->dutyCycle = dutyCycle;
+	Spindle_UpdateCompare(ctx);
+	TRACE_EVENT(TRACE_SPINDLE_DUTY, (int32_t)(dutyCycle * 1000.0f));
+
+	// da h nicht verwendet wird
 	(void)h;
 }
 
+// wird aus dem IRQ Handler des Timers (TIM2_IRQHandler in stm32f7xx_it.c) am Ende jeder PWM Periode aufgerufen,
+// solange gedithert wird. Sigma-Delta erster Ordnung: im Mittel ergibt sich compare + fraction / 65536 Zaehlschritte.
+// Der Compare Wert ist gepuffert (Preload), er gilt also ab der naechsten Periode
+void Spindle_PWMUpdateISR(TIM_TypeDef* timer)
+{
+	for (unsigned int i = 0; i < SPINDLE_COUNT; i++)
+	{
+		SpindleContext_t* ctx = &spindle_contexts[i];
+		if (ctx->timer->Instance != timer)
+		{
+			continue;
+		}
+
+		uint32_t accu = ctx->pwmAccu + ctx->pwmFraction;
+		uint32_t compare = ctx->pwmCompare + (accu >> SPINDLE_PWM_FRACTION_BITS);
+		ctx->pwmAccu = accu & SPINDLE_PWM_FRACTION_MASK;
+
+		if (ctx->direction == 1)
+		{
+			__HAL_TIM_SET_COMPARE(ctx->timer, ctx->channelL, compare);
+		}
+		else
+		{
+			__HAL_TIM_SET_COMPARE(ctx->timer, ctx->channelR, compare);
+		}
+	}
+}
+
+static uint32_t Spindle_TimerClock(void)
+{
+#ifdef WIN32
+	// die HAL Mockup kennt keine Taktkonfiguration, 90 MHz wie auf dem Board
+	return 90000000u;
+#else
+	// alle Spindel Timer haengen am APB1. Ist der Teiler nicht 1, laufen die Timer mit dem doppelten APB1 Takt
+	uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+	return ((RCC->CFGR & RCC_CFGR_PPRE1) == RCC_HCLK_DIV1) ? pclk1 : 2u * pclk1;
+#endif
+}
+
+// stellt PWM Frequenz und Dithering einer Spindel ein, auch waehrend sie dreht. Liefert 0 oder -1 bei ungueltiger Frequenz
+static int Spindle_ConfigureContextPWM(SpindleContext_t* ctx, uint32_t frequency_hz, int dither)
+{
+	if (frequency_hz < SPINDLE_PWM_MIN_HZ || frequency_hz > SPINDLE_PWM_MAX_HZ)
+	{
+		return -1;
+	}
+
+	uint32_t period = (Spindle_TimerClock() + frequency_hz / 2u) / frequency_hz;
+
+	taskENTER_CRITICAL();
+	ctx->pwmFrequency = frequency_hz;
+	ctx->pwmPeriod = period;
+	ctx->pwmDither = (dither != 0);
+	ctx->pwmAccu = 0;
+	__HAL_TIM_SET_PRESCALER(ctx->timer, 0);
+	__HAL_TIM_SET_AUTORELOAD(ctx->timer, period - 1u);
+	Spindle_UpdateCompare(ctx);
+	// das Update Event uebernimmt Periode und Compare Werte sofort und setzt den Zaehler zurueck, sonst koennte er
+	// ueber ein kleineres ARR hinaus bis zum 32 Bit Ueberlauf laufen
+	ctx->timer->Instance->EGR = TIM_EGR_UG;
+	taskEXIT_CRITICAL();
+	return 0;
+}
+
+// PWM der ersten Spindel
+int Spindle_ConfigurePWM(uint32_t frequency_hz, int dither)
+{
+	return Spindle_ConfigureContextPWM(&spindle_contexts[0], frequency_hz, dither);
+}
+
+// pwm [spindel]                      -> Frequenz, Aufloesung und Dithering ausgeben
+// pwm [spindel] <frequenz> [on|off]  -> Frequenz in Hz und optional Dithering einstellen
+// ohne Namen gilt der Befehl fuer die erste Spindel
+static int PWMCommand(int argc, char** argv, void* context)
+{
+	SpindleContext_t* ctx = &spindle_contexts[0];
+	(void)context;
+
+	for (unsigned int i = 0; argc > 0 && i < SPINDLE_COUNT; i++)
+	{
+		if (strcmp(argv[0], spindle_contexts[i].name) == 0)
+		{
+			ctx = &spindle_contexts[i];
+			argc--;
+			argv++;
+			break;
+		}
+	}
+
+	if (argc > 0)
+	{
+		int dither = ctx->pwmDither;
+		if (argc > 1)
+		{
+			dither = (strcmp(argv[1], "on") == 0);
+		}
+		if (Spindle_ConfigureContextPWM(ctx, (uint32_t)atoi(argv[0]), dither) != 0)
+		{
+			printf("invalid frequency, allowed are %u to %u Hz\r\nFAIL", SPINDLE_PWM_MIN_HZ, SPINDLE_PWM_MAX_HZ);
+			return -1;
+		}
+	}
+
+	CONSOLE_Printf("%s: %lu Hz, %lu steps (%.1f bit), dither %s\r\nOK", ctx->name, (unsigned long)ctx->pwmFrequency,
+			(unsigned long)ctx->pwmPeriod, log2f((float)ctx->pwmPeriod), ctx->pwmDither ? "on" : "off");
+	return 0;
+}
+
 void SPINDLE_EnaPWM(SpindleHandle_t h, void* context, int ena){
 	//Switch PWM on or off -> Switch Spindle on or off
+	SpindleContext_t* ctx = (SpindleContext_t*)context;
 
 	// check if enabling PWM-Signal is successful
 	// uint8_t error_occurred1 = 0;
 	// uint8_t error_occurred2 = 0;
 
-	// die GPIO-Pins benutzen den Timer 2, Channel 3 und 4 -> siehe main.c: htim2 für TIM_HandleTypeDef
+	// die GPIO-Pins der ersten Spindel benutzen den Timer 2, Channel 3 und 4 -> siehe main.c: htim2 für TIM_HandleTypeDef
 	// die HAL-Makros für die Channel in Drivers->...HAL_Driver->Inc->...hal_tim.h gefunden
-	// Periodendauer htim2: 4499
+	// Periodendauer: ctx->pwmPeriod, siehe Spindle_ConfigureContextPWM
 
 	//ena = value that sets enable or disable state (=1 enabled, =0 disabled)
 	if (ena == 1)
@@ -77,9 +321,9 @@ void SPINDLE_EnaPWM(SpindleHandle_t h, void* context, int ena){
 		// der Wert der bei compare angegeben wird ist der Wert ab dem der PWM-Ausgang auf High geht
 		// der Duty-Cycle (in Prozent als Dezimalzahl) ergibt sich dadurch durch Capture-Compare-Wert / Periodendauer
 		// error_occurred1 = (int) HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_3);
-		HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_3);
+		HAL_TIM_PWM_Start(ctx->timer, ctx->channelL);
 		// error_occurred2 = (int) HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_4);
-		HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_4);
+		HAL_TIM_PWM_Start(ctx->timer, ctx->channelR);
 		// HAL_TIM_PWM_Start returns enum ("HAL_StatusTypeDef") with value 0 (=no error), 1, 2 or 3 (=error)
 		// -> stm32f7xx_hal_def.h lign 38
 		/*
@@ -93,39 +337,357 @@ void SPINDLE_EnaPWM(SpindleHandle_t h, void* context, int ena){
 
 		// C-Makros fuer die Pins -> siehe main.h
 		// enable H-Bruecke
-		HAL_GPIO_WritePin(SPINDLE_ENA_L_GPIO_Port, SPINDLE_ENA_L_Pin, ena);
-		HAL_GPIO_WritePin(SPINDLE_ENA_R_GPIO_Port, SPINDLE_ENA_R_Pin, ena);
+		HAL_GPIO_WritePin(ctx->enaLPort, ctx->enaLPin, ena);
+		HAL_GPIO_WritePin(ctx->enaRPort, ctx->enaRPin, ena);
+		ctx->enabled = 1;
 	}
 
 	if (ena == 0)
 	{
-		HAL_TIM_PWM_Stop(&htim2, TIM_CHANNEL_3);
-		HAL_TIM_PWM_Stop(&htim2, TIM_CHANNEL_4);
+		HAL_TIM_PWM_Stop(ctx->timer, ctx->channelL);
+		HAL_TIM_PWM_Stop(ctx->timer, ctx->channelR);
 
 		// disable H-Bruecke:
-		HAL_GPIO_WritePin(SPINDLE_ENA_L_GPIO_Port, SPINDLE_ENA_L_Pin, ena);
-		HAL_GPIO_WritePin(SPINDLE_ENA_R_GPIO_Port, SPINDLE_ENA_R_Pin, ena);
+		HAL_GPIO_WritePin(ctx->enaLPort, ctx->enaLPin, ena);
+		HAL_GPIO_WritePin(ctx->enaRPort, ctx->enaRPin, ena);
+		ctx->enabled = 0;
 	}
 
-	// da context und h nicht verwendet werden
-	(void)context;
+	// solange eine Spindel laeuft, bleibt der Tick an (siehe my_power.c)
+	int anyEnabled = 0;
+	for (unsigned int i = 0; i < SPINDLE_COUNT; i++)
+	{
+		anyEnabled |= spindle_contexts[i].enabled;
+	}
+	Power_SetBusy(POWER_BUSY_SPINDLE, anyEnabled);
+
+	// da h nicht verwendet wird
 	(void)h;
 }
 
-void Initialize_Spindle(ConsoleHandle_t c){
-	//Struct fuer spindel erstellen
-	SpindlePhysicalParams_t s;
-	//RPM-Werte zuweisen
-	s.maxRPM			=  9000.0f;
-	s.minRPM			= -9000.0f;
-	s.absMinRPM			=  1600.0f;
-	//function pointer an struct member uebergeben
-	s.setDirection		= SPINDLE_SetDirection;
-	s.setDutyCycle		= SPINDLE_SetDutyCycle;
-	s.enaPWM			= SPINDLE_EnaPWM;
-	s.context			= NULL;
-	SpindleHandle_t spindle_Handle = SPINDLE_CreateInstance( 4*configMINIMAL_STACK_SIZE, configMAX_PRIORITIES - 3, c, &s);
+// liefert die zuletzt gemessene Drehzahl der ersten Spindel aus dem Snapshot der Spindel Task, ohne sie zu fragen
+// oder zu blockieren. Solange es noch keine Instanz gibt, wird sie aus dem Duty Cycle und der Richtung berechnet
+float Spindle_GetCachedRPM(void)
+{
+	SpindleContext_t* ctx = &spindle_contexts[0];
+	SpindleSnapshot_t snapshot;
+	if (ctx->handle != NULL && SPINDLE_GetSnapshot(ctx->handle, &snapshot) == 0)
+	{
+		return snapshot.running ? snapshot.measured : 0.0f;
+	}
+
+	if (ctx->enabled == 0)
+	{
+		return 0.0f;
+	}
+
+	float rpm = ctx->dutyCycle * ctx->maxRPM;
+	return (ctx->direction == 1) ? -rpm : rpm;
 }
 
+// wird aus dem EXTI IRQ Handler (EXTI0_IRQHandler in stm32f7xx_it.c) mit dem ausgeloesten Pin aufgerufen,
+// summiert nur die Periodendauern auf
+void Spindle_TachoEdgeISR(uint16_t pin)
+{
+	uint32_t now = DWT->CYCCNT;
+	for (unsigned int i = 0; i < SPINDLE_COUNT; i++)
+	{
+		SpindleContext_t* ctx = &spindle_contexts[i];
+		if (ctx->tachoPin != pin)
+		{
+			continue;
+		}
 
+		if (ctx->tachoValid)
+		{
+			ctx->tachoLastPeriod = now - ctx->tachoLastEdge;
+			ctx->tachoSumCycles += ctx->tachoLastPeriod;
+			ctx->tachoEdges++;
+		}
+		else
+		{
+			ctx->tachoLastPeriod = 0;
+		}
+		ctx->tachoLastEdge = now;
+		ctx->tachoValid = 1;
+		ctx->tachoTotalEdges++;
+	}
+}
+
+// Umdrehungen der ersten Spindel seit dem Start: ganze Umdrehungen aus den Index Flanken an SPINDLE_SI_R und der Anteil seit der
+// letzten Flanke aus der Dauer der letzten Umdrehung. Der Anteil bleibt unter 1, bis die naechste Flanke kommt,
+// damit springt der ganzzahlige Teil genau mit der Index Flanke
+double Spindle_GetRevolutions(void)
+{
+#ifdef WIN32
+	// im Simulator wird die Drehzahl des Motormodells aufintegriert
+	static double revolutions = 0.0;
+	static TickType_t last = 0;
+	TickType_t now = xTaskGetTickCount();
+	if (last != 0)
+	{
+		revolutions += (double)fabsf(HAL_MOCKUP_GetSpindleRPM()) / 60.0 * (double)(now - last) / (double)configTICK_RATE_HZ;
+	}
+	last = now;
+	return revolutions;
+#else
+	SpindleContext_t* ctx = &spindle_contexts[0];
+	__disable_irq();
+	uint32_t edges = ctx->tachoTotalEdges;
+	uint32_t period = ctx->tachoLastPeriod;
+	uint32_t since_last = DWT->CYCCNT - ctx->tachoLastEdge;
+	__enable_irq();
+
+	double revolutions = (double)edges / SPINDLE_TACHO_PULSES_PER_REV;
+	if (period > 0)
+	{
+		float fraction = (float)since_last / (float)period;
+		if (fraction > 0.999f)
+		{
+			fraction = 0.999f;
+		}
+		revolutions += fraction / SPINDLE_TACHO_PULSES_PER_REV;
+	}
+	return revolutions;
+#endif
+}
+
+// Messfunktion fuer den Drehzahlregler der LibSpindle, mittelt ueber alle Flanken seit dem letzten Aufruf
+float SPINDLE_GetMeasuredRPM(SpindleHandle_t h, void* context)
+{
+	SpindleContext_t* ctx = (SpindleContext_t*)context;
+	(void)h;
+
+#ifdef WIN32
+	// im Simulator liefert das Motormodell der HAL Mockup die Drehzahl
+	ctx->tachoLastRPM = fabsf(HAL_MOCKUP_GetSpindleRPM());
+#else
+	__disable_irq();
+	uint32_t sum = ctx->tachoSumCycles;
+	uint32_t edges = ctx->tachoEdges;
+	uint32_t last = ctx->tachoLastEdge;
+	uint8_t valid = ctx->tachoValid;
+	ctx->tachoSumCycles = 0;
+	ctx->tachoEdges = 0;
+	__enable_irq();
+
+	uint32_t since_last = DWT->CYCCNT - last;
+	if (edges > 0 && sum > 0)
+	{
+		ctx->tachoLastRPM = (60.0f * (float)SystemCoreClock * (float)edges) / ((float)sum * SPINDLE_TACHO_PULSES_PER_REV);
+	}
+	else if (!valid || since_last > (SystemCoreClock / 1000u) * SPINDLE_TACHO_TIMEOUT_MS)
+	{
+		ctx->tachoLastRPM = 0.0f;
+		ctx->tachoValid = 0;
+	}
+	else if (since_last > 0)
+	{
+		// die Spindel wird langsamer: die Zeit seit der letzten Flanke begrenzt die Drehzahl nach oben
+		float bound = (60.0f * (float)SystemCoreClock) / ((float)since_last * SPINDLE_TACHO_PULSES_PER_REV);
+		if (bound < ctx->tachoLastRPM)
+		{
+			ctx->tachoLastRPM = bound;
+		}
+	}
+#endif
+	return ctx->tachoLastRPM;
+}
+
+static uint32_t Spindle_CalibrationChecksum(const SpindleCalibrationRecord_t* record)
+{
+	// einfache Pruefsumme ueber alle Worte vor der Pruefsumme, erkennt einen geloeschten oder halb geschriebenen Sektor
+	const uint32_t* words = (const uint32_t*)record;
+	uint32_t sum = 0x5A5A5A5Au;
+	for (uint32_t i = 0; i < offsetof(SpindleCalibrationRecord_t, checksum) / sizeof(uint32_t); i++)
+	{
+		sum = (sum << 1 | sum >> 31) ^ words[i];
+	}
+	return sum;
+}
+
+// wird beim Start der Spindel Task aufgerufen
+int SPINDLE_LoadCalibration(SpindleHandle_t h, void* context, SpindleCalibration_t* table)
+{
+	SpindleContext_t* ctx = (SpindleContext_t*)context;
+	(void)h;
+	SpindleCalibrationRecord_t record;
+
+#ifdef WIN32
+	FILE* f = fopen(ctx->calibrationFile, "rb");
+	if (f == NULL)
+	{
+		return -1;
+	}
+	size_t n = fread(&record, 1, sizeof(record), f);
+	fclose(f);
+	if (n != sizeof(record))
+	{
+		return -1;
+	}
+#else
+	memcpy(&record, (const void*)ctx->calibrationAddress, sizeof(record));
+#endif
 
+	if (record.magic != SPINDLE_CALIBRATION_MAGIC || record.checksum != Spindle_CalibrationChecksum(&record))
+	{
+		return -1;
+	}
+	*table = record.table;
+	return 0;
+}
+
+// wird von der Spindel Task nach einer Kalibrierung aufgerufen, die Spindel steht dabei. Das Loeschen des Sektors
+// haelt die CPU fuer etwa eine Sekunde an, weil der Code aus dem selben Flash laeuft: Interrupts, SysTick und der
+// USART Empfang stehen so lange. Waehrend einer Fahrt des Schrittmotors wird deshalb nicht gespeichert (-1, die
+// Tabelle gilt bis zum naechsten Start trotzdem), und fuer die Dauer des Loeschens wird jede neue Fahrt abgewiesen
+int SPINDLE_StoreCalibration(SpindleHandle_t h, void* context, const SpindleCalibration_t* table)
+{
+	SpindleContext_t* ctx = (SpindleContext_t*)context;
+	(void)h;
+	SpindleCalibrationRecord_t record;
+	memset(&record, 0, sizeof(record));
+	record.magic = SPINDLE_CALIBRATION_MAGIC;
+	record.table = *table;
+	record.checksum = Spindle_CalibrationChecksum(&record);
+
+#ifdef WIN32
+	FILE* f = fopen(ctx->calibrationFile, "wb");
+	if (f == NULL)
+	{
+		return -1;
+	}
+	size_t n = fwrite(&record, 1, sizeof(record), f);
+	fclose(f);
+	return (n == sizeof(record)) ? 0 : -1;
+#else
+	void* self = xTaskGetCurrentTaskHandle();
+	if (Motion_Acquire(self) != 0)
+	{
+		return -1;
+	}
+	// eine asynchrone Fahrt (move -a) hat keinen Besitzer, sie setzt nur POWER_BUSY_STEPPER
+	if (Power_IsBusy(POWER_BUSY_STEPPER))
+	{
+		Motion_Release(self);
+		return -1;
+	}
+
+	int result = 0;
+	uint32_t sectorError = 0;
+	FLASH_EraseInitTypeDef erase = {0};
+	erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+	erase.Sector = ctx->calibrationSector;
+	erase.NbSectors = 1;
+	erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+	HAL_FLASH_Unlock();
+	if (HAL_FLASHEx_Erase(&erase, &sectorError) != HAL_OK)
+	{
+		result = -1;
+		goto exit;
+	}
+
+	const uint32_t* words = (const uint32_t*)&record;
+	for (uint32_t i = 0; i < sizeof(record) / sizeof(uint32_t); i++)
+	{
+		if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, ctx->calibrationAddress + i * sizeof(uint32_t), words[i]) != HAL_OK)
+		{
+			result = -1;
+			goto exit;
+		}
+	}
+
+exit:
+	HAL_FLASH_Lock();
+	Motion_Release(self);
+	return result;
+#endif
+}
+
+static void Spindle_InitTacho(SpindleContext_t* ctx)
+{
+#ifndef WIN32
+	// Zyklenzaehler fuer die Zeitstempel aktivieren
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	// SPINDLE_SI_R ist in main.c als einfacher Eingang konfiguriert, hier wird der Interrupt aktiviert
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	GPIO_InitStruct.Pin = ctx->tachoPin;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	HAL_GPIO_Init(ctx->tachoPort, &GPIO_InitStruct);
+
+	// die ISR ruft keine FreeRTOS Funktionen auf
+	HAL_NVIC_SetPriority(ctx->tachoIRQ, 5, 0);
+	HAL_NVIC_EnableIRQ(ctx->tachoIRQ);
+#else
+	(void)ctx;
+#endif
+}
+
+static void Spindle_InitPWM(SpindleContext_t* ctx)
+{
+	Spindle_ConfigureContextPWM(ctx, SPINDLE_PWM_DEFAULT_HZ, 0);
+#ifndef WIN32
+	// der Update Interrupt fuer das Dithering ruft keine FreeRTOS Funktionen auf
+	IRQn_Type irq = (ctx->timer->Instance == TIM2) ? TIM2_IRQn : TIM5_IRQn;
+	HAL_NVIC_SetPriority(irq, 5, 0);
+	HAL_NVIC_EnableIRQ(irq);
+#endif
+}
+
+// Handles, Event Groups und die gemeinsame Task liegen statisch im RAM (siehe SPINDLE_CreateStatic)
+#define SPINDLE_STACK_DEPTH	(4*configMINIMAL_STACK_SIZE)
+static SpindleStaticBuffers_t spindle_buffers[SPINDLE_COUNT];
+static SpindleWorkerBuffers_t spindle_worker;
+static StackType_t spindle_stack[SPINDLE_STACK_DEPTH];
+
+void Initialize_Spindle(ConsoleHandle_t c){
+	CONSOLE_RegisterCommand(c, "pwm", "<<pwm>> [spindle] prints the spindle PWM frequency and resolution.\r\n"
+			"<<pwm>> [spindle] <Hz> [on|off] sets the frequency (1000 to 25000 Hz) and sigma-delta dithering", PWMCommand, NULL);
+
+	// alle Spindeln teilen sich eine Task der LibSpindle, Stack und Prioritaet gelten nur beim ersten Aufruf
+	spindle_worker.stack = spindle_stack;
+	for (unsigned int i = 0; i < SPINDLE_COUNT; i++)
+	{
+		SpindleContext_t* ctx = &spindle_contexts[i];
+		//Struct fuer spindel erstellen
+		SpindlePhysicalParams_t s;
+		//RPM-Werte zuweisen
+		s.maxRPM			=  ctx->maxRPM;
+		s.minRPM			= -ctx->maxRPM;
+		s.absMinRPM			=  1600.0f;
+		//function pointer an struct member uebergeben
+		s.setDirection		= SPINDLE_SetDirection;
+		s.setDutyCycle		= SPINDLE_SetDutyCycle;
+		s.enaPWM			= SPINDLE_EnaPWM;
+		s.context			= ctx;
+		s.name				= ctx->name;
+		//Drehzahlregelung ueber die Messung an SPINDLE_SI_R
+		s.getMeasuredRPM	= SPINDLE_GetMeasuredRPM;
+		s.kp				= 0.00005f;
+		s.ki				= 0.0002f;
+		s.controlPeriodMs	= 10;
+		//Rampe fuer Start, Stopp und Richtungswechsel, damit die Versorgung nicht einbricht
+		s.acceleration		= 3000.0f;
+		s.jerk				= 12000.0f;
+		//Kalibriertabelle (spindle calibrate) im Flash ablegen und beim Start laden
+		s.loadCalibration	= SPINDLE_LoadCalibration;
+		s.storeCalibration	= SPINDLE_StoreCalibration;
+		s.calibrationSettleMs = 1500;
+		Spindle_InitTacho(ctx);
+		Spindle_InitPWM(ctx);
+		spindle_buffers[i].worker = &spindle_worker;
+		ctx->handle = SPINDLE_CreateStatic( SPINDLE_STACK_DEPTH, configMAX_PRIORITIES - 3, c, &s, &spindle_buffers[i]);
+	}
+}
+
+// Handle der ersten Spindel fuer die C-Schnittstelle der LibSpindle (SPINDLE_Start, SPINDLE_Stop, ...),
+// NULL vor Initialize_Spindle
+SpindleHandle_t Spindle_GetHandle(void)
+{
+	return spindle_contexts[0].handle;
+}
@@ -0,0 +1,53 @@
+/*
+ * my_motion.c
+ *
+ *  Created on: Feb 2, 2026
+ *      Author: Basti
+ */
+#include "Stepper_implementation/my_motion.h"
+#include <stddef.h>
+#include <string.h>
+
+// wird von beiden Job Workern und der Konsole gelesen, deshalb nur atomar aendern
+static void* motionOwner = NULL;
+
+int Motion_IsMotionCommand(int argc, char** argv)
+{
+	if (argc == 0)
+	{
+		return 0;
+	}
+	return strcmp(argv[0], "move") == 0 || strcmp(argv[0], "reference") == 0 || strcmp(argv[0], "sync") == 0;
+}
+
+int Motion_Acquire(void* owner)
+{
+	void* expected = NULL;
+	if (owner == NULL)
+	{
+		return -1;
+	}
+	return __atomic_compare_exchange_n(&motionOwner, &expected, owner, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ? 0 : -1;
+}
+
+void Motion_Release(void* owner)
+{
+	void* expected = owner;
+	__atomic_compare_exchange_n(&motionOwner, &expected, NULL, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+void* Motion_GetOwner(void)
+{
+	return __atomic_load_n(&motionOwner, __ATOMIC_ACQUIRE);
+}
+
+int Motion_IsAllowed(int argc, char** argv, void* caller)
+{
+	if (argc > 0 && (strcmp(argv[0], "status") == 0 || strcmp(argv[0], "cancel") == 0))
+	{
+		return 1;
+	}
+
+	void* owner = Motion_GetOwner();
+	return owner == NULL || owner == caller;
+}
@@ -0,0 +1,65 @@
+/*
+ * my_rate.c
+ *
+ *  Created on: Feb 3, 2026
+ *      Author: Basti
+ */
+#include "Stepper_implementation/my_rate.h"
+
+uint32_t Rate_Prescaler(float min_steps_per_sec)
+{
+	if (min_steps_per_sec <= 0.0f)
+	{
+		return 65535u;
+	}
+	float divider = RATE_TIMER_CLOCK_HZ / (65536.0f * min_steps_per_sec);
+	return (divider < 65535.0f) ? (uint32_t)divider : 65535u;
+}
+
+int Rate_Reload(float steps_per_sec, uint32_t prescaler, uint32_t* arr)
+{
+	float reload = RATE_TIMER_CLOCK_HZ / ((float)(prescaler + 1) * steps_per_sec) - 1.0f;
+	int result = 0;
+	if (reload < 1.0f)
+	{
+		reload = 1.0f;
+		result = -1;
+	}
+	if (reload > 65535.0f)
+	{
+		reload = 65535.0f;
+		result = -1;
+	}
+	*arr = (uint32_t)reload;
+	if (prescaler > 0 && *arr < RATE_ARR_MIN)
+	{
+		result = -1;
+	}
+	return result;
+}
+
+float Rate_Achieved(uint32_t prescaler, uint32_t arr)
+{
+	return RATE_TIMER_CLOCK_HZ / ((float)(prescaler + 1) * (float)(arr + 1));
+}
+
+int Rate_Track(float steps_per_sec, uint32_t* prescaler, uint32_t* arr)
+{
+	if (steps_per_sec <= 0.0f)
+	{
+		return -1;
+	}
+	if (Rate_Reload(steps_per_sec, *prescaler, arr) == 0)
+	{
+		return 0;
+	}
+
+	// die Rate ist aus dem Bereich des Prescalers gelaufen, z.B. weil die Spindel stark abbremst
+	uint32_t next = Rate_Prescaler(steps_per_sec * RATE_RANGE_FACTOR);
+	if (Rate_Reload(steps_per_sec, next, arr) != 0)
+	{
+		return -1;
+	}
+	*prescaler = next;
+	return 1;
+}
@@ -5,6 +5,12 @@
  *      Author: Basti
  */
 #include "Stepper_implementation/my_stepper.h"
+#include "Stepper_implementation/my_rate.h"
+#include "Memory_implementation/my_pool.h"
+#include "Runtime_implementation/my_isrstat.h"
+#include "Runtime_implementation/my_trace.h"
+#include "Runtime_implementation/my_power.h"
+#include "Log_implementation/my_log.h"
 #include "Controller.h"
 #include "LibL6474.h"
 #include "LibL6474Config.h"
@@ -17,6 +23,7 @@
 #include <stdbool.h>
 #include <math.h> // wichtig für fabsf Funktion
 #include <task.h> // wichtig für vTaskDelay() !!!
+#include <timers.h>
 #include "stm32f7xx_hal_gpio.h"
 
 L6474_Handle_t stepperHandle;
@@ -30,6 +37,20 @@ extern TIM_HandleTypeDef htim4;
 extern L6474_BaseParameter_t base_parameter;
 extern int blueLedBlinking;
 
+// zwischengespeicherter Zustand des Steppers, damit z.B. die Telemetrie ohne SPI Zugriff lesen kann.
+// Waehrend einer Fahrt ergibt sich die Position aus der Startposition und den schon ausgegebenen Pulsen
+static volatile int cachedPositionBase = 0;
+static volatile int cachedDirection = 0; // +1 oder -1 waehrend einer Fahrt, 0 im Stillstand
+static volatile unsigned int cachedPulses = 0;
+static volatile float cachedStepsPerSec = 0.0f;
+static volatile unsigned int cachedStatusBits = 0;
+
+// die blaue LED blinkt ueber einen Software Timer, ohne Blinken weckt sie die CPU nicht mehr auf
+#define LED_BLINK_MS	500
+static StaticTimer_t ledTimerBuffer;
+static TimerHandle_t ledTimer = NULL;
+static void LedBlinkTimer(TimerHandle_t timer);
+
 void Initialize_Stepper(void)
 {
 
@@ -55,8 +76,17 @@ void Initialize_Stepper(void)
 	p.cancelStep = StepTimerCancelAsync;
 
 
+	// Timer der blauen LED, wird erst mit Stepper_SetLedBlinking(1) gestartet
+	ledTimer = xTimerCreateStatic("led", pdMS_TO_TICKS(LED_BLINK_MS), pdTRUE, NULL, LedBlinkTimer, &ledTimerBuffer);
+	if (ledTimer == NULL)
+	{
+		printf("error at creating led timer in my_stepper.c\n");
+	}
+
 	// create the handle
-	stepperHandle = L6474_CreateInstance(&p, NULL, NULL, NULL);
+	// der Handle liegt statisch im RAM, die Bibliothek braucht dann kein malloc mehr
+	static L6474_StaticHandle_t stepperStorage;
+	stepperHandle = L6474_CreateStatic(&p, NULL, NULL, NULL, &stepperStorage);
 	if (stepperHandle == NULL)
 	{
 		printf("error at creating instance in my_stepper.c\n");
@@ -73,13 +103,21 @@ void Initialize_Stepper(void)
 void* StepLibraryMalloc( unsigned int size )
 {
 	// size	number of bytes requested by the memory allocation request
+#if POOL_FOR_STEPPER
+	return Pool_Malloc(size);
+#else
 	return malloc(size);
+#endif
 }
 
 // from LibL6474 library documentation
 void StepLibraryFree( const void* const ptr )
 {
+#if POOL_FOR_STEPPER
+	Pool_Free((void*)ptr);
+#else
 	free((void*)ptr);
+#endif
 }
 
 // from LibL6474 library documentation (extended with own code)
@@ -132,17 +170,80 @@ void StepLibraryDelay(unsigned int ms)
 	vTaskDelay(ms);
 }
 
+// muss im kritischen Abschnitt oder im ISR aufgerufen werden, uebernimmt die bisher gefahrenen Pulse in die Startposition
+static void StepperFoldCachedPosition(void)
+{
+	if (cachedDirection != 0)
+	{
+		cachedPositionBase += cachedDirection * (int)(cachedPulses - asyncStepsRemaining);
+		cachedDirection = 0;
+	}
+}
+
+int Stepper_GetCachedPosition(void)
+{
+	taskENTER_CRITICAL();
+	int position = cachedPositionBase;
+	if (cachedDirection != 0)
+	{
+		position += cachedDirection * (int)(cachedPulses - asyncStepsRemaining);
+	}
+	taskEXIT_CRITICAL();
+	return position;
+}
+
+void Stepper_SetCachedPosition(int position)
+{
+	taskENTER_CRITICAL();
+	cachedPositionBase = position;
+	cachedDirection = 0;
+	taskEXIT_CRITICAL();
+}
+
+float Stepper_GetCachedSpeed(void)
+{
+	return (cachedDirection != 0) ? (cachedDirection * cachedStepsPerSec) : 0.0f;
+}
+
+unsigned int Stepper_GetCachedStatus(void)
+{
+	return cachedStatusBits;
+}
+
+void Stepper_SetCachedStatus(const L6474_Status_t* status)
+{
+	cachedStatusBits = (status->HIGHZ       ? STEPPER_STATUS_HIGHZ    : 0) |
+	                   (status->DIR         ? STEPPER_STATUS_DIR      : 0) |
+	                   (status->NOTPERF_CMD ? STEPPER_STATUS_NOTPERF  : 0) |
+	                   (status->WRONG_CMD   ? STEPPER_STATUS_WRONG    : 0) |
+	                   (status->UVLO        ? STEPPER_STATUS_UVLO     : 0) |
+	                   (status->TH_WARN     ? STEPPER_STATUS_TH_WARN  : 0) |
+	                   (status->TH_SD       ? STEPPER_STATUS_TH_SD    : 0) |
+	                   (status->OCD         ? STEPPER_STATUS_OCD      : 0) |
+	                   (status->ONGOING     ? STEPPER_STATUS_ONGOING  : 0);
+}
+
 int StepTimerAsync(void *pPWM, int dir, unsigned int numPulses, void(*doneClb)(L6474_Handle_t), L6474_Handle_t h)
 {
 	// da pPWM nicht genutzt wird -> keine Compiler-Warnungen
 	(void)pPWM;
 
+	taskENTER_CRITICAL();
+	StepperFoldCachedPosition();
+	cachedPulses = numPulses;
+	asyncStepsRemaining = numPulses;
+	cachedDirection = dir ? 1 : -1;
+	taskEXIT_CRITICAL();
+
 	// Richtung setzen
 	HAL_GPIO_WritePin(GPIOF, GPIO_PIN_13, dir ? GPIO_PIN_SET : GPIO_PIN_RESET);
 
-	asyncStepsRemaining = numPulses;
 	asyncStepperHandle = h;
 	asyncDoneCallback = doneClb;
+	// die Pause seit der letzten Fahrt nicht als Jitter der Schrittpulse zaehlen
+	ISRSTAT_RESTART(ISRSTAT_STEP);
+	TRACE_EVENT(TRACE_STEPPER_START, numPulses);
+	Power_SetBusy(POWER_BUSY_STEPPER, 1);
 	//Timer PWM Interrupt starten
 	HAL_TIM_PWM_Start_IT(&htim4, TIM_CHANNEL_4);
 
@@ -152,6 +253,12 @@ int StepTimerAsync(void *pPWM, int dir, unsigned int numPulses, void(*doneClb)(L
 int StepTimerCancelAsync(void *pPWM)
 {
 	HAL_TIM_PWM_Stop_IT(&htim4, TIM_CHANNEL_4);
+	TRACE_EVENT(TRACE_STEPPER_CANCEL, 0);
+	Power_SetBusy(POWER_BUSY_STEPPER, 0);
+
+	taskENTER_CRITICAL();
+	StepperFoldCachedPosition();
+	taskEXIT_CRITICAL();
 
 	// damit keine Compiler-Warnungen entstehen, da pPWM nicht genutzt wird:
 	(void)pPWM;
@@ -174,9 +281,41 @@ void SetStepperSpeed(float steps_per_sec)
     TIM4->ARR = arr;
     TIM4->CCR4 = arr / 2;
     TIM4->EGR = TIM_EGR_UG;
+    cachedStepsPerSec = 90000000.0f / ((prescaler + 1) * (arr + 1));
+
+    // laeuft vor jeder Fahrt, formatiert wird erst im Log Task
+    LOG(LOG_INFO, LOG_STEPPER, "Timer configured: PSC=%u, ARR=%u → %.2f steps/sec", prescaler, arr,
+        LOG_FLOAT(cachedStepsPerSec));
+}
+
+// fuer Fahrten mit veraenderlicher Rate (stepper sync): der Prescaler wird so gewaehlt, dass ARR bis zur kleinsten
+// Rate in 16 Bit passt. Danach aendert Stepper_UpdateRate meist nur ARR (Berechnung in my_rate.c)
+void Stepper_PrepareRate(float min_steps_per_sec)
+{
+	TIM4->PSC = Rate_Prescaler(min_steps_per_sec);
+	// ARR gepuffert, damit eine neue Rate erst mit dem naechsten Puls gilt und kein Puls verloren geht
+	TIM4->CR1 |= TIM_CR1_ARPE;
+	TIM4->EGR = TIM_EGR_UG;
+}
 
-    printf("Timer configured: PSC=%u, ARR=%u → %.2f steps/sec\r\n", prescaler, arr,
-           90000000.0f / ((prescaler + 1) * (arr + 1)));
+// ohne printf und ohne Suche, damit sie im Takt der Synchronisation aufgerufen werden kann. Verlaesst ARR seinen
+// Bereich, wird der Prescaler neu gewaehlt. PSC und ARR (ARPE) sind gepuffert und gelten beide erst mit dem
+// naechsten Puls, deshalb ohne Update Event. -1 wenn die Rate nicht erreichbar ist
+int Stepper_UpdateRate(float steps_per_sec)
+{
+	uint32_t prescaler = TIM4->PSC;
+	uint32_t arr = 0;
+	int result = Rate_Track(steps_per_sec, &prescaler, &arr);
+	if (result < 0)
+	{
+		return -1;
+	}
+
+	TIM4->PSC = prescaler;
+	TIM4->ARR = arr;
+	TIM4->CCR4 = arr / 2;
+	cachedStepsPerSec = Rate_Achieved(prescaler, arr);
+	return 0;
 }
 
 // findet die optimalen Timer Einstellungen, damit Schrittmotor vernünftig läuft
@@ -225,6 +364,10 @@ void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim)
         if (asyncStepsRemaining <= 1)
         {
             HAL_TIM_PWM_Stop_IT(&htim4, TIM_CHANNEL_4);
+            asyncStepsRemaining = 0;
+            StepperFoldCachedPosition();
+            TRACE_EVENT(TRACE_STEPPER_DONE, 0);
+            Power_SetBusy(POWER_BUSY_STEPPER, 0);
             if (asyncDoneCallback && asyncStepperHandle)
             {
                 asyncDoneCallback(asyncStepperHandle);
@@ -242,7 +385,10 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 	{
 		//Limit-Schalter pruefen und ob der Schrittmotor sich nach rechts bewegt
 		HAL_TIM_PWM_Stop_IT(&htim4, TIM_CHANNEL_4);
-		printf("FAIL: Async movement stopped due to limit switch\r\n");
+		// die bis zum Schalter gefahrenen Pulse bleiben in der Position, wie beim Ende und beim Abbruch
+		StepperFoldCachedPosition();
+		Power_SetBusy(POWER_BUSY_STEPPER, 0);
+		LOG(LOG_ERROR, LOG_STEPPER, "FAIL: Async movement stopped due to limit switch");
 	}
 	return;
 }
@@ -259,28 +405,29 @@ int EnableStepperDrivers(void)
         HAL_GPIO_WritePin(LED_RED_GPIO_Port, LED_RED_Pin, GPIO_PIN_SET);
         HAL_GPIO_WritePin(LED_GREEN_GPIO_Port, LED_GREEN_Pin, GPIO_PIN_RESET);
         // for debugging
-        printf("blueLedBlinking disabled1\n");
-        blueLedBlinking = 0;
+        LOG(LOG_DEBUG, LOG_STEPPER, "blueLedBlinking disabled1");
+        Stepper_SetLedBlinking(0);
         return -1; // Fehler
     }
+    Stepper_SetCachedStatus(&status);
 
     // Prüfen, ob Treiber im High-Z (AUS) sind
     if (status.HIGHZ)
     {
-        printf("Enabling power outputs...\r\n");
+        LOG(LOG_INFO, LOG_STEPPER, "Enabling power outputs...");
         if (L6474_SetPowerOutputs(stepperHandle, 1) != errcNONE)
         {
             // LED FEHLER
             HAL_GPIO_WritePin(LED_RED_GPIO_Port, LED_RED_Pin, GPIO_PIN_SET);
             HAL_GPIO_WritePin(LED_GREEN_GPIO_Port, LED_GREEN_Pin, GPIO_PIN_RESET);
             // for debugging
-            printf("blueLedBlinking disabled1\n");
-            blueLedBlinking = 0;
+            LOG(LOG_DEBUG, LOG_STEPPER, "blueLedBlinking disabled1");
+            Stepper_SetLedBlinking(0);
             return -1; // Fehler
         }
 
         // LED AKTIV (Grün AN, Blau blinkt)
-        blueLedBlinking = 1;
+        Stepper_SetLedBlinking(1);
         // for debugging
         // printf("blueLedBlinking enabled\n");
         HAL_GPIO_WritePin(LED_GREEN_GPIO_Port, LED_GREEN_Pin, GPIO_PIN_SET);
@@ -291,27 +438,42 @@ int EnableStepperDrivers(void)
 }
 
 
-// Task fuer die blaue LED
-void vLedBlinkTask(void* pvParameters)
+// Timer fuer die blaue LED, laeuft im Timer Task
+static void LedBlinkTimer(TimerHandle_t timer)
 {
-	// da pvParameters nicht genutzt wird: -> somit keine Compiler-Warnungen
-	(void)pvParameters;
+	(void)timer;
 
-	while (1)
+	// Blaue LED 1Hz blinken (500ms an, 500ms aus), ein schon angestossenes Stoppen schaltet sie aus
+	if (blueLedBlinking)
+	{
+		HAL_GPIO_TogglePin(LED_BLUE_GPIO_Port, LED_BLUE_Pin);
+	}
+	else
+	{
+		HAL_GPIO_WritePin(LED_BLUE_GPIO_Port, LED_BLUE_Pin, GPIO_PIN_RESET);
+	}
+}
+
+// ersetzt den frueheren LED Task, der auch ohne Blinken alle 100 ms aufgewacht ist
+void Stepper_SetLedBlinking(int on)
+{
+	blueLedBlinking = on;
+	if (ledTimer == NULL)
+	{
+		return;
+	}
+
+	if (on)
+	{
+		if (xTimerIsTimerActive(ledTimer) == pdFALSE)
+		{
+			xTimerStart(ledTimer, 0);
+		}
+	}
+	else
 	{
-	  if (blueLedBlinking)
-	  {
-		  // Blaue LED 1Hz blinken (500ms an, 500ms aus)
-		  HAL_GPIO_TogglePin(LED_BLUE_GPIO_Port, LED_BLUE_Pin);
-		  vTaskDelay(pdMS_TO_TICKS(500));
-	  }
-
-	  else
-	  {
-		  // Wenn Blinken deaktiviert ist, LED ausschalten und kurz warten
-		  HAL_GPIO_WritePin(LED_BLUE_GPIO_Port, LED_BLUE_Pin, GPIO_PIN_RESET);
-		  vTaskDelay(pdMS_TO_TICKS(100)); // Poll-Intervall
-	  }
+		xTimerStop(ledTimer, 0);
+		HAL_GPIO_WritePin(LED_BLUE_GPIO_Port, LED_BLUE_Pin, GPIO_PIN_RESET);
 	}
 }
 int check_abs(L6474_Handle_t t, int mm_to_move)
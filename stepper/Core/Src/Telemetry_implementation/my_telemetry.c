@@ -0,0 +1,295 @@
+/*
+ * my_telemetry.c
+ *
+ *  Created on: Jan 12, 2026
+ *      Author: Basti
+ */
+#include "Telemetry_implementation/my_telemetry.h"
+#include "Stepper_implementation/my_stepper.h"
+#include "Spindle_implementation/my_spindle.h"
+#include "Console.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSConfig.h"
+#include <task.h>
+#include <queue.h>
+#include <timers.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Anzahl der Samples, die zwischen Abtastung und Ausgabe gepuffert werden. Ist der Puffer voll, weil die
+// Schnittstelle nicht hinterher kommt, wird das Sample verworfen und gezaehlt
+#define TELEMETRY_QUEUE_LENGTH  32
+// die Ausgabe wird gesammelt und mit einem einzigen Schreibaufruf ausgegeben
+#define TELEMETRY_BUFFER_SIZE   512
+#define TELEMETRY_RECORD_MAX    96
+#define TELEMETRY_STACK_DEPTH   configMINIMAL_STACK_SIZE
+
+typedef struct
+{
+	TickType_t   tick;
+	unsigned int signals;
+	int          position;
+	int          speed;
+	unsigned int status;
+	int          rpm;
+	unsigned int heap;
+	unsigned int cpu; // Last in Promille
+} TelemetryRecord_t;
+
+static QueueHandle_t telemetryQueue = NULL;
+static TimerHandle_t telemetryTimer = NULL;
+static volatile unsigned int telemetrySignals = 0;
+static volatile unsigned int telemetryRate = 0;
+static volatile unsigned int telemetryDropped = 0;
+// Instanz der Konsole, auf der watch zuletzt aufgerufen wurde, die Records gehen an deren Ausgabe
+static ConsoleHandle_t volatile telemetryConsole = NULL;
+
+// Queue, Timer und Task liegen statisch im RAM, damit der Verbrauch schon nach dem Linken feststeht
+static StaticQueue_t telemetryQueueBuffer;
+static uint8_t       telemetryQueueStorage[TELEMETRY_QUEUE_LENGTH * sizeof(TelemetryRecord_t)];
+static StaticTimer_t telemetryTimerBuffer;
+static StaticTask_t  telemetryTaskBuffer;
+static StackType_t   telemetryTaskStack[TELEMETRY_STACK_DEPTH];
+
+static const struct
+{
+	const char*  name;
+	unsigned int mask;
+} telemetryNames[] =
+{
+	{ "pos",    TELEMETRY_POSITION },
+	{ "speed",  TELEMETRY_SPEED    },
+	{ "status", TELEMETRY_STATUS   },
+	{ "rpm",    TELEMETRY_RPM      },
+	{ "heap",   TELEMETRY_HEAP     },
+	{ "cpu",    TELEMETRY_CPU      },
+	{ "all",    TELEMETRY_ALL      },
+};
+
+// laeuft im Timer Task, liest nur zwischengespeicherte Werte (kein SPI, keine Anfrage an die Spindel Task)
+static void TelemetrySample(TimerHandle_t timer)
+{
+	static configRUN_TIME_COUNTER_TYPE lastIdle = 0;
+	static configRUN_TIME_COUNTER_TYPE lastTotal = 0;
+	(void)timer;
+
+	TelemetryRecord_t rec;
+	rec.tick     = xTaskGetTickCount();
+	rec.signals  = telemetrySignals;
+	rec.position = Stepper_GetCachedPosition();
+	rec.speed    = (int)Stepper_GetCachedSpeed();
+	rec.status   = Stepper_GetCachedStatus();
+	rec.rpm      = (int)Spindle_GetCachedRPM();
+	rec.heap     = (unsigned int)xPortGetFreeHeapSize();
+
+	configRUN_TIME_COUNTER_TYPE idle  = ulTaskGetIdleRunTimeCounter();
+	configRUN_TIME_COUNTER_TYPE total = portGET_RUN_TIME_COUNTER_VALUE();
+	configRUN_TIME_COUNTER_TYPE deltaTotal = total - lastTotal;
+	configRUN_TIME_COUNTER_TYPE deltaIdle  = idle - lastIdle;
+	rec.cpu = (deltaTotal > 0 && deltaIdle <= deltaTotal) ? (unsigned int)(1000 - (deltaIdle * 1000) / deltaTotal) : 0;
+	lastIdle  = idle;
+	lastTotal = total;
+
+	if (xQueueSend(telemetryQueue, &rec, 0) != pdPASS)
+	{
+		telemetryDropped++;
+	}
+}
+
+static int TelemetryFormat(char* buffer, int size, const TelemetryRecord_t* rec)
+{
+	int len = CONSOLE_Snprintf(buffer, size, "#W,%lu", (unsigned long)rec->tick);
+	if (rec->signals & TELEMETRY_POSITION) len += CONSOLE_Snprintf(&buffer[len], size - len, ",%d", rec->position);
+	if (rec->signals & TELEMETRY_SPEED)    len += CONSOLE_Snprintf(&buffer[len], size - len, ",%d", rec->speed);
+	if (rec->signals & TELEMETRY_STATUS)   len += CONSOLE_Snprintf(&buffer[len], size - len, ",%03x", rec->status);
+	if (rec->signals & TELEMETRY_RPM)      len += CONSOLE_Snprintf(&buffer[len], size - len, ",%d", rec->rpm);
+	if (rec->signals & TELEMETRY_HEAP)     len += CONSOLE_Snprintf(&buffer[len], size - len, ",%u", rec->heap);
+	if (rec->signals & TELEMETRY_CPU)      len += CONSOLE_Snprintf(&buffer[len], size - len, ",%u", rec->cpu);
+	len += CONSOLE_Snprintf(&buffer[len], size - len, "\r\n");
+	return len;
+}
+
+// niedrige Prioritaet: formatiert alle anstehenden Samples in einen Puffer und gibt ihn auf einmal aus
+static void TelemetryTask(void* pvParameters)
+{
+	static char buffer[TELEMETRY_BUFFER_SIZE];
+	unsigned int reportedDropped = 0;
+	ConsoleHandle_t streamConsole = NULL;
+	FILE* stream = NULL;
+	(void)pvParameters;
+
+	while (1)
+	{
+		TelemetryRecord_t rec;
+		if (xQueueReceive(telemetryQueue, &rec, portMAX_DELAY) != pdPASS)
+		{
+			continue;
+		}
+
+		int len = 0;
+		do
+		{
+			len += TelemetryFormat(&buffer[len], sizeof(buffer) - len, &rec);
+		}
+		while ((len + TELEMETRY_RECORD_MAX) < (int)sizeof(buffer) && xQueueReceive(telemetryQueue, &rec, 0) == pdPASS);
+
+		unsigned int dropped = telemetryDropped;
+		if (dropped != reportedDropped)
+		{
+			len += CONSOLE_Snprintf(&buffer[len], sizeof(buffer) - len, "#D,%u\r\n", dropped - reportedDropped);
+			reportedDropped = dropped;
+		}
+
+		// eigenes Stream Objekt auf die Ausgabe der abonnierenden Instanz, auch wenn diese umgeleitet ist
+		ConsoleHandle_t console = telemetryConsole;
+		if (console != streamConsole)
+		{
+			if (stream != NULL)
+			{
+				fclose(stream);
+			}
+			stream = (console != NULL) ? CONSOLE_OpenWriteStream(console) : NULL;
+			streamConsole = console;
+		}
+
+		FILE* out = (stream != NULL) ? stream : stdout;
+		fwrite(buffer, 1, len, out);
+		fflush(out);
+	}
+}
+
+int Telemetry_Start(unsigned int signals, unsigned int rate_hz)
+{
+	if (telemetryTimer == NULL || signals == 0 || rate_hz < TELEMETRY_RATE_MIN || rate_hz > TELEMETRY_RATE_MAX)
+	{
+		return -1;
+	}
+
+	// der Timer zaehlt ganze Ticks: die Periode wird gerundet statt abgeschnitten und die daraus erreichte Rate
+	// gemeldet, z.B. 300 Hz -> 3 ms -> 333 Hz, 400 Hz -> 3 ms -> 333 Hz (abgeschnitten waeren es 2 ms und 500 Hz)
+	TickType_t period = (configTICK_RATE_HZ + rate_hz / 2) / rate_hz;
+	if (period == 0)
+	{
+		period = 1;
+	}
+	unsigned int achieved = (configTICK_RATE_HZ + period / 2) / period;
+
+	telemetrySignals = signals;
+	telemetryRate = achieved;
+	if (xTimerChangePeriod(telemetryTimer, period, pdMS_TO_TICKS(10)) != pdPASS)
+	{
+		telemetryRate = 0;
+		return -1;
+	}
+	return (int)achieved;
+}
+
+void Telemetry_Stop(void)
+{
+	if (telemetryTimer != NULL)
+	{
+		xTimerStop(telemetryTimer, pdMS_TO_TICKS(10));
+	}
+	telemetryRate = 0;
+}
+
+static void TelemetryPrintSignals(unsigned int signals)
+{
+	for (unsigned int i = 0; i < sizeof(telemetryNames) / sizeof(telemetryNames[0]); i++)
+	{
+		if (telemetryNames[i].mask != TELEMETRY_ALL && (signals & telemetryNames[i].mask))
+		{
+			printf(",%s", telemetryNames[i].name);
+		}
+	}
+}
+
+// watch                      -> aktuelles Abo und verworfene Samples ausgeben
+// watch stop                 -> Abo beenden
+// watch <rate> [signal ...]  -> Signale (pos, speed, status, rpm, heap, cpu, all) mit rate Hz abonnieren
+static int WatchCommand(int argc, char** argv, void* ctx)
+{
+	ConsoleHandle_t console = (ConsoleHandle_t)ctx;
+
+	if (argc == 0)
+	{
+		printf("rate %u Hz, dropped %u, signals tick", telemetryRate, telemetryDropped);
+		TelemetryPrintSignals(telemetrySignals);
+		printf("\r\nOK");
+		return 0;
+	}
+
+	if (strcmp(argv[0], "stop") == 0)
+	{
+		Telemetry_Stop();
+		printf("OK");
+		return 0;
+	}
+
+	int rate = atoi(argv[0]);
+	if (rate < TELEMETRY_RATE_MIN || rate > TELEMETRY_RATE_MAX)
+	{
+		printf("invalid rate, allowed are %d to %d Hz\r\nFAIL", TELEMETRY_RATE_MIN, TELEMETRY_RATE_MAX);
+		return -1;
+	}
+
+	unsigned int signals = (argc == 1) ? TELEMETRY_ALL : 0;
+	for (int i = 1; i < argc; i++)
+	{
+		unsigned int n = 0;
+		for (; n < sizeof(telemetryNames) / sizeof(telemetryNames[0]); n++)
+		{
+			if (strcmp(argv[i], telemetryNames[n].name) == 0)
+			{
+				signals |= telemetryNames[n].mask;
+				break;
+			}
+		}
+
+		if (n == sizeof(telemetryNames) / sizeof(telemetryNames[0]))
+		{
+			printf("unknown signal %s\r\nFAIL", argv[i]);
+			return -1;
+		}
+	}
+
+	telemetryConsole = console;
+	int achieved = Telemetry_Start(signals, rate);
+	if (achieved < 0)
+	{
+		printf("FAIL");
+		return -1;
+	}
+	if (achieved != rate)
+	{
+		printf("rate %d Hz is not a whole number of ticks, using %d Hz\r\n", rate, achieved);
+	}
+
+	// Kopfzeile, damit der Client die Spalten der folgenden Records zuordnen kann
+	printf("#H,tick");
+	TelemetryPrintSignals(signals);
+	printf("\r\nOK");
+	return 0;
+}
+
+void Telemetry_Init(ConsoleHandle_t c)
+{
+	telemetryQueue = xQueueCreateStatic(TELEMETRY_QUEUE_LENGTH, sizeof(TelemetryRecord_t), telemetryQueueStorage,
+			&telemetryQueueBuffer);
+	telemetryTimer = xTimerCreateStatic("telemetry", pdMS_TO_TICKS(100), pdTRUE, NULL, TelemetrySample,
+			&telemetryTimerBuffer);
+	if (telemetryQueue == NULL || telemetryTimer == NULL)
+	{
+		printf("error at creating telemetry in my_telemetry.c\n");
+		return;
+	}
+
+	xTaskCreateStatic(TelemetryTask, "telemetry", TELEMETRY_STACK_DEPTH, NULL, tskIDLE_PRIORITY + 1, telemetryTaskStack,
+			&telemetryTaskBuffer);
+
+	CONSOLE_RegisterCommand(c, "watch", "<<watch>> <rate> [pos|speed|status|rpm|heap|cpu|all ...] subscribes to telemetry\r\n"
+			"records with 1 to 500 Hz, rounded to a whole number of ms. <<watch stop>> ends the subscription, <<watch>>\r\n"
+			"prints it.", WatchCommand, c);
+	CONSOLE_RegisterSubcommand(c, "watch", "stop");
+}
@@ -29,7 +29,7 @@
 /* FreeRTOS headers */
 #include "FreeRTOS.h"
 #include "task.h"
-// #include "semphr.h"
+#include "semphr.h"
 
 #include "FreeRTOSConfig.h"
 #include "Spindle_implementation/my_spindle.h"
@@ -46,7 +46,10 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
-
+// Empfangspuffer der Konsole (Zweierpotenz), wird im USART3 Interrupt gefuellt
+#define STDIN_BUFFER_SIZE   256
+// laengstes Warten auf ein Zeichen, danach prueft die Konsole Abbruch und umgeleitete Streams
+#define STDIN_TIMEOUT_MS    1000
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -79,6 +82,12 @@ int blueLedBlinking = 0;
 // bool variable to show errors
 bool error_variable = false;
 
+// Ring der empfangenen Zeichen, Head schreibt nur der Interrupt, Tail nur der lesende Task
+static volatile uint8_t stdinBuffer[STDIN_BUFFER_SIZE];
+static volatile uint32_t stdinHead = 0;
+static volatile uint32_t stdinTail = 0;
+static SemaphoreHandle_t stdinSignal = NULL;
+
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -110,6 +119,31 @@ void vApplicationStackOverflowHook( TaskHandle_t pxTask, char *pcTaskName )
   __asm volatile( "bkpt #0" );
   for (;;) {;}
 }
+/*-----------------------------------------------------------*/
+
+// with configSUPPORT_STATIC_ALLOCATION the kernel asks for the memory of the idle and the timer task
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                    configSTACK_DEPTH_TYPE *puxIdleTaskStackSize )
+{
+  static StaticTask_t xIdleTaskTCB;
+  static StackType_t uxIdleTaskStack[ configMINIMAL_STACK_SIZE ];
+
+  *ppxIdleTaskTCBBuffer = &xIdleTaskTCB;
+  *ppxIdleTaskStackBuffer = uxIdleTaskStack;
+  *puxIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                     configSTACK_DEPTH_TYPE *puxTimerTaskStackSize )
+{
+  static StaticTask_t xTimerTaskTCB;
+  static StackType_t uxTimerTaskStack[ configTIMER_TASK_STACK_DEPTH ];
+
+  *ppxTimerTaskTCBBuffer = &xTimerTaskTCB;
+  *ppxTimerTaskStackBuffer = uxTimerTaskStack;
+  *puxTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
 
 /* USER CODE END PFP */
 
@@ -199,9 +233,14 @@ int main(void)
   L6474_SetBaseParameter(&base_parameter);
 
   initialise_stdlib_abstraction();
-  MyConsole_Init();
-  xTaskCreate(vLedBlinkTask, "LED_Task", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 4, NULL);
 
+  // die Konsole wartet blockierend auf den Empfangsinterrupt, statt getchar() zu pollen
+  static StaticSemaphore_t stdinSignalBuffer;
+  stdinSignal = xSemaphoreCreateBinaryStatic(&stdinSignalBuffer);
+  __HAL_UART_ENABLE_IT(&huart3, UART_IT_RXNE);
+
+  // die blaue LED blinkt ueber einen Software Timer (siehe Initialize_Stepper)
+  MyConsole_Init();
 
   // everything before scheduler
   vTaskStartScheduler();
@@ -696,8 +735,44 @@ int __stdin_get_char(void)
 	if (huart3.Instance->ISR & UART_FLAG_FE)
 		huart3.Instance->ICR = UART_CLEAR_FEF;
 
-	if ((huart3.Instance->ISR & UART_FLAG_RXNE) == 0) return -1;
-	return huart3.Instance->RDR;
+	if (stdinTail == stdinHead) return -1;
+	int c = stdinBuffer[stdinTail];
+	stdinTail = (stdinTail + 1) & (STDIN_BUFFER_SIZE - 1);
+	return c;
+}
+
+void __stdin_wait_char(void)
+{
+	// vor dem Start des Schedulers darf nicht blockiert werden
+	if (stdinTail != stdinHead || stdinSignal == NULL || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) return;
+	xSemaphoreTake(stdinSignal, pdMS_TO_TICKS(STDIN_TIMEOUT_MS));
+}
+
+// aus USART3_IRQHandler vor HAL_UART_IRQHandler, der HAL Treiber hat keinen Empfang gestartet und findet nichts mehr vor
+void __stdin_rx_isr(void)
+{
+	BaseType_t woken = pdFALSE;
+
+	if (huart3.Instance->ISR & (UART_FLAG_ORE | UART_FLAG_NE | UART_FLAG_FE))
+		huart3.Instance->ICR = UART_CLEAR_OREF | UART_CLEAR_NEF | UART_CLEAR_FEF;
+
+	while (huart3.Instance->ISR & UART_FLAG_RXNE)
+	{
+		uint8_t c = huart3.Instance->RDR;
+		uint32_t next = (stdinHead + 1) & (STDIN_BUFFER_SIZE - 1);
+		// bei vollem Puffer geht das Zeichen verloren, wie vorher bei einem Ueberlauf des Empfangsregisters
+		if (next != stdinTail)
+		{
+			stdinBuffer[stdinHead] = c;
+			stdinHead = next;
+		}
+	}
+
+	if (stdinSignal != NULL)
+	{
+		xSemaphoreGiveFromISR(stdinSignal, &woken);
+	}
+	portYIELD_FROM_ISR(woken);
 }
 
 /* USER CODE END 4 */
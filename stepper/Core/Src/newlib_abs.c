@@ -86,6 +86,8 @@
 #ifdef INC_FREERTOS_H
 #  include "task.h"
 #  include "semphr.h"
+#  include "Memory_implementation/my_pool.h"
+#  include "Memory_implementation/my_heap.h"
 #endif
 // ----------------------------------------------------------------------------
 
@@ -163,14 +165,24 @@ int _read( int file, char* ptr, int len );
  * the access to the hardware must be locked as well
  */
 // ----------------------------------------------------------------------------
+#if defined(INC_FREERTOS_H) && ( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define MV_SYSCALL_LOCK_BUFFER(b)   static StaticSemaphore_t b;
+#define MV_SYSCALL_CREATE_LOCK(b)   xSemaphoreCreateRecursiveMutexStatic(&b)
+#else
+#define MV_SYSCALL_LOCK_BUFFER(b)
+#define MV_SYSCALL_CREATE_LOCK(b)   xSemaphoreCreateRecursiveMutex()
+#endif
 #if defined(INC_FREERTOS_H) && defined(MV_SYSCALL_USE_EXCLUSIVE_LOCK_FOR_STDOUT)
 static SemaphoreHandle_t stdioSemaphore;
+MV_SYSCALL_LOCK_BUFFER(stdioSemaphoreBuffer)
 #endif
 #if defined(INC_FREERTOS_H) && defined(MV_SYSCALL_USE_EXCLUSIVE_LOCK_FOR_MALLOC)
 static SemaphoreHandle_t mallocSemaphore;
+MV_SYSCALL_LOCK_BUFFER(mallocSemaphoreBuffer)
 #endif
 #if defined(INC_FREERTOS_H) && defined(MV_SYSCALL_USE_EXCLUSIVE_LOCK_FOR_ENV)
 static SemaphoreHandle_t envSemaphore;
+MV_SYSCALL_LOCK_BUFFER(envSemaphoreBuffer)
 #endif
 #endif
 
@@ -217,6 +229,18 @@ __attribute__( ( weak ) ) int  __stdin_get_char( void )
 }
 // ----------------------------------------------------------------------------
 
+/*!
+ * \brief is called once per read before the first character is fetched and
+ * may block until input is available, so a reader does not have to poll
+ * \note __stdin_get_char must not block, it is called again for every
+ * further character of the same read
+ */
+// ----------------------------------------------------------------------------
+__attribute__( ( weak ) ) void __stdin_wait_char( void )
+{
+}
+// ----------------------------------------------------------------------------
+
 /*!
  * \brief is used to provide an overwritable clock tick function which is used
  * by the stdlib
@@ -260,7 +284,7 @@ void initialise_stdlib_abstraction( void )
     initialise_monitor_handles();
 
 #if defined(INC_FREERTOS_H) && defined(MV_SYSCALL_USE_EXCLUSIVE_LOCK_FOR_STDOUT)
-    stdioSemaphore = xSemaphoreCreateRecursiveMutex();
+    stdioSemaphore = MV_SYSCALL_CREATE_LOCK(stdioSemaphoreBuffer);
 
     if ( stdioSemaphore == 0 )
     {
@@ -268,7 +292,7 @@ void initialise_stdlib_abstraction( void )
     }
 #endif
 #if defined(INC_FREERTOS_H) && defined(MV_SYSCALL_USE_EXCLUSIVE_LOCK_FOR_MALLOC)
-    mallocSemaphore = xSemaphoreCreateRecursiveMutex();
+    mallocSemaphore = MV_SYSCALL_CREATE_LOCK(mallocSemaphoreBuffer);
 
     if ( mallocSemaphore == 0 )
     {
@@ -276,7 +300,7 @@ void initialise_stdlib_abstraction( void )
     }
 #endif
 #if defined(INC_FREERTOS_H) && defined(MV_SYSCALL_USE_EXCLUSIVE_LOCK_FOR_ENV)
-    envSemaphore = xSemaphoreCreateRecursiveMutex();
+    envSemaphore = MV_SYSCALL_CREATE_LOCK(envSemaphoreBuffer);
 
     if ( envSemaphore == 0 )
     {
@@ -352,6 +376,7 @@ int _read( int file, char* ptr, int len )
 
     if ( file == STDIN_FILENO )
     {
+        __stdin_wait_char();
         for ( DataIdx = 0; DataIdx < len; )
         {
             int result = __stdin_get_char();
@@ -820,11 +845,173 @@ __attribute__( ( weak ) ) void __env_unlock( void )
     DRN_EXIT_CRITICAL_SECTION( malLock_uxSavedInterruptStatus );
 }
 
+// ================================================================================================
+// Allocation tracker (heap command, see my_heap.c). The project links with
+// -Wl,--wrap=malloc,--wrap=free,--wrap=calloc,--wrap=realloc and the same for the reentrant
+// _malloc_r, _free_r, _calloc_r and _realloc_r, which newlib itself calls (stdio buffers, strdup).
+// So every allocation passes through here together with the address of its caller.
+// calloc and realloc are built on the wrapped malloc and free, because the newlib versions call
+// _malloc_r and _free_r internally, which would record the library instead of the caller.
+// ================================================================================================
+void* __real__malloc_r( struct _reent* r, size_t size );
+void  __real__free_r( struct _reent* r, void* ptr );
+
+// ----------------------------------------------------------------------------
+static inline void* TrackedMalloc( struct _reent* r, size_t size, void* caller )
+// ----------------------------------------------------------------------------
+{
+    void* ptr = __real__malloc_r( r, size );
+    if ( ptr != NULL )
+    {
+        Heap_TrackAlloc( ptr, size, caller );
+    }
+    return ptr;
+}
+
+// ----------------------------------------------------------------------------
+static inline void TrackedFree( struct _reent* r, void* ptr )
+// ----------------------------------------------------------------------------
+{
+    if ( ptr == NULL )
+    {
+        return;
+    }
+
+    // forget the block first, otherwise another task could get it from malloc in between
+    Heap_TrackFree( ptr );
+    __real__free_r( r, ptr );
+}
+
+// ----------------------------------------------------------------------------
+static inline void* TrackedCalloc( struct _reent* r, size_t num, size_t size, void* caller )
+// ----------------------------------------------------------------------------
+{
+    if ( size != 0 && num > ( ( size_t ) -1 ) / size )
+    {
+        r->_errno = ENOMEM;
+        return NULL;
+    }
+
+    void* ptr = TrackedMalloc( r, num * size, caller );
+    if ( ptr != NULL )
+    {
+        memset( ptr, 0, num * size );
+    }
+    return ptr;
+}
+
+// ----------------------------------------------------------------------------
+static inline void* TrackedRealloc( struct _reent* r, void* ptr, size_t size, void* caller )
+// ----------------------------------------------------------------------------
+{
+    if ( ptr == NULL )
+    {
+        return TrackedMalloc( r, size, caller );
+    }
+    if ( size == 0 )
+    {
+        TrackedFree( r, ptr );
+        return NULL;
+    }
+
+    // shrinking keeps the block, only the recorded size and caller change
+    size_t usable = _malloc_usable_size_r( r, ptr );
+    if ( size <= usable )
+    {
+        Heap_TrackFree( ptr );
+        Heap_TrackAlloc( ptr, size, caller );
+        return ptr;
+    }
+
+    void* grown = TrackedMalloc( r, size, caller );
+    if ( grown != NULL )
+    {
+        memcpy( grown, ptr, usable );
+        TrackedFree( r, ptr );
+    }
+    return grown;
+}
+
+void* __wrap_malloc( size_t size )
+{
+    return TrackedMalloc( _REENT, size, __builtin_return_address( 0 ) );
+}
+
+void __wrap_free( void* ptr )
+{
+    TrackedFree( _REENT, ptr );
+}
+
+void* __wrap_calloc( size_t num, size_t size )
+{
+    return TrackedCalloc( _REENT, num, size, __builtin_return_address( 0 ) );
+}
+
+void* __wrap_realloc( void* ptr, size_t size )
+{
+    return TrackedRealloc( _REENT, ptr, size, __builtin_return_address( 0 ) );
+}
+
+void* __wrap__malloc_r( struct _reent* r, size_t size )
+{
+    return TrackedMalloc( r, size, __builtin_return_address( 0 ) );
+}
+
+void __wrap__free_r( struct _reent* r, void* ptr )
+{
+    TrackedFree( r, ptr );
+}
+
+void* __wrap__calloc_r( struct _reent* r, size_t num, size_t size )
+{
+    return TrackedCalloc( r, num, size, __builtin_return_address( 0 ) );
+}
+
+void* __wrap__realloc_r( struct _reent* r, void* ptr, size_t size )
+{
+    return TrackedRealloc( r, ptr, size, __builtin_return_address( 0 ) );
+}
+
+/*!
+ * \brief visits every chunk in the free list of newlib-nano
+ * \param visit is called with the size of each free chunk including its header,
+ * it runs under __malloc_lock and must not allocate
+ * \return the bytes below the heap limit which were never handed out by sbrk
+ * \note the full newlib does not have this list, then only the sbrk rest is returned
+ */
+typedef struct NanoChunk
+{
+    long size;
+    struct NanoChunk* next;
+} NanoChunk_t;
+extern NanoChunk_t* __malloc_free_list __attribute__( ( weak ) );
+
+// ----------------------------------------------------------------------------
+size_t __malloc_walk_free( void ( *visit )( size_t size, void* ctx ), void* ctx )
+// ----------------------------------------------------------------------------
+{
+    __malloc_lock( _REENT );
+    if ( &__malloc_free_list != NULL )
+    {
+        for ( NanoChunk_t* chunk = __malloc_free_list; chunk != NULL; chunk = chunk->next )
+        {
+            visit( ( size_t )chunk->size, ctx );
+        }
+    }
+    size_t reserve = ( heapBytesRemaining > 0 ) ? ( size_t )heapBytesRemaining : 0;
+    __malloc_unlock( _REENT );
+    return reserve;
+}
+
 // ----------------------------------------------------------------------------
 void* pvPortMalloc( size_t xSize )
 // ----------------------------------------------------------------------------
 {
+#if POOL_FOR_RTOS
+    void* p = Pool_Malloc( xSize );
+#else
     void* p = malloc( xSize );
+#endif
     return p;
 }
 
@@ -832,7 +1019,11 @@ void* pvPortMalloc( size_t xSize )
 void vPortFree( void* pv )
 // ----------------------------------------------------------------------------
 {
+#if POOL_FOR_RTOS
+    Pool_Free( pv );
+#else
     free( pv );
+#endif
 }
 
 // ----------------------------------------------------------------------------
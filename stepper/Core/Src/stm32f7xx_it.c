@@ -22,6 +22,9 @@
 #include "stm32f7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "Spindle_implementation/my_spindle.h"
+#include "Runtime_implementation/my_runtime.h"
+#include "Runtime_implementation/my_isrstat.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -196,10 +199,12 @@ void SysTick_Handler(void)
 void SysTick_Handler(void)
 {
   extern void xPortSysTickHandler( void );
+  RUNTIME_ISR_ENTER();
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
   xPortSysTickHandler();
+  RUNTIME_ISR_EXIT();
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -216,11 +221,13 @@ void SysTick_Handler(void)
 void EXTI9_5_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI9_5_IRQn 0 */
-
+  RUNTIME_ISR_ENTER();
+  ISRSTAT_ENTER(ISRSTAT_LIMIT);
   /* USER CODE END EXTI9_5_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(LIMIT_SWITCH_Pin);
   /* USER CODE BEGIN EXTI9_5_IRQn 1 */
-
+  ISRSTAT_EXIT(ISRSTAT_LIMIT);
+  RUNTIME_ISR_EXIT();
   /* USER CODE END EXTI9_5_IRQn 1 */
 }
 
@@ -230,11 +237,11 @@ void EXTI9_5_IRQHandler(void)
 void TIM1_UP_TIM10_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM1_UP_TIM10_IRQn 0 */
-
+  RUNTIME_ISR_ENTER();
   /* USER CODE END TIM1_UP_TIM10_IRQn 0 */
   HAL_TIM_IRQHandler(&htim1);
   /* USER CODE BEGIN TIM1_UP_TIM10_IRQn 1 */
-
+  RUNTIME_ISR_EXIT();
   /* USER CODE END TIM1_UP_TIM10_IRQn 1 */
 }
 
@@ -244,11 +251,11 @@ void TIM1_UP_TIM10_IRQHandler(void)
 void TIM1_CC_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM1_CC_IRQn 0 */
-
+  RUNTIME_ISR_ENTER();
   /* USER CODE END TIM1_CC_IRQn 0 */
   HAL_TIM_IRQHandler(&htim1);
   /* USER CODE BEGIN TIM1_CC_IRQn 1 */
-
+  RUNTIME_ISR_EXIT();
   /* USER CODE END TIM1_CC_IRQn 1 */
 }
 
@@ -258,11 +265,13 @@ void TIM1_CC_IRQHandler(void)
 void TIM4_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM4_IRQn 0 */
-
+  RUNTIME_ISR_ENTER();
+  ISRSTAT_ENTER(ISRSTAT_STEP);
   /* USER CODE END TIM4_IRQn 0 */
   HAL_TIM_IRQHandler(&htim4);
   /* USER CODE BEGIN TIM4_IRQn 1 */
-
+  ISRSTAT_EXIT(ISRSTAT_STEP);
+  RUNTIME_ISR_EXIT();
   /* USER CODE END TIM4_IRQn 1 */
 }
 
@@ -272,11 +281,11 @@ void TIM4_IRQHandler(void)
 void SPI1_IRQHandler(void)
 {
   /* USER CODE BEGIN SPI1_IRQn 0 */
-
+  RUNTIME_ISR_ENTER();
   /* USER CODE END SPI1_IRQn 0 */
   HAL_SPI_IRQHandler(&hspi1);
   /* USER CODE BEGIN SPI1_IRQn 1 */
-
+  RUNTIME_ISR_EXIT();
   /* USER CODE END SPI1_IRQn 1 */
 }
 
@@ -286,14 +295,43 @@ void SPI1_IRQHandler(void)
 void USART3_IRQHandler(void)
 {
   /* USER CODE BEGIN USART3_IRQn 0 */
-
+  RUNTIME_ISR_ENTER();
+  __stdin_rx_isr();
   /* USER CODE END USART3_IRQn 0 */
   HAL_UART_IRQHandler(&huart3);
   /* USER CODE BEGIN USART3_IRQn 1 */
-
+  RUNTIME_ISR_EXIT();
   /* USER CODE END USART3_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles EXTI line0 interrupt (spindle tacho input SPINDLE_SI_R).
+  */
+void EXTI0_IRQHandler(void)
+{
+  RUNTIME_ISR_ENTER();
+  ISRSTAT_ENTER(ISRSTAT_TACHO);
+  __HAL_GPIO_EXTI_CLEAR_IT(SPINDLE_SI_R_Pin);
+  Spindle_TachoEdgeISR(SPINDLE_SI_R_Pin);
+  ISRSTAT_EXIT(ISRSTAT_TACHO);
+  RUNTIME_ISR_EXIT();
+}
+
+/**
+  * @brief This function handles TIM2 global interrupt (sigma-delta dithering of the spindle PWM).
+  */
+void TIM2_IRQHandler(void)
+{
+  RUNTIME_ISR_ENTER();
+  ISRSTAT_ENTER(ISRSTAT_PWM);
+  if (TIM2->SR & TIM_SR_UIF)
+  {
+    TIM2->SR = ~(uint32_t)TIM_SR_UIF;
+    Spindle_PWMUpdateISR(TIM2);
+  }
+  ISRSTAT_EXIT(ISRSTAT_PWM);
+  RUNTIME_ISR_EXIT();
+}
 
 /* USER CODE END 1 */
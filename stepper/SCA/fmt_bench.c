@@ -0,0 +1,126 @@
+/*
+ * fmt_bench.c
+ *
+ *  Created on: Jan 30, 2026
+ *      Author: Basti
+ *
+ * Host Werkzeug: vergleicht CONSOLE_Snprintf aus LibRTOSConsole mit snprintf der Host stdlib fuer die Formate, die
+ * die Befehle der Konsole und die Telemetrie tatsaechlich benutzen. Zuerst wird jede Ausgabe mit vielen Werten
+ * gegen snprintf geprueft, danach die Zeit je Aufruf gemessen.
+ *
+ *   make fmtbench
+ *   ./fmtbench
+ *
+ * Auf dem Host misst das nur das Verhaeltnis der beiden Implementierungen, auf dem Cortex-M7 kommt fuer printf
+ * noch die double Arithmetik in Software dazu.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "ConsoleFormat.h"
+
+#define LINE_SIZE       160
+#define CHECK_VALUES    200000
+#define BENCH_CALLS     500000
+
+// ein Format mit seinen Argumenten aus dem Zaehler i, einmal fuer jede der beiden Implementierungen
+#define CASE_POSITION(fn, b, i)   fn(b, LINE_SIZE, "OK, Current absolute position: %d steps = %.2f mm\r\n", \
+		(int)(i) - 40000, ((int)(i) - 40000) * 0.0125f)
+#define CASE_TOP(fn, b, i)        fn(b, LINE_SIZE, "| %-16.16s | %5.1f |\r\n", "console", (float)((i) % 1000) * 0.1f)
+#define CASE_WATCH(fn, b, i)      fn(b, LINE_SIZE, "#W,%lu,%d,%d,%03x,%d,%u,%u\r\n", (unsigned long)(i), \
+		(int)(i) - 5000, (int)((i) % 3000), (unsigned int)((i) & 0x7FF), (int)((i) % 12000), \
+		(unsigned int)(i) * 7u, (unsigned int)((i) % 1000))
+#define CASE_SPINDLE(fn, b, i)    fn(b, LINE_SIZE, "%s: %lu Hz, %lu steps (%.1f bit), dither %s\r\nOK", "spindle", \
+		(unsigned long)(1000 + (i) % 50000), (unsigned long)(90000000u / (1000 + (i) % 50000)), \
+		(double)((i) % 170) * 0.1, ((i) & 1) ? "on" : "off")
+#define CASE_ISR(fn, b, i)        fn(b, LINE_SIZE, "%s: count %lu, max duration %lu (%.2f us), max jitter %lu (%.2f us)\r\n", \
+		"TIM4", (unsigned long)(i), (unsigned long)((i) % 9000), (double)((i) % 9000) / 216.0, \
+		(unsigned long)((i) % 700), (double)((i) % 700) / 216.0)
+#define CASE_MOVE(fn, b, i)       fn(b, LINE_SIZE, "Moving %.2f mm at %.2f steps/sec (%d steps)", \
+		((int)(i) - 100000) * 0.001, (double)((i) % 20000) * 1.7, (int)(i) - 100000)
+
+typedef struct
+{
+	const char* name;
+	void (*run)(char* a, char* b, unsigned int i);
+} BenchCase_t;
+
+#define BENCH_RUN(caseMacro) \
+	static void Run_##caseMacro(char* a, char* b, unsigned int i) \
+	{ \
+		if (a != NULL) caseMacro(snprintf, a, i); \
+		if (b != NULL) caseMacro(CONSOLE_Snprintf, b, i); \
+	}
+
+BENCH_RUN(CASE_POSITION)
+BENCH_RUN(CASE_TOP)
+BENCH_RUN(CASE_WATCH)
+BENCH_RUN(CASE_SPINDLE)
+BENCH_RUN(CASE_ISR)
+BENCH_RUN(CASE_MOVE)
+
+static const BenchCase_t benchCases[] =
+{
+	{ "position", Run_CASE_POSITION },
+	{ "top",      Run_CASE_TOP },
+	{ "watch",    Run_CASE_WATCH },
+	{ "spindle",  Run_CASE_SPINDLE },
+	{ "isr",      Run_CASE_ISR },
+	{ "move",     Run_CASE_MOVE },
+};
+
+static double NowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// gleiche Ausgabe wie snprintf fuer alle Werte, sonst werden die ersten Abweichungen ausgegeben
+static unsigned int Check(const BenchCase_t* c)
+{
+	char expected[LINE_SIZE];
+	char actual[LINE_SIZE];
+	unsigned int errors = 0;
+
+	for (unsigned int i = 0; i < CHECK_VALUES; i++)
+	{
+		c->run(expected, actual, i);
+		if (strcmp(expected, actual) != 0 && errors++ < 3)
+		{
+			printf("  %s mismatch at %u:\n    snprintf: %s\n    console : %s\n", c->name, i, expected, actual);
+		}
+	}
+	return errors;
+}
+
+static double Measure(const BenchCase_t* c, int console)
+{
+	static char buffer[LINE_SIZE];
+	double start = NowNs();
+	for (unsigned int i = 0; i < BENCH_CALLS; i++)
+	{
+		c->run(console ? NULL : buffer, console ? buffer : NULL, i);
+	}
+	return (NowNs() - start) / BENCH_CALLS;
+}
+
+int main(void)
+{
+	unsigned int errors = 0;
+
+	printf("%-10s %12s %12s %8s %10s\n", "format", "snprintf ns", "console ns", "speedup", "mismatch");
+	for (unsigned int k = 0; k < sizeof(benchCases) / sizeof(benchCases[0]); k++)
+	{
+		const BenchCase_t* c = &benchCases[k];
+		unsigned int mismatch = Check(c);
+		double stdlib = Measure(c, 0);
+		double console = Measure(c, 1);
+		printf("%-10s %12.1f %12.1f %7.2fx %10u\n", c->name, stdlib, console, stdlib / console, mismatch);
+		errors += mismatch;
+	}
+	return (errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
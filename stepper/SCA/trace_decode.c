@@ -0,0 +1,272 @@
+/*
+ * trace_decode.c
+ *
+ *  Created on: Jan 26, 2026
+ *      Author: Basti
+ *
+ * Host Werkzeug: liest die Ausgabe von "trace dump" (auch mitten in einem Konsolen-Log) und schreibt den Ablauf
+ * als Chrome Trace JSON, das mit chrome://tracing oder https://ui.perfetto.dev angezeigt werden kann.
+ *
+ *   make tracedec
+ *   ./tracedec < console.log > trace.json
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// muss zu my_trace.h passen
+#define TRACE_TASK_IN           1
+#define TRACE_QUEUE_SEND        2
+#define TRACE_QUEUE_RECEIVE     3
+#define TRACE_SEM_GIVE          4
+#define TRACE_SEM_TAKE          5
+#define TRACE_ISR_ENTER         6
+#define TRACE_ISR_EXIT          7
+#define TRACE_STEPPER_START     16
+#define TRACE_STEPPER_DONE      17
+#define TRACE_STEPPER_CANCEL    18
+#define TRACE_SPINDLE_DUTY      19
+#define TRACE_SPINDLE_DIR       20
+#define TRACE_CONSOLE_BEGIN     21
+#define TRACE_CONSOLE_END       22
+
+#define RECORD_SIZE     12
+#define MAX_TASKS       256
+#define LINE_SIZE       1024
+// Interrupts laufen in einer eigenen Zeile des Ablaufs
+#define ISR_TID         1000
+
+static char taskNames[MAX_TASKS][32];
+static unsigned char* records = NULL;
+static unsigned int numRecords = 0;
+static unsigned int maxRecords = 0;
+static double cyclesPerUs = 216.0;
+static int firstEvent = 1;
+
+static int Base64Value(char c)
+{
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+
+// haengt die dekodierten Bytes einer #T,D Zeile an den Puffer an
+static int DecodeLine(const char* text)
+{
+	unsigned char bytes[LINE_SIZE];
+	unsigned int n = 0;
+	uint32_t bits = 0;
+	int count = 0;
+	for (const char* p = text; *p != 0 && *p != '\r' && *p != '\n'; p++)
+	{
+		if (*p == '=') break;
+		int v = Base64Value(*p);
+		if (v < 0) return -1;
+		bits = (bits << 6) | (uint32_t)v;
+		if (++count == 4)
+		{
+			bytes[n++] = (unsigned char)(bits >> 16);
+			bytes[n++] = (unsigned char)(bits >> 8);
+			bytes[n++] = (unsigned char)bits;
+			bits = 0;
+			count = 0;
+		}
+	}
+	if (count == 3)
+	{
+		bytes[n++] = (unsigned char)(bits >> 10);
+		bytes[n++] = (unsigned char)(bits >> 2);
+	}
+	else if (count == 2)
+	{
+		bytes[n++] = (unsigned char)(bits >> 4);
+	}
+
+	unsigned int add = n / RECORD_SIZE;
+	if (numRecords + add > maxRecords)
+	{
+		unsigned int newMax = (maxRecords == 0) ? 1024 : maxRecords * 2;
+		while (newMax < numRecords + add) newMax *= 2;
+		unsigned char* grown = realloc(records, (size_t)newMax * RECORD_SIZE);
+		if (grown == NULL) return -1;
+		records = grown;
+		maxRecords = newMax;
+	}
+	memcpy(&records[numRecords * RECORD_SIZE], bytes, add * RECORD_SIZE);
+	numRecords += add;
+	return 0;
+}
+
+static uint32_t ReadLE32(const unsigned char* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void EmitEvent(const char* format, ...)
+{
+	va_list args;
+	printf("%s\n  ", firstEvent ? "" : ",");
+	firstEvent = 0;
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+}
+
+static const char* TaskName(unsigned int task)
+{
+	static char fallback[32];
+	if (task < MAX_TASKS && taskNames[task][0] != 0) return taskNames[task];
+	snprintf(fallback, sizeof(fallback), "task %u", task);
+	return fallback;
+}
+
+static void WriteTimeline(void)
+{
+	uint64_t now = 0;
+	uint32_t last = 0;
+	int running = -1;
+	double runningSince = 0.0;
+
+	printf("{\"traceEvents\": [");
+	for (unsigned int t = 0; t < MAX_TASKS; t++)
+	{
+		if (taskNames[t][0] != 0)
+		{
+			EmitEvent("{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+					t, taskNames[t]);
+		}
+	}
+	EmitEvent("{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"ISR\"}}", ISR_TID);
+
+	for (unsigned int i = 0; i < numRecords; i++)
+	{
+		const unsigned char* r = &records[i * RECORD_SIZE];
+		uint32_t stamp = ReadLE32(&r[0]);
+		unsigned int type = r[4];
+		unsigned int task = r[5];
+		uint32_t value = ReadLE32(&r[8]);
+
+		// CYCCNT ist 32 Bit breit, zwischen zwei Records duerfen hoechstens 2^32 Zyklen (ca. 20 s) liegen
+		now = (i == 0) ? stamp : now + (uint32_t)(stamp - last);
+		last = stamp;
+		double us = (double)now / cyclesPerUs;
+
+		switch (type)
+		{
+		case TRACE_TASK_IN:
+			if (running >= 0)
+			{
+				EmitEvent("{\"ph\": \"X\", \"name\": \"%s\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+						TaskName((unsigned int)running), running, runningSince, us - runningSince);
+			}
+			running = (int)value;
+			runningSince = us;
+			break;
+		case TRACE_QUEUE_SEND:
+		case TRACE_QUEUE_RECEIVE:
+		case TRACE_SEM_GIVE:
+		case TRACE_SEM_TAKE:
+		{
+			static const char* const names[] = { "queue send", "queue receive", "give", "take" };
+			EmitEvent("{\"ph\": \"i\", \"s\": \"t\", \"name\": \"%s\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, "
+					"\"args\": {\"object\": \"0x%08x\"}}", names[type - TRACE_QUEUE_SEND], task, us, value);
+			break;
+		}
+		case TRACE_ISR_ENTER:
+			EmitEvent("{\"ph\": \"B\", \"name\": \"IRQ %d\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f}",
+					(int)value - 16, ISR_TID, us);
+			break;
+		case TRACE_ISR_EXIT:
+			EmitEvent("{\"ph\": \"E\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f}", ISR_TID, us);
+			break;
+		case TRACE_CONSOLE_BEGIN:
+		{
+			char name[5] = { (char)value, (char)(value >> 8), (char)(value >> 16), (char)(value >> 24), 0 };
+			EmitEvent("{\"ph\": \"B\", \"name\": \"%s\", \"cat\": \"console\", \"pid\": 2, \"tid\": %u, \"ts\": %.3f}",
+					name, task, us);
+			break;
+		}
+		case TRACE_CONSOLE_END:
+			EmitEvent("{\"ph\": \"E\", \"pid\": 2, \"tid\": %u, \"ts\": %.3f, \"args\": {\"result\": %d}}", task, us,
+					(int)value);
+			break;
+		default:
+		{
+			const char* name = (type == TRACE_STEPPER_START) ? "stepper start" :
+					(type == TRACE_STEPPER_DONE) ? "stepper done" :
+					(type == TRACE_STEPPER_CANCEL) ? "stepper cancel" :
+					(type == TRACE_SPINDLE_DUTY) ? "spindle duty" :
+					(type == TRACE_SPINDLE_DIR) ? "spindle direction" : "unknown";
+			EmitEvent("{\"ph\": \"i\", \"s\": \"t\", \"name\": \"%s\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, "
+					"\"args\": {\"type\": %u, \"value\": %d}}", name, task, us, type, (int)value);
+			break;
+		}
+		}
+	}
+	printf("\n], \"displayTimeUnit\": \"ns\"}\n");
+}
+
+int main(int argc, char** argv)
+{
+	FILE* in = stdin;
+	if (argc > 1 && (in = fopen(argv[1], "r")) == NULL)
+	{
+		fprintf(stderr, "can not open %s\n", argv[1]);
+		return 1;
+	}
+
+	char line[LINE_SIZE];
+	int inBlock = 0;
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		// die Records koennen hinter einem Prompt oder Echo in der Zeile stehen
+		char* p = strstr(line, "#T,");
+		if (p == NULL) continue;
+
+		if (strncmp(p, "#T,B,", 5) == 0)
+		{
+			unsigned long hz = 0;
+			// nur der letzte Block einer Datei wird ausgewertet
+			if (sscanf(p + 5, "%lu", &hz) == 1 && hz > 0) cyclesPerUs = (double)hz / 1000000.0;
+			memset(taskNames, 0, sizeof(taskNames));
+			numRecords = 0;
+			inBlock = 1;
+		}
+		else if (inBlock && strncmp(p, "#T,N,", 5) == 0)
+		{
+			unsigned int number = 0;
+			char name[32];
+			if (sscanf(p + 5, "%u,%31[^\r\n]", &number, name) == 2 && number < MAX_TASKS)
+			{
+				strcpy(taskNames[number], name);
+			}
+		}
+		else if (inBlock && strncmp(p, "#T,D,", 5) == 0)
+		{
+			if (DecodeLine(p + 5) != 0)
+			{
+				fprintf(stderr, "invalid record line: %s", p);
+			}
+		}
+		else if (strncmp(p, "#T,E", 4) == 0)
+		{
+			inBlock = 0;
+		}
+	}
+
+	if (in != stdin) fclose(in);
+	if (numRecords == 0)
+	{
+		fprintf(stderr, "no trace block found\n");
+		return 1;
+	}
+
+	WriteTimeline();
+	free(records);
+	return 0;
+}
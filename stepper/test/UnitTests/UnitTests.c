@@ -0,0 +1,211 @@
+
+// standard includes for the unit test framework
+#include <stdio.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <stdint.h>
+#include <math.h>
+
+// includes of the tested modules, they do not depend on FreeRTOS or the HAL
+#include "Stepper_implementation/my_motion.h"
+#include "Stepper_implementation/my_rate.h"
+
+
+// ====================================================================================================================
+// area of state helpers and mockup functions
+// ====================================================================================================================
+
+// the worker task handles of the console are only compared, so any two distinct addresses will do
+static int workerA;
+static int workerB;
+static int consoleTask;
+
+static char* moveArgs[]      = { "move", "10" };
+static char* referenceArgs[] = { "reference" };
+static char* statusArgs[]    = { "status" };
+static char* cancelArgs[]    = { "cancel" };
+static char* positionArgs[]  = { "position" };
+static char* resetArgs[]     = { "reset" };
+
+
+// ====================================================================================================================
+// area of test functions
+// ====================================================================================================================
+
+// --------------------------------------------------------------------------------------------------------------------
+static void motion_command_detection(void** state)
+// --------------------------------------------------------------------------------------------------------------------
+{
+    (void)state;
+    assert_int_equal(Motion_IsMotionCommand(2, moveArgs), 1);
+    assert_int_equal(Motion_IsMotionCommand(1, referenceArgs), 1);
+    assert_int_equal(Motion_IsMotionCommand(1, statusArgs), 0);
+    assert_int_equal(Motion_IsMotionCommand(1, cancelArgs), 0);
+    assert_int_equal(Motion_IsMotionCommand(0, NULL), 0);
+}
+
+// two "stepper move" jobs started back to back on both workers, the second one must be rejected and must not be
+// able to take over the motion while the first one sleeps with the driver lock released
+// --------------------------------------------------------------------------------------------------------------------
+static void two_motion_jobs_back_to_back(void** state)
+// --------------------------------------------------------------------------------------------------------------------
+{
+    (void)state;
+    assert_int_equal(Motion_Acquire(&workerA), 0);
+    assert_ptr_equal(Motion_GetOwner(), &workerA);
+
+    // second job on the other worker, a move and a reference run are both rejected
+    assert_int_equal(Motion_Acquire(&workerB), -1);
+    assert_int_equal(Motion_Acquire(&workerB), -1);
+    assert_ptr_equal(Motion_GetOwner(), &workerA);
+
+    // the rejected job releases what it never got, this must not free the motion of the first job
+    Motion_Release(&workerB);
+    assert_ptr_equal(Motion_GetOwner(), &workerA);
+
+    // the first job ends, now the next motion can start
+    Motion_Release(&workerA);
+    assert_null(Motion_GetOwner());
+    assert_int_equal(Motion_Acquire(&workerB), 0);
+    Motion_Release(&workerB);
+    assert_null(Motion_GetOwner());
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void only_status_and_cancel_during_motion(void** state)
+// --------------------------------------------------------------------------------------------------------------------
+{
+    (void)state;
+    assert_int_equal(Motion_IsAllowed(1, positionArgs, &consoleTask), 1);
+    assert_int_equal(Motion_Acquire(&workerA), 0);
+
+    assert_int_equal(Motion_IsAllowed(1, statusArgs,   &consoleTask), 1);
+    assert_int_equal(Motion_IsAllowed(1, cancelArgs,   &consoleTask), 1);
+    assert_int_equal(Motion_IsAllowed(1, positionArgs, &consoleTask), 0);
+    assert_int_equal(Motion_IsAllowed(1, resetArgs,    &workerB),     0);
+
+    // the owner itself is not blocked by its own motion
+    assert_int_equal(Motion_IsAllowed(1, positionArgs, &workerA), 1);
+
+    Motion_Release(&workerA);
+    assert_int_equal(Motion_IsAllowed(1, resetArgs, &consoleTask), 1);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void null_owner_is_rejected(void** state)
+// --------------------------------------------------------------------------------------------------------------------
+{
+    (void)state;
+    assert_int_equal(Motion_Acquire(NULL), -1);
+    assert_null(Motion_GetOwner());
+}
+
+
+// the timer values of one rate must give the rate back within the resolution of ARR
+// --------------------------------------------------------------------------------------------------------------------
+static void rate_prescaler_covers_range(void** state)
+// --------------------------------------------------------------------------------------------------------------------
+{
+    (void)state;
+    for (float rate = 10.0f; rate <= 50000.0f; rate *= 1.37f)
+    {
+        uint32_t prescaler = Rate_Prescaler(rate * RATE_RANGE_FACTOR);
+        uint32_t arr = 0;
+        assert_int_equal(Rate_Reload(rate, prescaler, &arr), 0);
+        assert_true(fabsf(Rate_Achieved(prescaler, arr) - rate) / rate < 0.001f);
+        assert_int_equal(Rate_Reload(rate * RATE_RANGE_FACTOR * 1.01f, prescaler, &arr), 0);
+    }
+}
+
+// model of a sync move: the spindle slows down from 3000 to 100 rpm and speeds up again, every SYNC period of 5 ms
+// the rate is tracked like StepperSync does it. The steps of the timer are integrated over the time and compared
+// with the revolutions of the spindle, the feed per revolution must stay within 0.1 %
+// --------------------------------------------------------------------------------------------------------------------
+static void rate_tracks_spindle_slowdown(void** state)
+// --------------------------------------------------------------------------------------------------------------------
+{
+    (void)state;
+    const float steps_per_rev = 800.0f; // 1 mm feed per revolution with 4 mm per turn and 3200 microsteps
+    const double period = 0.005;
+    double revolutions = 0.0;
+    double steps = 0.0;
+    int reprepared = 0;
+
+    float rpm = 3000.0f;
+    float rate = rpm / 60.0f * steps_per_rev;
+    uint32_t prescaler = Rate_Prescaler(rate * RATE_RANGE_FACTOR);
+    uint32_t arr = 0;
+    assert_int_equal(Rate_Track(rate, &prescaler, &arr), 0);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        // 5 s down to 100 rpm, 5 s back up, both exponential like a loaded spindle
+        double t = i * period;
+        rpm = (t < 5.0) ? (float)(3000.0 * pow(100.0 / 3000.0, t / 5.0)) : (float)(100.0 * pow(30.0, (t - 5.0) / 5.0));
+        rate = rpm / 60.0f * steps_per_rev;
+
+        int result = Rate_Track(rate, &prescaler, &arr);
+        assert_true(result >= 0);
+        reprepared += (result == 1);
+
+        float achieved = Rate_Achieved(prescaler, arr);
+        assert_true(fabsf(achieved - rate) / rate < 0.001f);
+
+        revolutions += rpm / 60.0 * period;
+        steps += achieved * period;
+    }
+
+    // the old fixed prescaler would have stopped following below 750 rpm, the new one is chosen again on the way
+    assert_true(reprepared >= 2);
+    assert_true(fabs(steps / revolutions - steps_per_rev) / steps_per_rev < 0.001);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+static void rate_not_possible(void** state)
+// --------------------------------------------------------------------------------------------------------------------
+{
+    (void)state;
+    uint32_t prescaler = Rate_Prescaler(1000.0f);
+    uint32_t arr = 0;
+    assert_int_equal(Rate_Track(0.0f, &prescaler, &arr), -1);
+    assert_int_equal(Rate_Track(0.001f, &prescaler, &arr), -1);
+}
+
+
+// ====================================================================================================================
+// area of main entry point and test execution as well as its corresponding variables
+// ====================================================================================================================
+
+// motion ownership between the console job workers
+// --------------------------------------------------------------------------------------------------------------------
+const struct CMUnitTest motion_tests[] = {
+    cmocka_unit_test(motion_command_detection),
+    cmocka_unit_test(two_motion_jobs_back_to_back),
+    cmocka_unit_test(only_status_and_cancel_during_motion),
+    cmocka_unit_test(null_owner_is_rejected),
+};
+
+// timer values for the variable rate of stepper sync
+// --------------------------------------------------------------------------------------------------------------------
+const struct CMUnitTest rate_tests[] = {
+    cmocka_unit_test(rate_prescaler_covers_range),
+    cmocka_unit_test(rate_tracks_spindle_slowdown),
+    cmocka_unit_test(rate_not_possible),
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+int main()
+// --------------------------------------------------------------------------------------------------------------------
+{
+    int result = 0;
+    cmocka_set_message_output(CM_OUTPUT_STDOUT);
+    result |= cmocka_run_group_tests(motion_tests, NULL, NULL);
+    result |= cmocka_run_group_tests(rate_tests,   NULL, NULL);
+    return result;
+}